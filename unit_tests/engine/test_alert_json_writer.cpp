@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <engine/alert_json_writer.h>
+
+static std::string write_string(const std::string& s) {
+	std::string out;
+	EXPECT_TRUE(alert_json_writer::write_string(out, s));
+	return out;
+}
+
+TEST(AlertJsonWriter, write_string_as_nlohmann) {
+	std::vector<std::string> strings = {
+	        "",
+	        "plain",
+	        "quote \" backslash \\ slash /",
+	        "\b\f\n\r\t",
+	        std::string("\x00\x01\x1f\x7f", 4),
+	        "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80",
+	};
+	for(const auto& s : strings) {
+		EXPECT_EQ(write_string(s), nlohmann::json(s).dump());
+	}
+
+	std::vector<std::string> invalid = {
+	        "\xc3",
+	        "\xc0\xaf",
+	        "\xed\xa0\x80",
+	        "\xf4\x90\x80\x80",
+	        "\xff",
+	};
+	for(const auto& s : invalid) {
+		std::string out;
+		EXPECT_FALSE(alert_json_writer::write_string(out, s));
+		EXPECT_ANY_THROW(nlohmann::json(s).dump());
+	}
+}
+
+TEST(AlertJsonWriter, write_fields_as_nlohmann) {
+	std::string message_fields =
+	        R"({"proc.name":"bash","proc.pid":1234,"fd.num":-1,"evt.arg.ratio":0.5,)"
+	        R"("proc.aname":["sh","bash\n",null,[1,2]],"user.uid":null,"evt.is_open":true,)"
+	        R"("fd.name":"\u0001é","proc.name":"zsh"})";
+	std::string prefix_fields = R"({"evt.time":1700000000000000000,"proc.pid":1})";
+	std::string raw_field = R"({"proc.cmdline":"cat /etc/shadow","other":1})";
+
+	alert_json_writer writer;
+	ASSERT_TRUE(writer.add_json_fields(message_fields));
+	ASSERT_TRUE(writer.add_json_fields(prefix_fields));
+	ASSERT_TRUE(writer.add_json_field("proc.cmdline", raw_field));
+	ASSERT_TRUE(writer.add_json_field("missing", raw_field));
+	ASSERT_TRUE(writer.add_string_field("static", "some \"value\""));
+	ASSERT_TRUE(writer.add_string_field("evt.time", "overridden"));
+	std::string out;
+	ASSERT_TRUE(writer.write_fields(out));
+
+	nlohmann::json expected = nlohmann::json::parse(message_fields);
+	auto prefix = nlohmann::json::parse(prefix_fields);
+	for(const auto& el : prefix.items()) {
+		expected[el.key()] = el.value();
+	}
+	auto raw = nlohmann::json::parse(raw_field);
+	expected["proc.cmdline"] = raw["proc.cmdline"];
+	expected["missing"] = raw["missing"];
+	expected["static"] = "some \"value\"";
+	expected["evt.time"] = "overridden";
+	EXPECT_EQ(out, expected.dump());
+
+	// The fields are forgotten, but their buffers reused
+	writer.clear_fields();
+	out.clear();
+	ASSERT_TRUE(writer.add_json_fields("{}"));
+	ASSERT_TRUE(writer.write_fields(out));
+	EXPECT_EQ(out, "{}");
+}
+
+TEST(AlertJsonWriter, rejects_unsupported_fields) {
+	alert_json_writer writer;
+	EXPECT_FALSE(writer.add_json_fields(""));
+	EXPECT_FALSE(writer.add_json_fields("null"));
+	EXPECT_FALSE(writer.add_json_fields("[1,2]"));
+	EXPECT_FALSE(writer.add_json_fields(R"({"a":1)"));
+	EXPECT_FALSE(writer.add_json_fields(R"({"a":{"c":1,"b":2}})"));
+	EXPECT_FALSE(writer.add_json_field("a", "1"));
+	EXPECT_FALSE(writer.add_string_field("a", "\xff"));
+}
@@ -18,6 +18,8 @@ limitations under the License.
 #include <gtest/gtest.h>
 #include <engine/falco_utils.h>
 
+#include <zlib.h>
+
 TEST(FalcoUtils, is_unix_scheme) {
 	/* Wrong prefix */
 	ASSERT_EQ(falco::utils::network::is_unix_scheme("something:///run/falco/falco.sock"), false);
@@ -102,3 +104,35 @@ TEST(FalcoUtils, matches_wildcard) {
 	ASSERT_FALSE(falco::utils::matches_wildcard("*hello*world", "come on hello this world yes"));
 	ASSERT_FALSE(falco::utils::matches_wildcard("*hello*world*", "come on hello this yes"));
 }
+
+TEST(FalcoUtils, gzip_compress) {
+	std::string in;
+	for(int i = 0; i < 1000; i++) {
+		in += "falco event " + std::to_string(i) + "\n";
+	}
+
+	std::string out;
+	ASSERT_TRUE(falco::utils::gzip_compress(in, out));
+	ASSERT_GT(out.size(), 2u);
+	ASSERT_LT(out.size(), in.size());
+
+	// gzip magic number
+	ASSERT_EQ(static_cast<uint8_t>(out[0]), 0x1f);
+	ASSERT_EQ(static_cast<uint8_t>(out[1]), 0x8b);
+
+	z_stream zs{};
+	ASSERT_EQ(inflateInit2(&zs, 15 + 16), Z_OK);
+	std::string decompressed(in.size(), '\0');
+	zs.next_in = reinterpret_cast<Bytef*>(out.data());
+	zs.avail_in = static_cast<uInt>(out.size());
+	zs.next_out = reinterpret_cast<Bytef*>(decompressed.data());
+	zs.avail_out = static_cast<uInt>(decompressed.size());
+	int ret = inflate(&zs, Z_FINISH);
+	decompressed.resize(zs.total_out);
+	inflateEnd(&zs);
+	ASSERT_EQ(ret, Z_STREAM_END);
+	ASSERT_EQ(decompressed, in);
+
+	ASSERT_TRUE(falco::utils::gzip_compress("", out));
+	ASSERT_FALSE(out.empty());
+}
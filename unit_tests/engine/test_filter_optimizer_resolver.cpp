@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <engine/filter_optimizer_resolver.h>
+
+namespace filter_ast = libsinsp::filter::ast;
+
+static std::string optimize(const std::string& condition, bool expect_changed = true) {
+	std::shared_ptr<filter_ast::expr> ast = libsinsp::filter::parser(condition).parse();
+	EXPECT_EQ(filter_optimizer_resolver().run(ast), expect_changed) << condition;
+	return filter_ast::as_string(ast.get());
+}
+
+TEST(OptimizerResolver, flattens_and_removes_duplicates) {
+	ASSERT_EQ(optimize("evt.type = open and (proc.name = a and (fd.num > 0 and proc.name = a))"),
+	          "(evt.type = open and proc.name = a and fd.num > 0)");
+	ASSERT_EQ(optimize("proc.name = a or (proc.name = b or proc.name = a)"),
+	          "(proc.name = a or proc.name = b)");
+	ASSERT_EQ(optimize("evt.type = open and not not proc.name = a"),
+	          "(evt.type = open and proc.name = a)");
+	ASSERT_EQ(optimize("proc.name = a or proc.name = a"), "proc.name = a");
+}
+
+TEST(OptimizerResolver, sorts_and_by_cost) {
+	ASSERT_EQ(optimize("proc.cmdline regex x and container.id != host and proc.name = a and "
+	                   "evt.type = open"),
+	          "(evt.type = open and proc.name = a and container.id != host and proc.cmdline "
+	          "regex x)");
+
+	// or children are never reordered
+	ASSERT_EQ(optimize("(proc.cmdline glob x or evt.type = open) and proc.aname = b"),
+	          "(proc.aname = b and (proc.cmdline glob x or evt.type = open))");
+}
+
+TEST(OptimizerResolver, keeps_optimal_conditions) {
+	std::string condition = "(evt.type = open and proc.name = a)";
+	ASSERT_EQ(optimize(condition, false), condition);
+}
+
+TEST(OptimizerResolver, estimates_cost) {
+	auto cost = [](const std::string& condition) {
+		auto ast = libsinsp::filter::parser(condition).parse();
+		return filter_optimizer_resolver::estimate_cost(ast.get());
+	};
+	ASSERT_LT(cost("evt.type = open"), cost("proc.name = a"));
+	ASSERT_LT(cost("proc.name = a"), cost("proc.name contains a"));
+	ASSERT_LT(cost("proc.name contains a"), cost("proc.name glob a*"));
+	ASSERT_LT(cost("proc.name = a"), cost("k8s.ns.name = a"));
+	ASSERT_LT(cost("proc.name = a"), cost("proc.aname = a"));
+	ASSERT_LT(cost("proc.name = a"), cost("proc.aname[2] = a"));
+	ASSERT_EQ(cost("proc.name = a"), cost("proc.args = a"));
+	ASSERT_LT(cost("proc.name = a"), cost("toupper(proc.name) = A"));
+}
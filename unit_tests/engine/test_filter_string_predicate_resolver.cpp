@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <re2/re2.h>
+#include <engine/filter_string_predicate_resolver.h>
+
+namespace filter_ast = libsinsp::filter::ast;
+
+static bool fold(std::unique_ptr<filter_ast::expr>& ast, const std::string& condition) {
+	ast = libsinsp::filter::parser(condition).parse();
+	return filter_string_predicate_resolver().run(*ast.get());
+}
+
+TEST(StringPredicateResolver, folds_comparisons_on_same_field) {
+	std::unique_ptr<filter_ast::expr> ast;
+	ASSERT_TRUE(fold(ast,
+	                 "evt.type = execve and (proc.cmdline contains xmrig or proc.name = sh or "
+	                 "proc.cmdline startswith \"/tmp/\" or proc.cmdline contains a.b or "
+	                 "proc.cmdline endswith .sh)"));
+
+	auto and_expr = dynamic_cast<filter_ast::and_expr*>(ast.get());
+	ASSERT_NE(and_expr, nullptr);
+	auto or_expr = dynamic_cast<filter_ast::or_expr*>(and_expr->children[1].get());
+	ASSERT_NE(or_expr, nullptr);
+	ASSERT_EQ(or_expr->children.size(), 2);
+
+	auto folded = dynamic_cast<filter_ast::binary_check_expr*>(or_expr->children[0].get());
+	ASSERT_NE(folded, nullptr);
+	ASSERT_EQ(folded->op, "regex");
+	ASSERT_EQ(filter_ast::as_string(folded->left.get()), "proc.cmdline");
+	auto pattern = dynamic_cast<filter_ast::value_expr*>(folded->right.get());
+	ASSERT_NE(pattern, nullptr);
+
+	RE2 re(pattern->value);
+	ASSERT_TRUE(re.ok()) << pattern->value;
+	EXPECT_TRUE(RE2::FullMatch("./xmrig --donate-level 1", re));
+	EXPECT_TRUE(RE2::FullMatch("/tmp/payload", re));
+	EXPECT_TRUE(RE2::FullMatch("cat a.b", re));
+	EXPECT_TRUE(RE2::FullMatch("bash install.sh", re));
+	EXPECT_TRUE(RE2::FullMatch("\xff\xfexmrig\n", re));
+	EXPECT_FALSE(RE2::FullMatch("cat aXb", re));
+	EXPECT_FALSE(RE2::FullMatch("/var/tmp/payload", re));
+	EXPECT_FALSE(RE2::FullMatch("bash install.sh.bak", re));
+	EXPECT_FALSE(RE2::PartialMatch("bash install.sh.bak", re));
+
+	auto other = dynamic_cast<filter_ast::binary_check_expr*>(or_expr->children[1].get());
+	ASSERT_NE(other, nullptr);
+	ASSERT_EQ(other->op, "=");
+}
+
+TEST(StringPredicateResolver, keeps_small_groups) {
+	std::unique_ptr<filter_ast::expr> ast;
+	std::string condition =
+	        "proc.cmdline contains a or proc.cmdline contains b or proc.cmdline contains c or "
+	        "proc.name contains d";
+	ASSERT_FALSE(fold(ast, condition));
+	ASSERT_EQ(filter_ast::as_string(ast.get()),
+	          filter_ast::as_string(libsinsp::filter::parser(condition).parse().get()));
+
+	ASSERT_FALSE(fold(ast,
+	                  "proc.cmdline contains a and proc.cmdline contains b and "
+	                  "proc.cmdline contains c and proc.cmdline contains d"));
+}
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+
+#include "../test_falco_engine.h"
+#include "formats.h"
+
+static std::string s_formatter_cache_rules = R"END(
+- rule: legit_rule
+  desc: legit rule description
+  condition: evt.type=open
+  output: user=%user.name command=%proc.cmdline file=%fd.name
+  priority: INFO
+)END";
+
+TEST_F(test_falco_engine, formatter_cache_after_loading) {
+	m_engine->add_extra_output_formatted_field("proc_pid", "%proc.pid", "", {}, "");
+	ASSERT_TRUE(load_rules(s_formatter_cache_rules, "legit_rules.yaml")) << m_load_result_string;
+	m_engine->complete_rule_loading();
+
+	auto message_format =
+	        falco_formats::lenient_format("user=%user.name command=%proc.cmdline file=%fd.name");
+	auto prefix_format = falco_formats::prefix_format(
+	        falco_common::format_priority(falco_common::PRIORITY_INFORMATIONAL),
+	        false);
+	auto extra_format = falco_formats::lenient_format("%proc.pid");
+
+	auto hits = m_engine->get_formatter_cache_hits();
+	auto misses = m_engine->get_formatter_cache_misses();
+
+	auto f1 = m_engine->create_formatter(m_sample_source, message_format);
+	auto f2 = m_engine->create_formatter(m_sample_source, message_format);
+	EXPECT_EQ(f1.get(), f2.get());
+	m_engine->create_formatter(m_sample_source, prefix_format);
+	m_engine->create_formatter(m_sample_source, extra_format);
+	EXPECT_EQ(m_engine->get_formatter_cache_hits(), hits + 4);
+	EXPECT_EQ(m_engine->get_formatter_cache_misses(), misses);
+
+	m_engine->create_formatter(m_sample_source, "*%evt.num");
+	EXPECT_EQ(m_engine->get_formatter_cache_hits(), hits + 4);
+	EXPECT_EQ(m_engine->get_formatter_cache_misses(), misses + 1);
+}
+
+TEST_F(test_falco_engine, formatter_cache_cleared_on_reload) {
+	ASSERT_TRUE(load_rules(s_formatter_cache_rules, "legit_rules.yaml")) << m_load_result_string;
+	m_engine->complete_rule_loading();
+
+	// rules are not yet marked as fully loaded after a reload
+	ASSERT_TRUE(load_rules(s_formatter_cache_rules, "legit_rules.yaml")) << m_load_result_string;
+	auto misses = m_engine->get_formatter_cache_misses();
+	m_engine->create_formatter(
+	        m_sample_source,
+	        falco_formats::lenient_format("user=%user.name command=%proc.cmdline file=%fd.name"));
+	EXPECT_EQ(m_engine->get_formatter_cache_misses(), misses + 1);
+}
@@ -0,0 +1,434 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+
+#include "../test_falco_engine.h"
+#include <engine/evttype_index_ruleset.h>
+
+#include <algorithm>
+
+class test_rule_evaluation : public test_falco_engine {
+protected:
+	// Creates an event of the given type with a single fd parameter,
+	// numbered after the ones created before it. The events are owned
+	// by the fixture.
+	sinsp_evt* add_event(ppm_event_code type, int64_t fd) {
+		char error[SCAP_LASTERR_SIZE];
+		scap_evt* raw = scap_create_event(error, 0, 1, type, 1, fd);
+		if(raw == nullptr) {
+			throw std::runtime_error(error);
+		}
+		m_raw_events.emplace_back(raw, free);
+
+		auto evt = std::make_unique<sinsp_evt>(&m_inspector);
+		evt->set_scap_evt(raw);
+		evt->set_info(&scap_get_event_info_table()[type]);
+		evt->set_cpuid(0);
+		evt->set_num(m_events.size() + 1);
+		m_events.push_back(std::move(evt));
+		return m_events.back().get();
+	}
+
+	// Returns the name of the first rule matching the event
+	std::string first_match(sinsp_evt* evt) {
+		auto res = m_engine->process_event(m_sample_source_idx,
+		                                   evt,
+		                                   m_engine->find_ruleset_id(m_sample_ruleset),
+		                                   falco_common::rule_matching::FIRST);
+		return res ? res->at(0).rule : "";
+	}
+
+	// Enables the given rules one by one, so that they are evaluated in
+	// this order rather than in the one of the enabled rules set
+	void enable_in_order(const std::vector<std::string>& names) {
+		m_engine->enable_rule("", false, m_sample_ruleset);
+		for(const auto& name : names) {
+			m_engine->enable_rule_exact(name, true, m_sample_ruleset);
+		}
+	}
+
+	std::vector<std::unique_ptr<scap_evt, decltype(&free)>> m_raw_events;
+	std::vector<std::unique_ptr<sinsp_evt>> m_events;
+};
+
+static std::string s_overlapping_rules = R"END(
+- rule: fd_one
+  desc: matches the events on fd 1
+  condition: evt.type=close and evt.rawarg.fd=1
+  output: fd=%evt.rawarg.fd
+  priority: INFO
+
+- rule: any_fd
+  desc: matches the events on any fd
+  condition: evt.type=close and evt.rawarg.fd>0
+  output: fd=%evt.rawarg.fd
+  priority: INFO
+)END";
+
+TEST_F(test_rule_evaluation, adaptive_ordering_reorders_rules) {
+	filter_ruleset::adaptive_ordering_config config;
+	config.enabled = true;
+	config.sampling_ratio = 1;
+	config.reorder_interval = 100;
+	m_engine->set_adaptive_rule_ordering(config);
+
+	ASSERT_TRUE(load_rules(s_overlapping_rules, "rules.yaml")) << m_load_result_string;
+	enable_in_order({"fd_one", "any_fd"});
+	m_engine->complete_rule_loading();
+
+	// both rules match, the first defined one is reported
+	ASSERT_EQ(first_match(add_event(PPME_SYSCALL_CLOSE_E, 1)), "fd_one");
+
+	// only any_fd matches, until the bucket gets reordered
+	for(int i = 0; i < 99; i++) {
+		ASSERT_EQ(first_match(add_event(PPME_SYSCALL_CLOSE_E, 2)), "any_fd");
+	}
+	EXPECT_EQ(m_engine->get_adaptive_rule_ordering_stats().num_reorders, 1);
+
+	// any_fd is now evaluated first, and is reported instead
+	ASSERT_EQ(first_match(add_event(PPME_SYSCALL_CLOSE_E, 1)), "any_fd");
+}
+
+TEST_F(test_rule_evaluation, adaptive_ordering_disabled) {
+	ASSERT_TRUE(load_rules(s_overlapping_rules, "rules.yaml")) << m_load_result_string;
+	enable_in_order({"fd_one", "any_fd"});
+	m_engine->complete_rule_loading();
+
+	ASSERT_EQ(first_match(add_event(PPME_SYSCALL_CLOSE_E, 1)), "fd_one");
+	for(int i = 0; i < 99; i++) {
+		ASSERT_EQ(first_match(add_event(PPME_SYSCALL_CLOSE_E, 2)), "any_fd");
+	}
+	EXPECT_EQ(m_engine->get_adaptive_rule_ordering_stats().num_reorders, 0);
+	ASSERT_EQ(first_match(add_event(PPME_SYSCALL_CLOSE_E, 1)), "fd_one");
+}
+
+TEST_F(test_rule_evaluation, profiling_fills_buckets) {
+	m_engine->set_rule_profiling(2);
+
+	ASSERT_TRUE(load_rules(s_overlapping_rules, "rules.yaml")) << m_load_result_string;
+	m_engine->complete_rule_loading();
+
+	// looking for all the matches, every rule is evaluated on each event
+	for(int i = 0; i < 10; i++) {
+		auto res = m_engine->process_event(m_sample_source_idx,
+		                                   add_event(PPME_SYSCALL_CLOSE_E, 2),
+		                                   m_engine->find_ruleset_id(m_sample_ruleset),
+		                                   falco_common::rule_matching::ALL);
+		ASSERT_NE(res, nullptr);
+	}
+
+	const auto& profiles = m_engine->get_rule_stats_manager().get_profile_by_rule_id();
+	for(const auto& name : {"fd_one", "any_fd"}) {
+		const auto& profile = *profiles.at(m_engine->get_rules().at(name)->id);
+		uint64_t num_bucketed = 0;
+		for(const auto& bucket : profile.buckets) {
+			num_bucketed += bucket.load();
+		}
+		EXPECT_EQ(profile.num_evals.load(), 5) << name;
+		EXPECT_EQ(num_bucketed, 5) << name;
+	}
+}
+
+TEST_F(test_rule_evaluation, profiling_disabled) {
+	ASSERT_TRUE(load_rules(s_overlapping_rules, "rules.yaml")) << m_load_result_string;
+	m_engine->complete_rule_loading();
+
+	for(int i = 0; i < 10; i++) {
+		first_match(add_event(PPME_SYSCALL_CLOSE_E, 2));
+	}
+
+	for(const auto& profile : m_engine->get_rule_stats_manager().get_profile_by_rule_id()) {
+		EXPECT_EQ(profile->num_evals.load(), 0);
+	}
+}
+
+static std::string s_fd_rules = R"END(
+- rule: fd_low
+  desc: matches the events on the lowest fds
+  condition: evt.type in (close, dup) and evt.rawarg.fd < 2
+  output: fd=%evt.rawarg.fd
+  priority: INFO
+
+- rule: fd_even
+  desc: matches the events on even fds
+  condition: evt.type in (close, dup) and evt.rawarg.fd in (0, 2, 4)
+  output: fd=%evt.rawarg.fd
+  priority: INFO
+
+- rule: fd_dup
+  desc: matches the dup events on any fd but stdin
+  condition: evt.type = dup and evt.rawarg.fd > 0
+  output: fd=%evt.rawarg.fd
+  priority: INFO
+
+- rule: fd_any
+  desc: matches the events of any type on any fd
+  condition: evt.rawarg.fd >= 0
+  output: fd=%evt.rawarg.fd
+  priority: INFO
+)END";
+
+TEST_F(test_rule_evaluation, field_extraction_cache_same_matches) {
+	auto cached_engine = std::make_shared<falco_engine>();
+	auto cached_source_idx =
+	        cached_engine->add_source(m_sample_source, m_filter_factory, m_formatter_factory);
+	cached_engine->set_filter_cache(true);
+	auto res = cached_engine->load_rules(s_fd_rules, "rules.yaml");
+	ASSERT_TRUE(res->successful());
+
+	ASSERT_TRUE(load_rules(s_fd_rules, "rules.yaml")) << m_load_result_string;
+
+	auto matches = [](falco_engine& engine, std::size_t source_idx, sinsp_evt* evt) {
+		std::vector<std::string> names;
+		auto res = engine.process_event(source_idx, evt, falco_common::rule_matching::ALL);
+		if(res) {
+			for(const auto& r : *res) {
+				names.push_back(r.rule);
+			}
+		}
+		// the order of the rules differs between the engines
+		std::sort(names.begin(), names.end());
+		return names;
+	};
+
+	for(int64_t fd = 0; fd < 5; fd++) {
+		for(auto type : {PPME_SYSCALL_CLOSE_E, PPME_SYSCALL_DUP_E}) {
+			auto evt = add_event(type, fd);
+			EXPECT_EQ(matches(*cached_engine, cached_source_idx, evt),
+			          matches(*m_engine, m_sample_source_idx, evt))
+			        << "type=" << type << " fd=" << fd;
+		}
+	}
+
+	// evt.rawarg.fd is extracted once per event, and reused by the
+	// other rules
+	EXPECT_GT(cached_engine->get_filter_cache_metrics().m_num_extract_cache, 0);
+	EXPECT_EQ(m_engine->get_filter_cache_metrics().m_num_extract_cache, 0);
+}
+
+static std::string s_same_field_rules = R"END(
+- rule: fd_low
+  desc: matches the events on the lowest fds
+  condition: evt.rawarg.fd < 2
+  output: fd=%evt.rawarg.fd
+  priority: INFO
+
+- rule: fd_even
+  desc: matches the events on even fds
+  condition: evt.rawarg.fd in (0, 2, 4)
+  output: fd=%evt.rawarg.fd
+  priority: INFO
+
+- rule: fd_any
+  desc: matches the events on any fd
+  condition: evt.rawarg.fd >= 0
+  output: fd=%evt.rawarg.fd
+  priority: INFO
+)END";
+
+TEST_F(test_rule_evaluation, field_extraction_cache_reuses_extractions) {
+	m_engine->set_filter_cache(true);
+	ASSERT_TRUE(load_rules(s_same_field_rules, "rules.yaml")) << m_load_result_string;
+	auto ruleset_id = m_engine->find_ruleset_id(m_sample_ruleset);
+
+	// the three rules are evaluated on each event, and only the first
+	// one actually extracts evt.rawarg.fd
+	for(int64_t fd = 0; fd < 5; fd++) {
+		auto evt = add_event(PPME_SYSCALL_CLOSE_E, fd);
+		auto before = m_engine->get_filter_cache_metrics().m_num_extract_cache;
+		auto res = m_engine->process_event(m_sample_source_idx,
+		                                   evt,
+		                                   ruleset_id,
+		                                   falco_common::rule_matching::ALL);
+		ASSERT_NE(res, nullptr);
+		EXPECT_EQ(m_engine->get_filter_cache_metrics().m_num_extract_cache - before, 2)
+		        << "fd=" << fd;
+
+		// the extracted value is kept for the rest of the event
+		before = m_engine->get_filter_cache_metrics().m_num_extract_cache;
+		m_engine->process_event(m_sample_source_idx,
+		                        evt,
+		                        ruleset_id,
+		                        falco_common::rule_matching::ALL);
+		EXPECT_EQ(m_engine->get_filter_cache_metrics().m_num_extract_cache - before, 3)
+		        << "fd=" << fd;
+	}
+}
+
+TEST_F(test_rule_evaluation, process_events_same_as_process_event) {
+	ASSERT_TRUE(load_rules(s_fd_rules, "rules.yaml")) << m_load_result_string;
+
+	// interleave the event types, so that the batch evaluation order
+	// differs from the order of the events
+	std::vector<sinsp_evt*> evts;
+	for(int64_t fd = 0; fd < 5; fd++) {
+		evts.push_back(add_event(PPME_SYSCALL_DUP_E, fd));
+		evts.push_back(add_event(PPME_SYSCALL_CLOSE_E, 4 - fd));
+	}
+
+	auto ruleset_id = m_engine->find_ruleset_id(m_sample_ruleset);
+	for(auto strategy : {falco_common::rule_matching::FIRST, falco_common::rule_matching::ALL}) {
+		std::vector<std::pair<std::size_t, std::string>> expected;
+		std::vector<const falco_rule*> evt_matches;
+		for(std::size_t i = 0; i < evts.size(); i++) {
+			evt_matches.clear();
+			m_engine->process_event(m_sample_source_idx,
+			                        evts[i],
+			                        ruleset_id,
+			                        strategy,
+			                        evt_matches);
+			for(const auto* rule : evt_matches) {
+				expected.emplace_back(i, rule->name);
+			}
+		}
+
+		std::vector<falco_engine::event_match> matches;
+		ASSERT_EQ(m_engine->process_events(m_sample_source_idx,
+		                                   evts.data(),
+		                                   evts.size(),
+		                                   ruleset_id,
+		                                   strategy,
+		                                   matches),
+		          !expected.empty());
+
+		std::vector<std::pair<std::size_t, std::string>> actual;
+		for(const auto& match : matches) {
+			actual.emplace_back(match.evt_index, match.rule->name);
+		}
+		EXPECT_FALSE(actual.empty());
+		EXPECT_EQ(actual, expected) << "strategy=" << strategy;
+	}
+}
+
+// Leaves the event types of the rules whose name starts with "all_", so
+// that they are evaluated after the event type buckets, for all the events
+class all_event_types_ruleset : public evttype_index_ruleset {
+public:
+	using evttype_index_ruleset::evttype_index_ruleset;
+
+	void add(const falco_rule& rule,
+	         std::shared_ptr<sinsp_filter> filter,
+	         std::shared_ptr<libsinsp::filter::ast::expr> condition) override {
+		if(rule.name.rfind("all_", 0) != 0) {
+			evttype_index_ruleset::add(rule, filter, condition);
+			return;
+		}
+		auto wrap = std::make_shared<evttype_index_wrapper>();
+		wrap->m_rule = rule;
+		wrap->m_filter = filter;
+		add_wrapper(wrap);
+	}
+};
+
+TEST_F(test_rule_evaluation, frozen_same_matches_as_unfrozen) {
+	const std::vector<std::pair<std::string, std::string>> rules = {
+	        {"fd_low", "evt.type in (close, dup) and evt.rawarg.fd < 2"},
+	        {"fd_even", "evt.type in (close, dup) and evt.rawarg.fd in (0, 2, 4)"},
+	        {"fd_dup", "evt.type = dup and evt.rawarg.fd > 0"},
+	        {"all_fd_odd", "evt.rawarg.fd in (1, 3)"},
+	        {"all_fd_any", "evt.rawarg.fd >= 0"},
+	};
+
+	// only the frozen ruleset is profiled, which tells that it
+	// actually evaluates the flat layout
+	uint64_t num_profiled = 0;
+	filter_ruleset::engine_state_funcs engine_state;
+	engine_state.on_rule_evaluated = [&num_profiled](const falco_rule&, uint64_t) {
+		num_profiled++;
+	};
+
+	all_event_types_ruleset frozen(m_filter_factory);
+	all_event_types_ruleset unfrozen(m_filter_factory);
+	frozen.set_engine_state(engine_state);
+	frozen.set_profiling(1);
+	for(auto* ruleset : {&frozen, &unfrozen}) {
+		for(std::size_t i = 0; i < rules.size(); i++) {
+			falco_rule rule;
+			rule.id = i;
+			rule.name = rules[i].first;
+			rule.source = falco_common::syscall_source;
+			libsinsp::filter::parser parser(rules[i].second);
+			std::shared_ptr<libsinsp::filter::ast::expr> ast = parser.parse();
+			sinsp_filter_compiler compiler(m_filter_factory, ast.get());
+			ruleset->add(rule, std::shared_ptr<sinsp_filter>(compiler.compile()), ast);
+		}
+		// the rules are enabled one by one, so that they are evaluated
+		// in the order they are defined
+		for(const auto& rule : rules) {
+			ruleset->enable(rule.first, filter_ruleset::match_type::exact, 0);
+		}
+	}
+	frozen.on_loading_complete();
+
+	std::vector<sinsp_evt*> evts;
+	for(int64_t fd = 0; fd < 5; fd++) {
+		evts.push_back(add_event(PPME_SYSCALL_CLOSE_E, fd));
+		evts.push_back(add_event(PPME_SYSCALL_DUP_E, fd));
+		evts.push_back(add_event(PPME_SYSCALL_FCHDIR_E, fd));
+	}
+
+	auto all_matches = [](filter_ruleset& ruleset, sinsp_evt* evt) {
+		std::vector<const falco_rule*> matches;
+		std::vector<std::string> names;
+		if(ruleset.run(evt, matches, 0)) {
+			for(const auto* rule : matches) {
+				names.push_back(rule->name);
+			}
+		}
+		return names;
+	};
+	auto first_match = [](filter_ruleset& ruleset, sinsp_evt* evt) {
+		const falco_rule* match = nullptr;
+		return ruleset.run(evt, match, 0) ? match->name : "";
+	};
+	auto expect_same_matches = [&](const std::string& step) {
+		for(auto* evt : evts) {
+			EXPECT_EQ(all_matches(frozen, evt), all_matches(unfrozen, evt))
+			        << step << " evt=" << evt->get_num();
+			EXPECT_EQ(first_match(frozen, evt), first_match(unfrozen, evt))
+			        << step << " evt=" << evt->get_num();
+		}
+	};
+
+	// the rules for all the event types are only evaluated when none of
+	// the event type bucket matches
+	EXPECT_EQ(all_matches(frozen, evts[4]), std::vector<std::string>({"fd_low", "fd_dup"}));
+	EXPECT_EQ(all_matches(frozen, evts[5]), std::vector<std::string>({"all_fd_odd", "all_fd_any"}));
+	EXPECT_EQ(all_matches(frozen, evts[9]), std::vector<std::string>({"all_fd_odd", "all_fd_any"}));
+	expect_same_matches("loaded");
+	EXPECT_GT(num_profiled, 0);
+
+	for(auto* ruleset : {&frozen, &unfrozen}) {
+		ruleset->disable("fd_low", filter_ruleset::match_type::exact, 0);
+		ruleset->disable("all_fd_odd", filter_ruleset::match_type::exact, 0);
+	}
+	num_profiled = 0;
+	expect_same_matches("disabled");
+	EXPECT_GT(num_profiled, 0);
+
+	// enabled again, the rules are evaluated after the other ones
+	for(auto* ruleset : {&frozen, &unfrozen}) {
+		ruleset->enable("fd_low", filter_ruleset::match_type::exact, 0);
+		ruleset->enable("all_fd_odd", filter_ruleset::match_type::exact, 0);
+	}
+	EXPECT_EQ(all_matches(frozen, evts[4]), std::vector<std::string>({"fd_dup", "fd_low"}));
+	EXPECT_EQ(all_matches(frozen, evts[9]), std::vector<std::string>({"all_fd_any", "all_fd_odd"}));
+	num_profiled = 0;
+	expect_same_matches("enabled");
+	EXPECT_GT(num_profiled, 0);
+}
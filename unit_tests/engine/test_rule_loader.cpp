@@ -928,6 +928,108 @@ TEST_F(test_falco_engine, exceptions_condition) {
 	          "contains \"curl 127.0.0.1\")");
 }
 
+TEST_F(test_falco_engine, exceptions_condition_prefilter) {
+	std::string rules_content = R"END(
+- rule: test_rule
+  desc: test rule
+  condition: evt.type = open
+  output: command=%proc.cmdline
+  priority: INFO
+  exceptions:
+    - name: test_exception
+      fields: [proc.name, fd.name]
+      comps: [=, =]
+      values:
+        - [p0, /tmp/f0]
+        - [p1, /tmp/f1]
+        - [p2, /tmp/f2]
+        - [p3, /tmp/f3]
+        - [p0, /tmp/f4]
+        - [p1, /tmp/f5]
+        - [p2, /tmp/f6]
+        - [p3, /tmp/f7]
+        - [p0, /tmp/f8]
+        - [p1, /tmp/f9]
+        - [p2, /tmp/f10]
+        - [p3, /tmp/f11]
+        - [p0, /tmp/f12]
+        - [p1, /tmp/f13]
+        - [p2, /tmp/f14]
+        - [p3, /tmp/f15]
+)END";
+
+	ASSERT_TRUE(load_rules(rules_content, "rules.yaml"));
+	ASSERT_VALIDATION_STATUS(yaml_helper::validation_ok) << m_load_result->schema_validation();
+	auto condition = get_compiled_rule_condition("test_rule");
+	EXPECT_NE(condition.find("proc.name in (p0, p1, p2, p3)"), std::string::npos) << condition;
+	EXPECT_NE(condition.find("fd.name in (/tmp/f0, /tmp/f1,"), std::string::npos) << condition;
+	EXPECT_NE(condition.find("proc.name = p3 and fd.name = /tmp/f15"), std::string::npos)
+	        << condition;
+}
+
+TEST_F(test_falco_engine, condition_optimized) {
+	std::string rules_content = R"END(
+- macro: is_shell
+  condition: proc.name = sh and evt.type = execve
+
+- rule: test_rule
+  desc: test rule
+  condition: is_shell and evt.type = execve
+  output: command=%proc.cmdline
+  priority: INFO
+)END";
+
+	m_engine->set_condition_optimizer(true);
+	ASSERT_TRUE(load_rules(rules_content, "rules.yaml"));
+	std::string rule_name = "test_rule";
+	auto details = m_engine->describe_rule(&rule_name, {})["rules"][0]["details"];
+	ASSERT_EQ(details["condition_compiled"].template get<std::string>(),
+	          "((proc.name = sh and evt.type = execve) and evt.type = execve)");
+	ASSERT_EQ(details["condition_optimized"].template get<std::string>(),
+	          "(evt.type = execve and proc.name = sh)");
+}
+
+// Not all the field types support the in operator used by the prefilter,
+// the fields that don't are only evaluated by the original condition
+TEST_F(test_falco_engine, exceptions_condition_prefilter_non_string_fields) {
+	std::string rules_content = R"END(
+- rule: test_rule
+  desc: test rule
+  condition: evt.type = execve
+  output: command=%proc.cmdline
+  priority: INFO
+  exceptions:
+    - name: test_exception
+      fields: [proc.is_exe_writable, proc.pid]
+      comps: [=, =]
+      values:
+        - [true, 100]
+        - [false, 101]
+        - [true, 102]
+        - [false, 103]
+        - [true, 104]
+        - [false, 105]
+        - [true, 106]
+        - [false, 107]
+        - [true, 108]
+        - [false, 109]
+        - [true, 110]
+        - [false, 111]
+        - [true, 112]
+        - [false, 113]
+        - [true, 114]
+        - [false, 115]
+)END";
+
+	ASSERT_TRUE(load_rules(rules_content, "rules.yaml")) << m_load_result_string;
+	ASSERT_VALIDATION_STATUS(yaml_helper::validation_ok) << m_load_result->schema_validation();
+	auto condition = get_compiled_rule_condition("test_rule");
+	EXPECT_NE(condition.find("proc.pid in (100, 101,"), std::string::npos) << condition;
+	EXPECT_NE(condition.find("proc.is_exe_writable = false and proc.pid = 115"),
+	          std::string::npos)
+	        << condition;
+}
+
 TEST_F(test_falco_engine, macro_name_invalid) {
 	std::string rules_content = R"END(
 - macro: test-macro
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+
+// A fixture giving each test an empty directory of its own, removed at the
+// end of the test
+class temp_dir_test : public testing::Test {
+protected:
+	void SetUp() override {
+		auto info = testing::UnitTest::GetInstance()->current_test_info();
+		m_dir = std::filesystem::temp_directory_path() /
+		        ("falco_test_" + std::string(info->test_suite_name()) + "_" + info->name());
+		std::filesystem::remove_all(m_dir);
+		std::filesystem::create_directories(m_dir);
+	}
+
+	void TearDown() override { std::filesystem::remove_all(m_dir); }
+
+	std::filesystem::path m_dir;
+};
@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <falco/alert_throttler.h>
+
+#include <algorithm>
+
+static constexpr uint64_t one_sec = 1000000000;
+
+TEST(AlertThrottler, dedup) {
+	alert_throttler::config config;
+	config.window_ns = 10 * one_sec;
+	config.dedup_enabled = true;
+	alert_throttler t(config);
+
+	std::map<std::string, std::string> a = {{"proc.name", "a"}};
+	std::map<std::string, std::string> b = {{"proc.name", "b"}};
+	auto prio = falco_common::PRIORITY_NOTICE;
+
+	EXPECT_TRUE(t.admit("r1", prio, a, 1 * one_sec));
+	EXPECT_TRUE(t.admit("r1", prio, b, 1 * one_sec));
+	EXPECT_TRUE(t.admit("r2", prio, a, 1 * one_sec));
+	for(int i = 0; i < 5; i++) {
+		EXPECT_FALSE(t.admit("r1", prio, a, 2 * one_sec));
+	}
+	EXPECT_EQ(t.get_num_deduplicated(), 5);
+
+	std::vector<alert_throttler::summary> summaries;
+	t.expire(10 * one_sec, summaries);
+	EXPECT_TRUE(summaries.empty());
+
+	// Only the windows that suppressed alerts are summarized
+	t.expire(11 * one_sec, summaries);
+	ASSERT_EQ(summaries.size(), 1);
+	EXPECT_EQ(summaries[0].rule, "r1");
+	EXPECT_EQ(summaries[0].key_fields, a);
+	EXPECT_EQ(summaries[0].num_suppressed, 5);
+	EXPECT_EQ(summaries[0].ts, 11 * one_sec);
+	EXPECT_EQ(summaries[0].priority, prio);
+
+	// A new window starts with the next alert
+	EXPECT_TRUE(t.admit("r1", prio, a, 12 * one_sec));
+	EXPECT_FALSE(t.admit("r1", prio, a, 13 * one_sec));
+
+	// A window found over when admitting is summarized on the next expire
+	summaries.clear();
+	EXPECT_TRUE(t.admit("r1", prio, a, 30 * one_sec));
+	t.expire(30 * one_sec, summaries);
+	ASSERT_EQ(summaries.size(), 1);
+	EXPECT_EQ(summaries[0].num_suppressed, 1);
+	EXPECT_EQ(summaries[0].ts, 22 * one_sec);
+}
+
+TEST(AlertThrottler, rate_limit) {
+	alert_throttler::config config;
+	config.window_ns = 10 * one_sec;
+	config.rate_limit_enabled = true;
+	config.rate = 1;
+	config.max_burst = 3;
+	alert_throttler t(config);
+
+	auto prio = falco_common::PRIORITY_WARNING;
+	int admitted = 0;
+	for(int i = 0; i < 10; i++) {
+		admitted += t.admit("r1", prio, {}, 1 * one_sec) ? 1 : 0;
+	}
+	EXPECT_EQ(admitted, 3);
+	EXPECT_TRUE(t.admit("r2", prio, {}, 1 * one_sec));
+	EXPECT_EQ(t.get_num_rate_limited(), 7);
+
+	// The bucket refills over time
+	EXPECT_TRUE(t.admit("r1", prio, {}, 2 * one_sec));
+
+	std::vector<alert_throttler::summary> summaries;
+	t.expire(11 * one_sec, summaries);
+	ASSERT_EQ(summaries.size(), 1);
+	EXPECT_EQ(summaries[0].rule, "r1");
+	EXPECT_EQ(summaries[0].num_suppressed, 7);
+	EXPECT_TRUE(summaries[0].key_fields.empty());
+}
+
+TEST(AlertThrottler, rate_limit_and_dedup) {
+	alert_throttler::config config;
+	config.window_ns = 10 * one_sec;
+	config.rate_limit_enabled = true;
+	config.rate = 1;
+	config.max_burst = 1;
+	config.dedup_enabled = true;
+	alert_throttler t(config);
+
+	std::map<std::string, std::string> a = {{"proc.name", "a"}};
+	std::map<std::string, std::string> b = {{"proc.name", "b"}};
+	auto prio = falco_common::PRIORITY_NOTICE;
+
+	EXPECT_TRUE(t.admit("r1", prio, a, 1 * one_sec));
+
+	// The rate limited alerts open a window that doesn't deduplicate
+	EXPECT_FALSE(t.admit("r1", prio, b, 1 * one_sec));
+	EXPECT_FALSE(t.admit("r1", prio, b, 1 * one_sec));
+	EXPECT_EQ(t.get_num_rate_limited(), 2);
+	EXPECT_EQ(t.get_num_deduplicated(), 0);
+
+	// Once the bucket refilled, the alert is delivered, and the identical
+	// ones that follow are deduplicated
+	EXPECT_TRUE(t.admit("r1", prio, b, 3 * one_sec));
+	EXPECT_FALSE(t.admit("r1", prio, b, 3 * one_sec));
+	EXPECT_FALSE(t.admit("r1", prio, a, 3 * one_sec));
+	EXPECT_EQ(t.get_num_rate_limited(), 2);
+	EXPECT_EQ(t.get_num_deduplicated(), 2);
+
+	std::vector<alert_throttler::summary> summaries;
+	t.expire(11 * one_sec, summaries);
+	ASSERT_EQ(summaries.size(), 2);
+	std::sort(summaries.begin(), summaries.end(), [](const auto& x, const auto& y) {
+		return x.key_fields < y.key_fields;
+	});
+	EXPECT_EQ(summaries[0].key_fields, a);
+	EXPECT_EQ(summaries[0].num_suppressed, 1);
+	EXPECT_EQ(summaries[1].key_fields, b);
+	EXPECT_EQ(summaries[1].num_suppressed, 3);
+}
@@ -182,3 +182,25 @@ TEST(Configuration, configuration_webserver_ip) {
 		EXPECT_ANY_THROW(falco_config.init_from_content("", cmdline_config_options));
 	}
 }
+
+TEST(Configuration, configuration_grpc_batch_size) {
+	falco_configuration falco_config;
+
+	EXPECT_NO_THROW(falco_config.init_from_content(R"(
+grpc:
+  batch_size: 100
+grpc_output:
+  subscriber_buffer_size: 100
+)",
+	                                               {}));
+	EXPECT_EQ(falco_config.m_grpc_batch_size, 100);
+
+	// A batch could never be full
+	EXPECT_ANY_THROW(falco_config.init_from_content(R"(
+grpc:
+  batch_size: 101
+grpc_output:
+  subscriber_buffer_size: 100
+)",
+	                                                {}));
+}
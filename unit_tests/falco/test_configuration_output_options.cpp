@@ -121,3 +121,84 @@ TEST(ConfigurationRuleOutputOptions, cli_options) {
 	EXPECT_EQ(falco_config.m_append_output[2].m_raw_fields.size(), 1);
 	EXPECT_EQ(falco_config.m_append_output[2].m_raw_fields.count("ka.verb"), 1);
 }
+
+TEST(ConfigurationRuleOutputOptions, outputs_queue_per_output) {
+	falco_configuration falco_config;
+	ASSERT_NO_THROW(falco_config.init_from_content("", {}));
+	EXPECT_FALSE(falco_config.m_outputs_queue_per_output);
+
+	ASSERT_NO_THROW(falco_config.init_from_content(R"(
+outputs_queue:
+  capacity: 100
+  per_output: true
+	)",
+	                                               {}));
+	EXPECT_EQ(falco_config.m_outputs_queue_capacity, 100);
+	EXPECT_TRUE(falco_config.m_outputs_queue_per_output);
+}
+
+TEST(ConfigurationRuleOutputOptions, outputs_queue_spool) {
+	falco_configuration falco_config;
+	ASSERT_NO_THROW(falco_config.init_from_content("", {}));
+	EXPECT_FALSE(falco_config.m_outputs_queue_spool.enabled);
+
+	ASSERT_NO_THROW(falco_config.init_from_content(R"(
+outputs_queue:
+  per_output: true
+  spool:
+    enabled: true
+    directory: /tmp/falco-spool
+    outputs: [http]
+    segment_size_mb: 1
+    max_size_mb: 8
+	)",
+	                                               {}));
+	EXPECT_TRUE(falco_config.m_outputs_queue_spool.enabled);
+	EXPECT_EQ(falco_config.m_outputs_queue_spool.directory, "/tmp/falco-spool");
+	EXPECT_EQ(falco_config.m_outputs_queue_spool.outputs, std::set<std::string>{"http"});
+	EXPECT_EQ(falco_config.m_outputs_queue_spool.segment_size, 1024 * 1024);
+	EXPECT_EQ(falco_config.m_outputs_queue_spool.max_size, 8 * 1024 * 1024);
+
+	// The spool sits between the per-output queues and their outputs
+	EXPECT_ANY_THROW(falco_config.init_from_content(R"(
+outputs_queue:
+  spool:
+    enabled: true
+	)",
+	                                                {}));
+}
+
+TEST(ConfigurationRuleOutputOptions, alert_throttling) {
+	falco_configuration falco_config;
+	ASSERT_NO_THROW(falco_config.init_from_content("", {}));
+	EXPECT_FALSE(falco_config.m_alert_throttling.enabled());
+
+	ASSERT_NO_THROW(falco_config.init_from_content(R"(
+alert_throttling:
+  window_sec: 30
+  rate_limit:
+    enabled: true
+    rate: 2
+    max_burst: 5
+  dedup:
+    enabled: true
+    key_fields: [proc.cmdline, user.name]
+	)",
+	                                               {}));
+	EXPECT_TRUE(falco_config.m_alert_throttling.enabled());
+	EXPECT_EQ(falco_config.m_alert_throttling.window_ns, 30000000000ULL);
+	EXPECT_TRUE(falco_config.m_alert_throttling.rate_limit_enabled);
+	EXPECT_EQ(falco_config.m_alert_throttling.rate, 2);
+	EXPECT_EQ(falco_config.m_alert_throttling.max_burst, 5);
+	EXPECT_TRUE(falco_config.m_alert_throttling.dedup_enabled);
+	EXPECT_EQ(falco_config.m_alert_throttling.dedup_key_fields,
+	          (std::vector<std::string>{"proc.cmdline", "user.name"}));
+
+	EXPECT_ANY_THROW(falco_config.init_from_content(R"(
+alert_throttling:
+  rate_limit:
+    enabled: true
+    rate: 0
+	)",
+	                                                {}));
+}
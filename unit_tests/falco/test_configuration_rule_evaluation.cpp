@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <falco/configuration.h>
+
+TEST(ConfigurationRuleEvaluation, adaptive_ordering_defaults) {
+	falco_configuration falco_config;
+	ASSERT_NO_THROW(falco_config.init_from_content("", {}));
+
+	EXPECT_FALSE(falco_config.m_rule_evaluation_adaptive_ordering.enabled);
+	EXPECT_EQ(falco_config.m_rule_evaluation_adaptive_ordering.sampling_ratio, 64);
+	EXPECT_EQ(falco_config.m_rule_evaluation_adaptive_ordering.reorder_interval, 100000);
+}
+
+TEST(ConfigurationRuleEvaluation, adaptive_ordering_parse_yaml) {
+	falco_configuration falco_config;
+	ASSERT_NO_THROW(falco_config.init_from_content(R"(
+rule_evaluation:
+  adaptive_ordering:
+    enabled: true
+    sampling_ratio: 16
+    reorder_interval: 5000
+	)",
+	                                               {}));
+
+	EXPECT_TRUE(falco_config.m_rule_evaluation_adaptive_ordering.enabled);
+	EXPECT_EQ(falco_config.m_rule_evaluation_adaptive_ordering.sampling_ratio, 16);
+	EXPECT_EQ(falco_config.m_rule_evaluation_adaptive_ordering.reorder_interval, 5000);
+
+	EXPECT_ANY_THROW(falco_config.init_from_content(R"(
+rule_evaluation:
+  adaptive_ordering:
+    sampling_ratio: 0
+	)",
+	                                                {}));
+}
+
+TEST(ConfigurationRuleEvaluation, profiling_defaults) {
+	falco_configuration falco_config;
+	ASSERT_NO_THROW(falco_config.init_from_content("", {}));
+
+	EXPECT_FALSE(falco_config.m_rule_evaluation_profiling_enabled);
+	EXPECT_EQ(falco_config.m_rule_evaluation_profiling_sampling_ratio, 100);
+}
+
+TEST(ConfigurationRuleEvaluation, profiling_parse_yaml) {
+	falco_configuration falco_config;
+	ASSERT_NO_THROW(falco_config.init_from_content(R"(
+rule_evaluation:
+  profiling:
+    enabled: true
+    sampling_ratio: 10
+	)",
+	                                               {}));
+
+	EXPECT_TRUE(falco_config.m_rule_evaluation_profiling_enabled);
+	EXPECT_EQ(falco_config.m_rule_evaluation_profiling_sampling_ratio, 10);
+
+	EXPECT_ANY_THROW(falco_config.init_from_content(R"(
+rule_evaluation:
+  profiling:
+    sampling_ratio: 0
+	)",
+	                                                {}));
+}
+
+TEST(ConfigurationRuleEvaluation, field_extraction_cache_parse_yaml) {
+	falco_configuration falco_config;
+	ASSERT_NO_THROW(falco_config.init_from_content("", {}));
+	EXPECT_FALSE(falco_config.m_rule_evaluation_field_extraction_cache_enabled);
+
+	ASSERT_NO_THROW(falco_config.init_from_content(R"(
+rule_evaluation:
+  field_extraction_cache:
+    enabled: true
+	)",
+	                                               {}));
+	EXPECT_TRUE(falco_config.m_rule_evaluation_field_extraction_cache_enabled);
+}
+
+TEST(ConfigurationRuleEvaluation, string_predicate_folding_parse_yaml) {
+	falco_configuration falco_config;
+	ASSERT_NO_THROW(falco_config.init_from_content("", {}));
+	EXPECT_FALSE(falco_config.m_rule_evaluation_string_predicate_folding_enabled);
+
+	ASSERT_NO_THROW(falco_config.init_from_content(R"(
+rule_evaluation:
+  string_predicate_folding:
+    enabled: true
+	)",
+	                                               {}));
+	EXPECT_TRUE(falco_config.m_rule_evaluation_string_predicate_folding_enabled);
+}
+
+TEST(ConfigurationRuleEvaluation, condition_optimizer_parse_yaml) {
+	falco_configuration falco_config;
+	ASSERT_NO_THROW(falco_config.init_from_content("", {}));
+	EXPECT_FALSE(falco_config.m_rule_evaluation_condition_optimizer_enabled);
+
+	ASSERT_NO_THROW(falco_config.init_from_content(R"(
+rule_evaluation:
+  condition_optimizer:
+    enabled: true
+	)",
+	                                               {}));
+	EXPECT_TRUE(falco_config.m_rule_evaluation_condition_optimizer_enabled);
+}
@@ -0,0 +1,415 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <falco/grpc_queue.h>
+
+#include <string>
+#include <vector>
+
+using falco::grpc::queue;
+using falco::grpc::response_filter;
+using falco::grpc::response_ptr;
+using falco::grpc::slow_subscriber_policy;
+using falco::grpc::subscription;
+
+static falco::outputs::response make_response(
+        const std::string& rule,
+        falco::schema::priority priority = falco::schema::INFORMATIONAL,
+        const std::string& source = "syscall",
+        const std::vector<std::string>& tags = {}) {
+	falco::outputs::response res;
+	res.set_rule(rule);
+	res.set_priority(priority);
+	res.set_source(source);
+	for(const auto& tag : tags) {
+		res.add_tags(tag);
+	}
+	return res;
+}
+
+static response_ptr make_response_ptr(const std::string& rule) {
+	return std::make_shared<const falco::outputs::response>(make_response(rule));
+}
+
+static std::vector<std::string> pop_rules(subscription& sub) {
+	std::vector<std::string> rules;
+	response_ptr res;
+	while(sub.try_pop(res)) {
+		rules.push_back(res->rule());
+	}
+	return rules;
+}
+
+// The queue is a singleton: each test configures it from scratch, and
+// leaves it without subscriptions
+class test_grpc_queue : public testing::Test {
+protected:
+	void SetUp() override { queue::get().configure(3, slow_subscriber_policy::DROP_OLDEST); }
+
+	void TearDown() override {
+		queue::get().resume();
+		for(const auto& sub : m_subs) {
+			queue::get().unsubscribe(sub);
+		}
+	}
+
+	std::shared_ptr<subscription> subscribe(response_filter filter = {}) {
+		m_subs.push_back(queue::get().subscribe(std::move(filter)));
+		return m_subs.back();
+	}
+
+	std::vector<std::shared_ptr<subscription>> m_subs;
+};
+
+TEST(GrpcSubscription, drop_oldest) {
+	subscription sub(3);
+	for(int i = 0; i < 5; i++) {
+		sub.push(make_response_ptr("r" + std::to_string(i)), slow_subscriber_policy::DROP_OLDEST);
+	}
+
+	ASSERT_EQ(sub.size(), 3);
+	ASSERT_EQ(sub.get_num_drops(), 2);
+	ASSERT_FALSE(sub.overflowed());
+	ASSERT_EQ(pop_rules(sub), std::vector<std::string>({"r2", "r3", "r4"}));
+}
+
+TEST(GrpcSubscription, disconnect) {
+	subscription sub(3);
+	for(int i = 0; i < 3; i++) {
+		sub.push(make_response_ptr("r" + std::to_string(i)), slow_subscriber_policy::DISCONNECT);
+	}
+	ASSERT_FALSE(sub.overflowed());
+	ASSERT_EQ(sub.get_num_drops(), 0);
+
+	// the pending responses are dropped along with the new one
+	sub.push(make_response_ptr("r3"), slow_subscriber_policy::DISCONNECT);
+	ASSERT_TRUE(sub.overflowed());
+	ASSERT_EQ(sub.size(), 0);
+	ASSERT_EQ(sub.get_num_drops(), 4);
+
+	// nothing is queued anymore once overflowed
+	sub.push(make_response_ptr("r4"), slow_subscriber_policy::DISCONNECT);
+	ASSERT_EQ(sub.size(), 0);
+	ASSERT_EQ(sub.get_num_drops(), 5);
+}
+
+TEST(GrpcSubscription, pop_batch) {
+	subscription sub(5);
+	for(int i = 0; i < 4; i++) {
+		sub.push(make_response_ptr("r" + std::to_string(i)), slow_subscriber_policy::DROP_OLDEST);
+	}
+
+	std::vector<response_ptr> batch;
+	ASSERT_EQ(sub.try_pop(batch, 3), 3);
+	ASSERT_EQ(sub.try_pop(batch, 3), 1);
+	ASSERT_EQ(sub.try_pop(batch, 3), 0);
+	ASSERT_EQ(batch.size(), 4);
+	for(size_t i = 0; i < batch.size(); i++) {
+		ASSERT_EQ(batch[i]->rule(), "r" + std::to_string(i));
+	}
+}
+
+TEST_F(test_grpc_queue, fan_out) {
+	auto first = subscribe();
+	auto second = subscribe();
+
+	for(int i = 0; i < 3; i++) {
+		queue::get().push(make_response("r" + std::to_string(i)));
+	}
+
+	// every subscriber gets all the responses, and shares them
+	response_ptr first_res, second_res;
+	for(int i = 0; i < 3; i++) {
+		ASSERT_TRUE(first->try_pop(first_res));
+		ASSERT_TRUE(second->try_pop(second_res));
+		ASSERT_EQ(first_res->rule(), "r" + std::to_string(i));
+		ASSERT_EQ(first_res, second_res);
+	}
+	ASSERT_FALSE(first->try_pop(first_res));
+	ASSERT_FALSE(second->try_pop(second_res));
+
+	// the backlog has its own copy of them
+	response_ptr res;
+	for(int i = 0; i < 3; i++) {
+		ASSERT_TRUE(queue::get().try_pop(res, {}));
+		ASSERT_EQ(res->rule(), "r" + std::to_string(i));
+	}
+	ASSERT_FALSE(queue::get().try_pop(res, {}));
+}
+
+TEST_F(test_grpc_queue, slow_subscriber_drop_oldest) {
+	auto num_drops = queue::get().get_num_drops();
+	auto num_disconnects = queue::get().get_num_disconnects();
+	auto fast = subscribe();
+	auto slow = subscribe();
+
+	response_ptr res;
+	for(int i = 0; i < 5; i++) {
+		queue::get().push(make_response("r" + std::to_string(i)));
+		ASSERT_TRUE(fast->try_pop(res));
+	}
+
+	// only the slow subscriber misses some responses
+	ASSERT_EQ(pop_rules(*slow), std::vector<std::string>({"r2", "r3", "r4"}));
+	ASSERT_EQ(fast->get_num_drops(), 0);
+	ASSERT_EQ(queue::get().get_num_drops() - num_drops, 2);
+	ASSERT_EQ(queue::get().get_num_disconnects() - num_disconnects, 0);
+	ASSERT_EQ(queue::get().get_num_backlog_drops(), 2);
+}
+
+TEST_F(test_grpc_queue, slow_subscriber_disconnect) {
+	queue::get().configure(3, slow_subscriber_policy::DISCONNECT);
+	auto num_drops = queue::get().get_num_drops();
+	auto num_disconnects = queue::get().get_num_disconnects();
+	auto fast = subscribe();
+	auto slow = subscribe();
+
+	response_ptr res;
+	for(int i = 0; i < 4; i++) {
+		queue::get().push(make_response("r" + std::to_string(i)));
+		ASSERT_TRUE(fast->try_pop(res));
+	}
+
+	ASSERT_FALSE(fast->overflowed());
+	ASSERT_TRUE(slow->overflowed());
+	ASSERT_EQ(queue::get().get_num_drops() - num_drops, 4);
+	ASSERT_EQ(queue::get().get_num_disconnects() - num_disconnects, 1);
+
+	// the counts of the subscribers that are gone are kept
+	queue::get().unsubscribe(slow);
+	ASSERT_EQ(queue::get().get_num_drops() - num_drops, 4);
+	ASSERT_EQ(queue::get().get_num_disconnects() - num_disconnects, 1);
+
+	// the backlog never disconnects
+	ASSERT_EQ(queue::get().get_num_backlog_drops(), 1);
+}
+
+TEST(GrpcResponseFilter, empty) {
+	response_filter filter;
+	ASSERT_TRUE(filter.matches(make_response("r")));
+	ASSERT_TRUE(filter.matches(make_response("r", falco::schema::DEBUG, "k8s_audit", {"a"})));
+}
+
+TEST(GrpcResponseFilter, tags) {
+	falco::outputs::request req;
+	req.add_tags("a");
+	req.add_tags("b");
+	response_filter filter(req);
+
+	auto priority = falco::schema::INFORMATIONAL;
+	ASSERT_TRUE(filter.matches(make_response("r", priority, "syscall", {"a"})));
+	ASSERT_TRUE(filter.matches(make_response("r", priority, "syscall", {"c", "b"})));
+	ASSERT_FALSE(filter.matches(make_response("r", priority, "syscall", {"c"})));
+	ASSERT_FALSE(filter.matches(make_response("r", priority, "syscall", {})));
+}
+
+TEST(GrpcResponseFilter, min_priority) {
+	falco::outputs::request req;
+	req.set_min_priority(falco::schema::WARNING);
+	response_filter filter(req);
+
+	ASSERT_TRUE(filter.matches(make_response("r", falco::schema::EMERGENCY)));
+	ASSERT_TRUE(filter.matches(make_response("r", falco::schema::WARNING)));
+	ASSERT_FALSE(filter.matches(make_response("r", falco::schema::NOTICE)));
+	ASSERT_FALSE(filter.matches(make_response("r", falco::schema::DEBUG)));
+
+	// the most severe priority is a filter too
+	req.set_min_priority(falco::schema::EMERGENCY);
+	response_filter emergency_filter(req);
+	ASSERT_TRUE(emergency_filter.matches(make_response("r", falco::schema::EMERGENCY)));
+	ASSERT_FALSE(emergency_filter.matches(make_response("r", falco::schema::ALERT)));
+}
+
+TEST(GrpcResponseFilter, rules) {
+	falco::outputs::request req;
+	req.add_rules("Read sensitive file");
+	req.add_rules("Terminal shell*");
+	response_filter filter(req);
+
+	ASSERT_TRUE(filter.matches(make_response("Read sensitive file")));
+	ASSERT_FALSE(filter.matches(make_response("Read sensitive file untrusted")));
+	ASSERT_TRUE(filter.matches(make_response("Terminal shell")));
+	ASSERT_TRUE(filter.matches(make_response("Terminal shell in container")));
+	ASSERT_FALSE(filter.matches(make_response("A Terminal shell")));
+}
+
+TEST(GrpcResponseFilter, sources) {
+	falco::outputs::request req;
+	req.add_sources("k8s_audit");
+	response_filter filter(req);
+
+	auto priority = falco::schema::INFORMATIONAL;
+	ASSERT_TRUE(filter.matches(make_response("r", priority, "k8s_audit")));
+	ASSERT_FALSE(filter.matches(make_response("r", priority, "syscall")));
+}
+
+TEST(GrpcResponseFilter, all_fields) {
+	falco::outputs::request req;
+	req.add_tags("a");
+	req.set_min_priority(falco::schema::WARNING);
+	req.add_rules("r*");
+	req.add_sources("syscall");
+	response_filter filter(req);
+
+	ASSERT_TRUE(filter.matches(make_response("r1", falco::schema::ERROR, "syscall", {"a"})));
+	ASSERT_FALSE(filter.matches(make_response("r1", falco::schema::ERROR, "syscall", {"b"})));
+	ASSERT_FALSE(filter.matches(make_response("r1", falco::schema::DEBUG, "syscall", {"a"})));
+	ASSERT_FALSE(filter.matches(make_response("x1", falco::schema::ERROR, "syscall", {"a"})));
+	ASSERT_FALSE(filter.matches(make_response("r1", falco::schema::ERROR, "k8s_audit", {"a"})));
+}
+
+TEST(GrpcSubscription, filter) {
+	falco::outputs::request req;
+	req.add_rules("keep*");
+	subscription sub(3, response_filter(req));
+
+	for(const auto& rule : {"keep1", "skip1", "keep2", "skip2"}) {
+		sub.push(make_response_ptr(rule), slow_subscriber_policy::DROP_OLDEST);
+	}
+	ASSERT_EQ(sub.get_num_drops(), 0);
+	ASSERT_EQ(pop_rules(sub), std::vector<std::string>({"keep1", "keep2"}));
+}
+
+TEST(GrpcSubscription, filtered_pop) {
+	// wrap the ring around, so that the gap is filled across its end
+	subscription sub(4);
+	for(int i = 0; i < 6; i++) {
+		sub.push(make_response_ptr("r" + std::to_string(i)), slow_subscriber_policy::DROP_OLDEST);
+	}
+
+	falco::outputs::request req;
+	req.add_rules("r4");
+	response_ptr res;
+	ASSERT_TRUE(sub.try_pop(res, response_filter(req)));
+	ASSERT_EQ(res->rule(), "r4");
+	ASSERT_FALSE(sub.try_pop(res, response_filter(req)));
+
+	ASSERT_EQ(pop_rules(sub), std::vector<std::string>({"r2", "r3", "r5"}));
+}
+
+TEST_F(test_grpc_queue, filtered_get) {
+	queue::get().configure(10, slow_subscriber_policy::DROP_OLDEST);
+	auto priority = falco::schema::INFORMATIONAL;
+	queue::get().push(make_response("r0", priority, "syscall"));
+	queue::get().push(make_response("r1", priority, "k8s_audit"));
+	queue::get().push(make_response("r2", priority, "syscall"));
+	queue::get().push(make_response("r3", priority, "k8s_audit"));
+
+	falco::outputs::request req;
+	req.add_sources("k8s_audit");
+	response_filter filter(req);
+
+	response_ptr res;
+	ASSERT_TRUE(queue::get().try_pop(res, filter));
+	ASSERT_EQ(res->rule(), "r1");
+	ASSERT_TRUE(queue::get().try_pop(res, filter));
+	ASSERT_EQ(res->rule(), "r3");
+	ASSERT_FALSE(queue::get().try_pop(res, filter));
+
+	// the responses not matching are left to the other gets, in order
+	ASSERT_TRUE(queue::get().try_pop(res, {}));
+	ASSERT_EQ(res->rule(), "r0");
+	ASSERT_TRUE(queue::get().try_pop(res, {}));
+	ASSERT_EQ(res->rule(), "r2");
+	ASSERT_FALSE(queue::get().try_pop(res, {}));
+}
+
+TEST(GrpcSubscription, wait) {
+	subscription sub(10);
+	int num_wakeups = 0;
+	sub.wait(2, [&num_wakeups]() { num_wakeups++; });
+
+	sub.push(make_response_ptr("r0"), slow_subscriber_policy::DROP_OLDEST);
+	ASSERT_EQ(num_wakeups, 0);
+	sub.push(make_response_ptr("r1"), slow_subscriber_policy::DROP_OLDEST);
+	ASSERT_EQ(num_wakeups, 1);
+
+	// the wakeup is called only once
+	sub.push(make_response_ptr("r2"), slow_subscriber_policy::DROP_OLDEST);
+	ASSERT_EQ(num_wakeups, 1);
+
+	// enough responses are already pending
+	sub.wait(3, [&num_wakeups]() { num_wakeups++; });
+	ASSERT_EQ(num_wakeups, 2);
+
+	// at least a response is needed
+	std::vector<response_ptr> batch;
+	sub.try_pop(batch, 3);
+	sub.wait(0, [&num_wakeups]() { num_wakeups++; });
+	ASSERT_EQ(num_wakeups, 2);
+	sub.push(make_response_ptr("r3"), slow_subscriber_policy::DROP_OLDEST);
+	ASSERT_EQ(num_wakeups, 3);
+}
+
+TEST(GrpcSubscription, wait_overflow) {
+	subscription sub(2);
+	int num_wakeups = 0;
+	sub.wait(5, [&num_wakeups]() { num_wakeups++; });
+
+	for(int i = 0; i < 3; i++) {
+		sub.push(make_response_ptr("r" + std::to_string(i)), slow_subscriber_policy::DISCONNECT);
+	}
+	ASSERT_TRUE(sub.overflowed());
+	ASSERT_EQ(num_wakeups, 1);
+
+	sub.wait(5, [&num_wakeups]() { num_wakeups++; });
+	ASSERT_EQ(num_wakeups, 2);
+}
+
+TEST(GrpcSubscription, stop_waiting) {
+	subscription sub(10);
+	int num_wakeups = 0;
+	sub.wait(1, [&num_wakeups]() { num_wakeups++; });
+	sub.stop_waiting();
+
+	sub.push(make_response_ptr("r0"), slow_subscriber_policy::DROP_OLDEST);
+	sub.interrupt();
+	ASSERT_EQ(num_wakeups, 0);
+}
+
+TEST(GrpcSubscription, interrupt) {
+	subscription sub(10);
+	int num_wakeups = 0;
+	sub.wait(5, [&num_wakeups]() { num_wakeups++; });
+	sub.interrupt();
+	ASSERT_EQ(num_wakeups, 1);
+
+	// the following waits return right away
+	sub.wait(5, [&num_wakeups]() { num_wakeups++; });
+	ASSERT_EQ(num_wakeups, 2);
+}
+
+TEST_F(test_grpc_queue, interrupt) {
+	int num_wakeups = 0;
+	auto before = subscribe();
+	before->wait(1, [&num_wakeups]() { num_wakeups++; });
+
+	queue::get().interrupt();
+	ASSERT_EQ(num_wakeups, 1);
+
+	// the subscriptions made while interrupted are interrupted too
+	auto during = subscribe();
+	during->wait(1, [&num_wakeups]() { num_wakeups++; });
+	ASSERT_EQ(num_wakeups, 2);
+
+	queue::get().resume();
+	auto after = subscribe();
+	after->wait(1, [&num_wakeups]() { num_wakeups++; });
+	ASSERT_EQ(num_wakeups, 2);
+	after->stop_waiting();
+}
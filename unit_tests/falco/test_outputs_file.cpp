@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <falco/outputs_file.h>
+#include "temp_dir_helpers.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+class OutputsFile : public temp_dir_test {
+protected:
+	void SetUp() override {
+		temp_dir_test::SetUp();
+		m_filename = (m_dir / "events.txt").string();
+	}
+
+	void output(falco::outputs::output_file& o, int i) {
+		falco::outputs::message msg;
+		msg.msg = "alert-" + std::to_string(10 + i);
+		o.output(&msg);
+	}
+
+	static std::string read_file(const std::string& path) {
+		std::string res;
+		gzFile in = gzopen(path.c_str(), "rb");
+		char buf[1024];
+		int n;
+		while(in != nullptr && (n = gzread(in, buf, sizeof(buf))) > 0) {
+			res.append(buf, n);
+		}
+		gzclose(in);
+		return res;
+	}
+
+	std::string m_filename;
+};
+
+TEST_F(OutputsFile, buffered) {
+	falco::outputs::config oc{"file",
+	                          {{"filename", m_filename},
+	                           {"keep_alive", "true"},
+	                           {"buffer_size", "20"},
+	                           {"flush_interval_ms", "60000"}}};
+	falco::outputs::output_file o;
+	std::string err;
+	ASSERT_TRUE(o.init(oc, true, "", false, err));
+
+	// Each alert takes 9 bytes, so the buffer is written on the third one
+	output(o, 0);
+	output(o, 1);
+	EXPECT_EQ(read_file(m_filename), "");
+	output(o, 2);
+	EXPECT_EQ(read_file(m_filename), "alert-10\nalert-11\nalert-12\n");
+	output(o, 3);
+
+	o.cleanup();
+	EXPECT_EQ(read_file(m_filename), "alert-10\nalert-11\nalert-12\nalert-13\n");
+}
+
+TEST_F(OutputsFile, rotation) {
+	falco::outputs::config oc{"file",
+	                          {{"filename", m_filename},
+	                           {"rotation_max_size", "100"},
+	                           {"rotation_max_files", "2"},
+	                           {"rotation_compression", "gzip"}}};
+	{
+		falco::outputs::output_file o;
+		std::string err;
+		ASSERT_TRUE(o.init(oc, false, "", false, err));
+
+		// Each file holds 11 alerts, so the file is rotated 3 times
+		for(int i = 0; i < 40; i++) {
+			output(o, i);
+		}
+		EXPECT_EQ(o.get_metrics()[2].second, 3);
+	}
+
+	// The oldest rotated file was deleted
+	std::vector<std::string> lines;
+	size_t num_rotated = 0;
+	for(const auto& entry : fs::directory_iterator(m_dir)) {
+		if(entry.path().extension() == ".gz") {
+			num_rotated++;
+			std::istringstream content(read_file(entry.path().string()));
+			for(std::string line; std::getline(content, line);) {
+				lines.push_back(line);
+			}
+		}
+	}
+	EXPECT_EQ(num_rotated, 2);
+	std::sort(lines.begin(), lines.end());
+	ASSERT_EQ(lines.size(), 22);
+	EXPECT_EQ(lines.front(), "alert-21");
+	EXPECT_EQ(lines.back(), "alert-42");
+
+	std::string current;
+	for(int i = 33; i < 40; i++) {
+		current += "alert-" + std::to_string(10 + i) + "\n";
+	}
+	EXPECT_EQ(read_file(m_filename), current);
+}
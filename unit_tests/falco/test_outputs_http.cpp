@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <falco/outputs_http.h>
+#include <httplib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+
+// A local stand-in for the remote HTTP server, recording the received bodies
+class test_http_server {
+public:
+	test_http_server() {
+		m_server.Post("/", [this](const httplib::Request& req, httplib::Response& res) {
+			std::unique_lock<std::mutex> lck(m_mtx);
+			m_bodies.push_back(req.body);
+			m_content_types.push_back(req.get_header_value("Content-Type"));
+			res.status = 200;
+		});
+		m_port = m_server.bind_to_any_port("127.0.0.1");
+		m_thread = std::thread([this]() { m_server.listen_after_bind(); });
+		m_server.wait_until_ready();
+	}
+
+	~test_http_server() {
+		m_server.stop();
+		m_thread.join();
+	}
+
+	std::string url() const { return "http://127.0.0.1:" + std::to_string(m_port) + "/"; }
+
+	std::vector<std::string> bodies() {
+		std::unique_lock<std::mutex> lck(m_mtx);
+		return m_bodies;
+	}
+
+	std::vector<std::string> content_types() {
+		std::unique_lock<std::mutex> lck(m_mtx);
+		return m_content_types;
+	}
+
+private:
+	httplib::Server m_server;
+	int m_port;
+	std::thread m_thread;
+	std::mutex m_mtx;
+	std::vector<std::string> m_bodies;
+	std::vector<std::string> m_content_types;
+};
+
+static falco::outputs::config batching_config(const std::string& url, const std::string& format) {
+	falco::outputs::config oc;
+	oc.name = "http";
+	oc.options["url"] = url;
+	oc.options["user_agent"] = "falcosecurity/falco";
+	oc.options["echo"] = "false";
+	oc.options["max_consecutive_timeouts"] = "5";
+	oc.options["batch_enabled"] = "true";
+	oc.options["batch_format"] = format;
+	oc.options["batch_max_messages"] = "3";
+	oc.options["batch_max_bytes"] = "1048576";
+	oc.options["batch_flush_interval_ms"] = "60000";
+	oc.options["max_in_flight"] = "2";
+	return oc;
+}
+
+static void output_messages(falco::outputs::abstract_output* o, size_t num) {
+	for(size_t i = 0; i < num; i++) {
+		falco::outputs::message msg = {};
+		msg.msg = "{\"n\":" + std::to_string(i) + "}";
+		o->output(&msg);
+	}
+}
+
+TEST(OutputsHttp, batching_json_array) {
+	test_http_server server;
+	std::unique_ptr<falco::outputs::abstract_output> o =
+	        std::make_unique<falco::outputs::output_http>();
+	std::string err;
+	ASSERT_TRUE(o->init(batching_config(server.url(), "json_array"), false, "", true, err)) << err;
+
+	// The last, partial, batch is flushed on cleanup
+	output_messages(o.get(), 5);
+	o->cleanup();
+
+	auto bodies = server.bodies();
+	ASSERT_EQ(bodies.size(), 2);
+	std::sort(bodies.begin(), bodies.end());
+	EXPECT_EQ(bodies[0], "[{\"n\":0},{\"n\":1},{\"n\":2}]");
+	EXPECT_EQ(bodies[1], "[{\"n\":3},{\"n\":4}]");
+	EXPECT_EQ(server.content_types()[0], "application/json");
+
+	auto metrics = o->get_metrics();
+	std::map<std::string, uint64_t> by_name(metrics.begin(), metrics.end());
+	EXPECT_EQ(by_name["requests"], 2);
+	EXPECT_EQ(by_name["batches"], 2);
+	EXPECT_EQ(by_name["batched_messages"], 5);
+	EXPECT_EQ(by_name["request_failures"], 0);
+}
+
+TEST(OutputsHttp, batching_ndjson_flush_interval) {
+	test_http_server server;
+	auto oc = batching_config(server.url(), "ndjson");
+	oc.options["batch_flush_interval_ms"] = "100";
+	std::unique_ptr<falco::outputs::abstract_output> o =
+	        std::make_unique<falco::outputs::output_http>();
+	std::string err;
+	ASSERT_TRUE(o->init(oc, false, "", true, err)) << err;
+
+	// A partial batch is sent once the flush interval expires
+	output_messages(o.get(), 2);
+	for(int i = 0; i < 500 && server.bodies().empty(); i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	auto bodies = server.bodies();
+	ASSERT_EQ(bodies.size(), 1);
+	EXPECT_EQ(bodies[0], "{\"n\":0}\n{\"n\":1}\n");
+	EXPECT_EQ(server.content_types()[0], "application/x-ndjson");
+	o->cleanup();
+}
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <falco/outputs_queue.h>
+
+#include <thread>
+
+TEST(OutputsQueue, weighted_lanes) {
+	falco::outputs::prioritized_queue<int> q(3);
+	for(int i = 0; i < 6; i++) {
+		ASSERT_TRUE(q.try_push(200 + i, 2));
+	}
+	for(int i = 0; i < 3; i++) {
+		ASSERT_TRUE(q.try_push(i, 0));
+	}
+	EXPECT_EQ(q.size(), 9);
+
+	// With weights 3 and 1, the first lane gets most of the pops without
+	// starving the last one
+	std::vector<int> popped;
+	int item;
+	while(q.try_pop(item)) {
+		popped.push_back(item);
+	}
+	EXPECT_EQ(popped, std::vector<int>({0, 1, 200, 2, 201, 202, 203, 204, 205}));
+	EXPECT_EQ(q.size(), 0);
+}
+
+TEST(OutputsQueue, shed_lowest_lanes_first) {
+	// The last lane is admitted up to 5 items, the middle one up to 7
+	falco::outputs::prioritized_queue<int> q(3);
+	q.set_capacity(10, 0.5);
+	for(int i = 0; i < 5; i++) {
+		ASSERT_TRUE(q.try_push(i, 2));
+	}
+	EXPECT_FALSE(q.try_push(5, 2));
+	EXPECT_TRUE(q.try_push(6, 1));
+	EXPECT_TRUE(q.try_push(7, 1));
+	EXPECT_FALSE(q.try_push(8, 1));
+	EXPECT_TRUE(q.try_push(9, 0));
+	EXPECT_TRUE(q.try_push(10, 0));
+	EXPECT_TRUE(q.try_push(11, 0));
+	EXPECT_FALSE(q.try_push(12, 0));
+	EXPECT_EQ(q.size(), 10);
+
+	// No shedding below the threshold, only when full
+	q.set_capacity(10);
+	int item;
+	ASSERT_TRUE(q.try_pop(item));
+	EXPECT_TRUE(q.try_push(13, 2));
+	EXPECT_FALSE(q.try_push(14, 2));
+}
+
+TEST(OutputsQueue, blocking_pop) {
+	falco::outputs::prioritized_queue<int> q(2);
+	int item = 0;
+	std::thread consumer([&]() { q.pop(item); });
+	q.try_push(42, 1);
+	consumer.join();
+	EXPECT_EQ(item, 42);
+}
+
+TEST(OutputsQueue, push_when_full) {
+	falco::outputs::prioritized_queue<int> q(2);
+	q.set_capacity(2);
+	ASSERT_TRUE(q.try_push(0, 1));
+	ASSERT_TRUE(q.try_push(1, 1));
+	EXPECT_FALSE(q.try_push(2, 0));
+
+	// Items that must not be shed are admitted beyond the capacity
+	q.push(3, 0);
+	EXPECT_EQ(q.size(), 3);
+	int item;
+	ASSERT_TRUE(q.try_pop(item));
+	EXPECT_EQ(item, 3);
+	EXPECT_FALSE(q.try_push(4, 0));
+}
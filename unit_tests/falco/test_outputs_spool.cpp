@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <falco/outputs_spool.h>
+#include "temp_dir_helpers.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+class OutputsSpool : public temp_dir_test {
+protected:
+	size_t num_segments() {
+		size_t n = 0;
+		for(const auto& entry : fs::directory_iterator(m_dir)) {
+			n += entry.path().extension() == ".seg" ? 1 : 0;
+		}
+		return n;
+	}
+};
+
+TEST_F(OutputsSpool, fifo_across_segments) {
+	// Each record takes 12 bytes, so 5 of them fit in a segment
+	falco::outputs::spool s(m_dir, 64, 1024);
+	for(int i = 0; i < 12; i++) {
+		ASSERT_TRUE(s.push("record-" + std::to_string(i % 10)));
+	}
+	EXPECT_EQ(s.get_stats().depth, 12);
+	EXPECT_EQ(s.get_stats().bytes, 3 * 64);
+	EXPECT_EQ(num_segments(), 3);
+
+	std::string record;
+	for(int i = 0; i < 12; i++) {
+		ASSERT_TRUE(s.pop(record));
+		EXPECT_EQ(record, "record-" + std::to_string(i % 10));
+	}
+	EXPECT_FALSE(s.pop(record));
+	EXPECT_TRUE(s.empty());
+	EXPECT_EQ(s.get_stats().drained, 12);
+
+	// The fully read segments are deleted on sync
+	EXPECT_EQ(num_segments(), 3);
+	s.sync();
+	EXPECT_EQ(num_segments(), 1);
+	EXPECT_EQ(s.get_stats().bytes, 64);
+}
+
+TEST_F(OutputsSpool, max_size) {
+	falco::outputs::spool s(m_dir, 64, 128);
+	for(int i = 0; i < 10; i++) {
+		ASSERT_TRUE(s.push("record-" + std::to_string(i)));
+	}
+	EXPECT_FALSE(s.push("record-x"));
+	EXPECT_FALSE(s.push(std::string(64, 'x')));
+	EXPECT_EQ(s.get_stats().depth, 10);
+
+	// Draining a segment makes room again
+	std::string record;
+	for(int i = 0; i < 6; i++) {
+		ASSERT_TRUE(s.pop(record));
+	}
+	EXPECT_TRUE(s.push("record-x"));
+}
+
+TEST_F(OutputsSpool, segment_allocation_failure) {
+	falco::outputs::spool s(m_dir, 64, 1024);
+
+	// The next segment can't be created, as a directory is in its way
+	fs::create_directory(m_dir / "00000000000000000001.seg");
+	for(int i = 0; i < 5; i++) {
+		ASSERT_TRUE(s.push("record-" + std::to_string(i)));
+	}
+	EXPECT_FALSE(s.push("record-5"));
+	EXPECT_EQ(s.get_stats().depth, 5);
+	EXPECT_EQ(s.get_stats().bytes, 64);
+
+	fs::remove(m_dir / "00000000000000000001.seg");
+	EXPECT_TRUE(s.push("record-5"));
+	EXPECT_EQ(s.get_stats().depth, 6);
+}
+
+TEST_F(OutputsSpool, resume_after_reopen) {
+	std::string record;
+	{
+		falco::outputs::spool s(m_dir, 64, 1024);
+		for(int i = 0; i < 8; i++) {
+			ASSERT_TRUE(s.push("record-" + std::to_string(i)));
+		}
+		ASSERT_TRUE(s.pop(record));
+		ASSERT_TRUE(s.pop(record));
+	}
+
+	falco::outputs::spool s(m_dir, 64, 1024);
+	EXPECT_EQ(s.get_stats().depth, 6);
+	ASSERT_TRUE(s.push("record-8"));
+	for(int i = 2; i <= 8; i++) {
+		ASSERT_TRUE(s.pop(record));
+		EXPECT_EQ(record, "record-" + std::to_string(i));
+	}
+	EXPECT_FALSE(s.pop(record));
+}
+
+TEST_F(OutputsSpool, checkpoint_failure) {
+	falco::outputs::spool s(m_dir, 64, 1024);
+	for(int i = 0; i < 8; i++) {
+		ASSERT_TRUE(s.push("record-" + std::to_string(i)));
+	}
+
+	// The checkpoint can't be replaced, as a directory is in its way
+	fs::create_directory(m_dir / "checkpoint");
+	std::string record;
+	for(int i = 0; i < 6; i++) {
+		ASSERT_TRUE(s.pop(record));
+	}
+	s.sync();
+	EXPECT_TRUE(fs::is_directory(m_dir / "checkpoint"));
+
+	// The failed checkpoint is retried on the next sync
+	fs::remove(m_dir / "checkpoint");
+	s.sync();
+	std::ifstream cp(m_dir / "checkpoint");
+	uint64_t seq;
+	size_t offset;
+	ASSERT_TRUE(cp >> seq >> offset);
+	EXPECT_EQ(seq, 1);
+	EXPECT_EQ(offset, 12);
+}
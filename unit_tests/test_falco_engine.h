@@ -25,6 +25,7 @@ protected:
 
 	std::string m_sample_ruleset = "sample-ruleset";
 	std::string m_sample_source = falco_common::syscall_source;
+	std::size_t m_sample_source_idx = 0;
 	sinsp m_inspector;
 	sinsp_filter_check_list m_filterlist;
 	std::shared_ptr<sinsp_filter_factory> m_filter_factory;
@@ -0,0 +1,291 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "alert_json_writer.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+
+namespace {
+
+// Length of the UTF-8 sequence starting at s[i], or 0 if it is not well
+// formed, with the same rules as the validation done by nlohmann::json
+size_t utf8_sequence_length(const std::string& s, size_t i) {
+	auto byte = [&s](size_t j) { return static_cast<unsigned char>(s[j]); };
+	auto cont = [&](size_t j, unsigned char lo, unsigned char hi) {
+		return j < s.size() && byte(j) >= lo && byte(j) <= hi;
+	};
+
+	unsigned char c = byte(i);
+	if(c >= 0xC2 && c <= 0xDF) {
+		return cont(i + 1, 0x80, 0xBF) ? 2 : 0;
+	}
+	if(c >= 0xE0 && c <= 0xEF) {
+		unsigned char lo = c == 0xE0 ? 0xA0 : 0x80;
+		unsigned char hi = c == 0xED ? 0x9F : 0xBF;
+		return cont(i + 1, lo, hi) && cont(i + 2, 0x80, 0xBF) ? 3 : 0;
+	}
+	if(c >= 0xF0 && c <= 0xF4) {
+		unsigned char lo = c == 0xF0 ? 0x90 : 0x80;
+		unsigned char hi = c == 0xF4 ? 0x8F : 0xBF;
+		bool valid = cont(i + 1, lo, hi) && cont(i + 2, 0x80, 0xBF) && cont(i + 3, 0x80, 0xBF);
+		return valid ? 4 : 0;
+	}
+	return 0;
+}
+
+// Receives the events of nlohmann::json's SAX parser for a JSON object
+// and encodes each of its members, calling on_member once per member
+class object_members_sax : public nlohmann::json_sax<nlohmann::json> {
+public:
+	using on_member_t = std::function<void(const std::string& key, const std::string& value)>;
+
+	object_members_sax(std::string& value, on_member_t on_member):
+	        m_value(value),
+	        m_on_member(std::move(on_member)) {}
+
+	bool null() override {
+		value_prefix();
+		m_value += "null";
+		return value_done();
+	}
+
+	bool boolean(bool val) override {
+		value_prefix();
+		m_value += val ? "true" : "false";
+		return value_done();
+	}
+
+	bool number_integer(number_integer_t val) override {
+		value_prefix();
+		m_value += std::to_string(val);
+		return value_done();
+	}
+
+	bool number_unsigned(number_unsigned_t val) override {
+		value_prefix();
+		m_value += std::to_string(val);
+		return value_done();
+	}
+
+	bool number_float(number_float_t val, const string_t&) override {
+		// Rare enough to let nlohmann::json pick the shortest representation
+		value_prefix();
+		m_value += nlohmann::json(val).dump();
+		return value_done();
+	}
+
+	bool string(string_t& val) override {
+		value_prefix();
+		return alert_json_writer::write_string(m_value, val) && value_done();
+	}
+
+	bool binary(binary_t&) override { return false; }
+
+	bool start_object(std::size_t) override {
+		// Only the top-level object is supported, as nested ones would
+		// need their keys to be sorted too
+		return m_depth++ == 0;
+	}
+
+	bool key(string_t& val) override {
+		m_key = val;
+		m_value.clear();
+		return true;
+	}
+
+	bool end_object() override {
+		m_depth--;
+		return true;
+	}
+
+	bool start_array(std::size_t) override {
+		if(m_depth == 0) {
+			return false;
+		}
+		value_prefix();
+		m_value += '[';
+		m_first.push_back(true);
+		m_depth++;
+		return true;
+	}
+
+	bool end_array() override {
+		m_value += ']';
+		m_first.pop_back();
+		m_depth--;
+		return value_done();
+	}
+
+	bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override {
+		return false;
+	}
+
+private:
+	void value_prefix() {
+		if(!m_first.empty()) {
+			if(!m_first.back()) {
+				m_value += ',';
+			}
+			m_first.back() = false;
+		}
+	}
+
+	bool value_done() {
+		// Scalars are only accepted as members of the top-level object
+		if(m_depth == 0) {
+			return false;
+		}
+		if(m_depth == 1) {
+			m_on_member(m_key, m_value);
+		}
+		return true;
+	}
+
+	std::string& m_value;
+	on_member_t m_on_member;
+	std::string m_key;
+	std::vector<bool> m_first;
+	size_t m_depth = 0;
+};
+
+}  // namespace
+
+bool alert_json_writer::write_string(std::string& out, const std::string& s) {
+	out += '"';
+	for(size_t i = 0; i < s.size();) {
+		auto c = static_cast<unsigned char>(s[i]);
+		if(c >= 0x80) {
+			size_t len = utf8_sequence_length(s, i);
+			if(len == 0) {
+				return false;
+			}
+			out.append(s, i, len);
+			i += len;
+			continue;
+		}
+
+		switch(c) {
+		case '\b':
+			out += "\\b";
+			break;
+		case '\t':
+			out += "\\t";
+			break;
+		case '\n':
+			out += "\\n";
+			break;
+		case '\f':
+			out += "\\f";
+			break;
+		case '\r':
+			out += "\\r";
+			break;
+		case '"':
+			out += "\\\"";
+			break;
+		case '\\':
+			out += "\\\\";
+			break;
+		default:
+			if(c <= 0x1F) {
+				char buf[7];
+				snprintf(buf, sizeof(buf), "\\u%04x", c);
+				out += buf;
+			} else {
+				out += static_cast<char>(c);
+			}
+		}
+		i++;
+	}
+	out += '"';
+	return true;
+}
+
+void alert_json_writer::clear_fields() {
+	m_num_fields = 0;
+}
+
+alert_json_writer::field& alert_json_writer::next_field() {
+	// The fields are reused to keep the capacity of their strings
+	if(m_num_fields == m_fields.size()) {
+		m_fields.emplace_back();
+	}
+	return m_fields[m_num_fields++];
+}
+
+bool alert_json_writer::add_json_fields(const std::string& json) {
+	object_members_sax sax(m_scratch, [this](const std::string& key, const std::string& value) {
+		auto& f = next_field();
+		f.key = key;
+		f.value = value;
+	});
+	return nlohmann::json::sax_parse(json, &sax);
+}
+
+bool alert_json_writer::add_json_field(const std::string& key, const std::string& json) {
+	auto& f = next_field();
+	f.key = key;
+	f.value = "null";
+	object_members_sax sax(m_scratch, [&f](const std::string& k, const std::string& value) {
+		if(k == f.key) {
+			f.value = value;
+		}
+	});
+	return nlohmann::json::sax_parse(json, &sax);
+}
+
+bool alert_json_writer::add_string_field(const std::string& key, const std::string& value) {
+	auto& f = next_field();
+	f.key = key;
+	f.value.clear();
+	return write_string(f.value, value);
+}
+
+bool alert_json_writer::write_fields(std::string& out) {
+	m_order.resize(m_num_fields);
+	for(size_t i = 0; i < m_num_fields; i++) {
+		m_order[i] = i;
+	}
+	std::stable_sort(m_order.begin(), m_order.end(), [this](size_t a, size_t b) {
+		return m_fields[a].key < m_fields[b].key;
+	});
+
+	out += '{';
+	bool first = true;
+	for(size_t i = 0; i < m_order.size(); i++) {
+		// Among the fields with the same key, the last one wins
+		const auto& f = m_fields[m_order[i]];
+		if(i + 1 < m_order.size() && m_fields[m_order[i + 1]].key == f.key) {
+			continue;
+		}
+		if(!first) {
+			out += ',';
+		}
+		first = false;
+		if(!write_string(out, f.key)) {
+			return false;
+		}
+		out += ':';
+		out += f.value;
+	}
+	out += '}';
+	return true;
+}
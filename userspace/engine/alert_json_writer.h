@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/*!
+    \brief Writes the JSON encoding of an alert in a single pass, with the
+    same bytes that building the equivalent nlohmann::json object and
+    calling dump() on it would produce: object keys are sorted, the last
+    value set for a key wins, and strings are escaped the same way.
+
+    The output fields rendered by the formatters as JSON text are
+    tokenized once, without building an intermediate object. Inputs that
+    the writer does not reproduce exactly (nested objects, invalid JSON or
+    UTF-8) are rejected, so that callers can fall back to nlohmann::json.
+    The collected fields are kept across uses to reuse their buffers, so
+    each thread should use its own writer.
+*/
+class alert_json_writer {
+public:
+	/*!
+	    \brief Appends the given string to out as a JSON string.
+	    \return false if the string is not valid UTF-8
+	*/
+	static bool write_string(std::string& out, const std::string& s);
+
+	/*!
+	    \brief Forgets the collected output fields.
+	*/
+	void clear_fields();
+
+	/*!
+	    \brief Collects all the members of the given JSON object.
+	    \return false if json is not an object, or contains nested objects
+	*/
+	bool add_json_fields(const std::string& json);
+
+	/*!
+	    \brief Collects the member of the given JSON object with the given
+	    key, or null if there is no such member.
+	    \return false if json is not an object, or contains nested objects
+	*/
+	bool add_json_field(const std::string& key, const std::string& json);
+
+	/*!
+	    \brief Collects a field with a string value.
+	    \return false if the value is not valid UTF-8
+	*/
+	bool add_string_field(const std::string& key, const std::string& value);
+
+	/*!
+	    \brief Appends the collected fields to out as a JSON object.
+	    \return false if a key is not valid UTF-8
+	*/
+	bool write_fields(std::string& out);
+
+private:
+	struct field {
+		std::string key;
+		std::string value;  // already encoded as JSON
+	};
+
+	field& next_field();
+
+	std::vector<field> m_fields;
+	size_t m_num_fields = 0;
+	std::vector<size_t> m_order;
+	std::string m_scratch;
+};
@@ -50,6 +50,12 @@ void evttype_index_ruleset::add(const falco_rule &rule,
 
 void evttype_index_ruleset::on_loading_complete() {
 	print_enabled_rules_falco_logger();
+
+	// run_wrappers() only runs the filter of each wrapper, so the
+	// event type buckets can be evaluated from the flat layout
+	freeze([](const std::shared_ptr<evttype_index_wrapper> &wrap) {
+		return frozen_filter{wrap->m_filter.get(), &wrap->m_rule};
+	});
 }
 
 bool evttype_index_ruleset::run_wrappers(sinsp_evt *evt,
@@ -82,6 +88,36 @@ bool evttype_index_ruleset::run_wrappers(sinsp_evt *evt,
 	return match_found;
 }
 
+bool evttype_index_ruleset::run_wrappers(sinsp_evt *evt,
+                                         filter_wrapper_list &wrappers,
+                                         uint16_t ruleset_id,
+                                         const falco_rule *&match) {
+	for(const auto &wrap : wrappers) {
+		if(wrap->m_filter->run(evt)) {
+			match = &wrap->m_rule;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool evttype_index_ruleset::run_wrappers(sinsp_evt *evt,
+                                         filter_wrapper_list &wrappers,
+                                         uint16_t ruleset_id,
+                                         std::vector<const falco_rule *> &matches) {
+	bool match_found = false;
+
+	for(const auto &wrap : wrappers) {
+		if(wrap->m_filter->run(evt)) {
+			matches.push_back(&wrap->m_rule);
+			match_found = true;
+		}
+	}
+
+	return match_found;
+}
+
 void evttype_index_ruleset::print_enabled_rules_falco_logger() {
 	falco_logger::log(falco_logger::level::DEBUG, "Enabled rules:\n");
 
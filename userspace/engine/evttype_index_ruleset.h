@@ -61,6 +61,14 @@ public:
 	                  filter_wrapper_list &wrappers,
 	                  uint16_t ruleset_id,
 	                  std::vector<falco_rule> &matches) override;
+	bool run_wrappers(sinsp_evt *evt,
+	                  filter_wrapper_list &wrappers,
+	                  uint16_t ruleset_id,
+	                  const falco_rule *&match) override;
+	bool run_wrappers(sinsp_evt *evt,
+	                  filter_wrapper_list &wrappers,
+	                  uint16_t ruleset_id,
+	                  std::vector<const falco_rule *> &matches) override;
 
 	// Print each enabled rule when running Falco with falco logger
 	// log_level=debug; invoked within on_loading_complete()
@@ -24,6 +24,7 @@ limitations under the License.
 #define srandom srand
 #define random rand
 #endif
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <functional>
@@ -57,6 +58,8 @@ falco_engine::falco_engine(bool seed_rng):
         m_rule_reader(std::make_shared<rule_loader::reader>()),
         m_rule_collector(std::make_shared<rule_loader::collector>()),
         m_rule_compiler(std::make_shared<rule_loader::compiler>()),
+        m_formatter_cache_hits(0),
+        m_formatter_cache_misses(0),
         m_next_ruleset_id(0),
         m_min_priority(falco_common::PRIORITY_DEBUG),
         m_sampling_ratio(1),
@@ -182,9 +185,24 @@ std::unique_ptr<load_result> falco_engine::load_rules(const std::string &rules_c
 	rule_loader::configuration cfg(rules_content, m_sources, name);
 	cfg.extra_output_format = m_extra_output_format;
 	cfg.extra_output_fields = m_extra_output_fields;
+	cfg.optimize_conditions = m_condition_optimizer;
+	cfg.fold_string_predicates = m_string_predicate_folding;
 
 	// read rules YAML file and collect its definitions
 	if(m_rule_reader->read(cfg, *m_rule_collector, m_rule_schema)) {
+		// the filters compiled below share a new field extraction cache,
+		// the previous one is released along with the previous rules
+		for(auto &src : m_sources) {
+			src.filter_cache_factory = nullptr;
+			if(m_filter_cache_enabled) {
+				if(!src.filter_cache_metrics) {
+					src.filter_cache_metrics = std::make_shared<sinsp_filter_cache_metrics>();
+				}
+				src.filter_cache_factory =
+				        std::make_shared<exprstr_sinsp_filtercache_factory>(src.filter_cache_metrics);
+			}
+		}
+
 		// compile the definitions (resolve macro/list refs, exceptions, ...)
 		m_last_compile_output = m_rule_compiler->new_compile_output();
 		m_rule_compiler->compile(cfg, *m_rule_collector, *m_last_compile_output);
@@ -200,6 +218,7 @@ std::unique_ptr<load_result> falco_engine::load_rules(const std::string &rules_c
 		{
 			src.ruleset = create_ruleset(src.ruleset_factory);
 			src.ruleset->add_compile_output(*m_last_compile_output, m_min_priority, src.name);
+			src.m_formatters.clear();
 		}
 
 		// add rules to the engine and the rulesets
@@ -366,14 +385,33 @@ libsinsp::events::set<ppm_event_code> falco_engine::event_codes_for_ruleset(
 std::shared_ptr<sinsp_evt_formatter> falco_engine::create_formatter(
         const std::string &source,
         const std::string &output) const {
-	return find_source(source)->formatter_factory->create_formatter(output);
+	auto src = find_source(source);
+
+	// note: the cache is only written in complete_rule_loading(), so
+	// concurrent lookups are safe here
+	auto it = src->m_formatters.find(output);
+	if(it != src->m_formatters.end()) {
+		m_formatter_cache_hits.fetch_add(1, std::memory_order_relaxed);
+		return it->second;
+	}
+
+	m_formatter_cache_misses.fetch_add(1, std::memory_order_relaxed);
+	return src->formatter_factory->create_formatter(output);
 }
 
-std::unique_ptr<std::vector<falco_engine::rule_result>> falco_engine::process_event(
-        std::size_t source_idx,
-        sinsp_evt *ev,
-        uint16_t ruleset_id,
-        falco_common::rule_matching strategy) {
+uint64_t falco_engine::get_formatter_cache_hits() const {
+	return m_formatter_cache_hits.load();
+}
+
+uint64_t falco_engine::get_formatter_cache_misses() const {
+	return m_formatter_cache_misses.load();
+}
+
+bool falco_engine::process_event(std::size_t source_idx,
+                                 sinsp_evt *ev,
+                                 uint16_t ruleset_id,
+                                 falco_common::rule_matching strategy,
+                                 std::vector<const falco_rule *> &matches) {
 	// note: there are no thread-safety guarantees on the filter_ruleset::run()
 	// method, but the thread-safety assumptions of falco_engine::process_event()
 	// imply that concurrent invokers use different and non-switchable values of
@@ -382,43 +420,125 @@ std::unique_ptr<std::vector<falco_engine::rule_result>> falco_engine::process_ev
 
 	const falco_source *source = find_source(source_idx);
 
+	matches.clear();
 	if(should_drop_evt() || !source) {
-		return nullptr;
+		return false;
 	}
 
+	return run_ruleset(*source, ev, ruleset_id, strategy, matches);
+}
+
+bool falco_engine::run_ruleset(const falco_source &source,
+                               sinsp_evt *ev,
+                               uint16_t ruleset_id,
+                               falco_common::rule_matching strategy,
+                               std::vector<const falco_rule *> &matches) {
 	switch(strategy) {
 	case falco_common::rule_matching::ALL:
-		if(source->m_rules.size() > 0) {
-			source->m_rules.clear();
+		if(!source.ruleset->run(ev, matches, ruleset_id)) {
+			return false;
 		}
-		if(!source->ruleset->run(ev, source->m_rules, ruleset_id)) {
-			return nullptr;
+		break;
+	case falco_common::rule_matching::FIRST: {
+		const falco_rule *match = nullptr;
+		if(!source.ruleset->run(ev, match, ruleset_id)) {
+			return false;
 		}
+		matches.push_back(match);
 		break;
-	case falco_common::rule_matching::FIRST:
-		if(source->m_rules.size() != 1) {
-			source->m_rules.resize(1);
+	}
+	}
+
+	for(const auto *rule : matches) {
+		m_rule_stats_manager.on_event(*rule);
+	}
+
+	return true;
+}
+
+bool falco_engine::process_events(std::size_t source_idx,
+                                  sinsp_evt *const *evts,
+                                  std::size_t num_evts,
+                                  uint16_t ruleset_id,
+                                  falco_common::rule_matching strategy,
+                                  std::vector<event_match> &matches) {
+	// note: this has the same thread-safety assumptions of process_event(),
+	// so the batch buffers of the source are only accessed by one thread
+	const falco_source *source = find_source(source_idx);
+
+	matches.clear();
+	if(!source) {
+		return false;
+	}
+
+	// sorting by type and then by position keeps the events of each
+	// type in the order they came
+	auto &order = source->m_batch_order;
+	order.clear();
+	for(std::size_t i = 0; i < num_evts; i++) {
+		if(!should_drop_evt()) {
+			order.emplace_back(evts[i]->get_type(), i);
 		}
-		if(!source->ruleset->run(ev, source->m_rules[0], ruleset_id)) {
-			return nullptr;
+	}
+	std::sort(order.begin(), order.end());
+
+	// the matches of each event are stored contiguously, and each event
+	// slot records where they are
+	auto &batch_matches = source->m_batch_matches;
+	auto &slots = source->m_batch_slots;
+	batch_matches.clear();
+	slots.assign(num_evts, {0, 0});
+	auto &evt_matches = source->m_matches;
+	for(const auto &evt : order) {
+		evt_matches.clear();
+		if(run_ruleset(*source, evts[evt.second], ruleset_id, strategy, evt_matches)) {
+			slots[evt.second] = {batch_matches.size(), evt_matches.size()};
+			batch_matches.insert(batch_matches.end(), evt_matches.begin(), evt_matches.end());
 		}
-		break;
+	}
+
+	// report the matches in the order of the events
+	for(std::size_t i = 0; i < num_evts; i++) {
+		for(std::size_t j = 0; j < slots[i].second; j++) {
+			matches.push_back({i, batch_matches[slots[i].first + j]});
+		}
+	}
+
+	return !matches.empty();
+}
+
+bool falco_engine::process_events(std::size_t source_idx,
+                                  sinsp_evt *const *evts,
+                                  std::size_t num_evts,
+                                  falco_common::rule_matching strategy,
+                                  std::vector<event_match> &matches) {
+	return process_events(source_idx, evts, num_evts, m_default_ruleset_id, strategy, matches);
+}
+
+std::unique_ptr<std::vector<falco_engine::rule_result>> falco_engine::process_event(
+        std::size_t source_idx,
+        sinsp_evt *ev,
+        uint16_t ruleset_id,
+        falco_common::rule_matching strategy) {
+	const falco_source *source = find_source(source_idx);
+
+	if(!process_event(source_idx, ev, ruleset_id, strategy, source->m_matches)) {
+		return nullptr;
 	}
 
 	auto res = std::make_unique<std::vector<falco_engine::rule_result>>();
-	for(const auto &rule : source->m_rules) {
+	for(const auto *rule : source->m_matches) {
 		rule_result rule_result;
 		rule_result.evt = ev;
-		rule_result.rule = rule.name;
-		rule_result.source = rule.source;
-		rule_result.format = rule.output;
-		rule_result.priority_num = rule.priority;
-		rule_result.capture = rule.capture;
-		rule_result.capture_duration_ns = uint64_t(rule.capture_duration) * 1000000LL;
-		rule_result.tags = rule.tags;
-		rule_result.exception_fields = rule.exception_fields;
-		rule_result.extra_output_fields = rule.extra_output_fields;
-		m_rule_stats_manager.on_event(rule);
+		rule_result.rule = rule->name;
+		rule_result.source = rule->source;
+		rule_result.format = rule->output;
+		rule_result.priority_num = rule->priority;
+		rule_result.capture = rule->capture;
+		rule_result.capture_duration_ns = uint64_t(rule->capture_duration) * 1000000LL;
+		rule_result.tags = rule->tags;
+		rule_result.exception_fields = rule->exception_fields;
+		rule_result.extra_output_fields = rule->extra_output_fields;
 		res->push_back(rule_result);
 	}
 
@@ -432,6 +552,13 @@ std::unique_ptr<std::vector<falco_engine::rule_result>> falco_engine::process_ev
 	return process_event(source_idx, ev, m_default_ruleset_id, strategy);
 }
 
+bool falco_engine::process_event(std::size_t source_idx,
+                                 sinsp_evt *ev,
+                                 falco_common::rule_matching strategy,
+                                 std::vector<const falco_rule *> &matches) {
+	return process_event(source_idx, ev, m_default_ruleset_id, strategy, matches);
+}
+
 std::size_t falco_engine::add_source(
         const std::string &source,
         std::shared_ptr<sinsp_filter_factory> filter_factory,
@@ -650,6 +777,10 @@ void falco_engine::get_json_details(
 
 	// Store compiled condition and output
 	out["details"]["condition_compiled"] = libsinsp::filter::ast::as_string(r.condition.get());
+	if(r.optimized_condition) {
+		out["details"]["condition_optimized"] =
+		        libsinsp::filter::ast::as_string(r.optimized_condition.get());
+	}
 	out["details"]["output_compiled"] = r.output;
 
 	// Compute the plugins that are actually used by this rule. This is involves:
@@ -944,6 +1075,8 @@ std::shared_ptr<filter_ruleset> falco_engine::create_ruleset(
 	auto ret = ruleset_factory->new_ruleset();
 
 	ret->set_engine_state(m_engine_state);
+	ret->set_adaptive_ordering(m_adaptive_ordering);
+	ret->set_profiling(m_rule_profiling_sampling_ratio);
 
 	return ret;
 }
@@ -960,14 +1093,105 @@ void falco_engine::fill_engine_state_funcs(filter_ruleset::engine_state_funcs &e
 
 		return true;
 	};
+
+	engine_state.on_rule_evaluated = [this](const falco_rule &rule, uint64_t ns) {
+		m_rule_stats_manager.on_rule_evaluated(rule, ns);
+	};
 };
 
 void falco_engine::complete_rule_loading() const {
 	for(const auto &src : m_sources) {
 		src.ruleset->on_loading_complete();
+		src.m_formatters.clear();
+	}
+
+	auto cache_formatter = [](const falco_source *src, const std::string &format) {
+		if(format.empty() || src->m_formatters.count(format) > 0) {
+			return;
+		}
+		try {
+			src->m_formatters[format] = src->formatter_factory->create_formatter(format);
+		} catch(const std::exception &) {
+			// formats that can't be compiled here will fail again (and
+			// be reported) when create_formatter() is invoked for them
+		}
+	};
+
+	// Cache the prefix formats of all the priorities, for both time formats
+	for(const auto &src : m_sources) {
+		for(int p = falco_common::PRIORITY_EMERGENCY; p <= falco_common::PRIORITY_DEBUG; p++) {
+			auto level = falco_common::format_priority((falco_common::priority_type)p);
+			cache_formatter(&src, falco_formats::prefix_format(level, false));
+			cache_formatter(&src, falco_formats::prefix_format(level, true));
+		}
+	}
+
+	// Cache the message format and the extra output fields of each rule,
+	// exactly as they are passed to create_formatter() when formatting alerts
+	for(const auto &rule : m_rules) {
+		auto src = m_sources.at(rule.source);
+		if(src == nullptr) {
+			continue;
+		}
+		cache_formatter(src, falco_formats::lenient_format(rule.output));
+		for(const auto &ef : rule.extra_output_fields) {
+			if(!ef.second.first.empty()) {
+				cache_formatter(src, falco_formats::lenient_format(ef.second.first));
+			}
+		}
+	}
+}
+
+void falco_engine::set_adaptive_rule_ordering(
+        const filter_ruleset::adaptive_ordering_config &config) {
+	m_adaptive_ordering = config;
+	for(auto &src : m_sources) {
+		src.ruleset->set_adaptive_ordering(m_adaptive_ordering);
+	}
+}
+
+filter_ruleset::adaptive_ordering_stats falco_engine::get_adaptive_rule_ordering_stats() const {
+	filter_ruleset::adaptive_ordering_stats res;
+	for(const auto &src : m_sources) {
+		auto stats = src.ruleset->get_adaptive_ordering_stats();
+		res.num_reorders += stats.num_reorders;
+		res.estimated_saved_ns += stats.estimated_saved_ns;
+	}
+	return res;
+}
+
+void falco_engine::set_rule_profiling(uint32_t sampling_ratio) {
+	m_rule_profiling_sampling_ratio = sampling_ratio;
+	for(auto &src : m_sources) {
+		src.ruleset->set_profiling(m_rule_profiling_sampling_ratio);
 	}
 }
 
+void falco_engine::set_filter_cache(bool enabled) {
+	m_filter_cache_enabled = enabled;
+}
+
+void falco_engine::set_condition_optimizer(bool enabled) {
+	m_condition_optimizer = enabled;
+}
+
+void falco_engine::set_string_predicate_folding(bool enabled) {
+	m_string_predicate_folding = enabled;
+}
+
+sinsp_filter_cache_metrics falco_engine::get_filter_cache_metrics() const {
+	sinsp_filter_cache_metrics res;
+	for(const auto &src : m_sources) {
+		if(src.filter_cache_metrics) {
+			res.m_num_extract += src.filter_cache_metrics->m_num_extract;
+			res.m_num_extract_cache += src.filter_cache_metrics->m_num_extract_cache;
+			res.m_num_compare += src.filter_cache_metrics->m_num_compare;
+			res.m_num_compare_cache += src.filter_cache_metrics->m_num_compare_cache;
+		}
+	}
+	return res;
+}
+
 void falco_engine::set_sampling_ratio(uint32_t sampling_ratio) {
 	m_sampling_ratio = sampling_ratio;
 }
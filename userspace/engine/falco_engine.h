@@ -134,6 +134,8 @@ public:
 	// setup, and does not affect the functional behavior.
 	// Internally, this can be used to release unused resources before starting
 	// processing events with process_event().
+	// This also creates and caches the formatters of all the loaded rule
+	// outputs, which are then returned by create_formatter().
 	//
 	void complete_rule_loading() const;
 
@@ -177,6 +179,59 @@ public:
 	//
 	const stats_manager &get_rule_stats_manager() const;
 
+	//
+	// Configure the adaptive ordering of rules for all the rulesets,
+	// including the ones created when loading rules afterwards.
+	// See filter_ruleset::set_adaptive_ordering() for more details.
+	//
+	void set_adaptive_rule_ordering(const filter_ruleset::adaptive_ordering_config &config);
+
+	//
+	// Return the adaptive ordering counters, summed across the
+	// rulesets of all sources.
+	//
+	filter_ruleset::adaptive_ordering_stats get_adaptive_rule_ordering_stats() const;
+
+	//
+	// Configure the profiling of rule evaluations for all the rulesets,
+	// including the ones created when loading rules afterwards. One
+	// event out of sampling_ratio has the evaluation time of each rule it
+	// goes through recorded in the rule stats manager, see
+	// stats_manager::get_profile_by_rule_id(). A sampling ratio of 0
+	// disables profiling.
+	//
+	void set_rule_profiling(uint32_t sampling_ratio);
+
+	//
+	// Enable or disable the field extraction cache for the rules loaded
+	// afterwards. When enabled, all the filters of a given source share
+	// the values of the fields they extract for the same event, so that
+	// each field is extracted only once per event regardless of how many
+	// rules use it.
+	//
+	void set_filter_cache(bool enabled);
+
+	//
+	// Enable or disable folding groups of contains, startswith and endswith
+	// comparisons on the same field into a single regex comparison, for the
+	// rules loaded afterwards. See filter_string_predicate_resolver.
+	//
+	void set_string_predicate_folding(bool enabled);
+
+	//
+	// Enable or disable the optimization of the conditions of the rules
+	// loaded afterwards. See filter_optimizer_resolver. The optimized
+	// conditions are reported as condition_optimized by describe_rule().
+	//
+	void set_condition_optimizer(bool enabled);
+
+	//
+	// Return the field extraction cache counters, summed across all
+	// sources. The counters are updated by the threads processing
+	// events without synchronization, and are approximate.
+	//
+	sinsp_filter_cache_metrics get_filter_cache_metrics() const;
+
 	//
 	// Set the sampling ratio, which can affect which events are
 	// matched against the set of rules.
@@ -270,6 +325,79 @@ public:
 	                                                        sinsp_evt *ev,
 	                                                        falco_common::rule_matching strategy);
 
+	//
+	// Same as process_event(), but the matching rules are reported as
+	// pointers to the rules owned by the rulesets instead of being copied
+	// into newly-allocated results. The matches vector is owned by the
+	// invoker, it is cleared at each call and can be reused across events,
+	// so that matching an event requires no allocation. The pointed rules
+	// remain valid until rules are loaded again.
+	// Returns true if at least one rule matched the event.
+	//
+	// This inherits the same thread-safety guarantees.
+	//
+	bool process_event(std::size_t source_idx,
+	                   sinsp_evt *ev,
+	                   uint16_t ruleset_id,
+	                   falco_common::rule_matching strategy,
+	                   std::vector<const falco_rule *> &matches);
+
+	//
+	// Wrapper assuming the default ruleset.
+	//
+	// This inherits the same thread-safety guarantees.
+	//
+	bool process_event(std::size_t source_idx,
+	                   sinsp_evt *ev,
+	                   falco_common::rule_matching strategy,
+	                   std::vector<const falco_rule *> &matches);
+
+	//
+	// A rule matching one of the events passed to process_events()
+	//
+	struct event_match {
+		// Position of the event in the batch
+		std::size_t evt_index;
+		const falco_rule *rule;
+	};
+
+	//
+	// Same as process_event(), but for a batch of events of the same
+	// source. The events are evaluated grouped by event type, so that the
+	// filters of each event type stay hot in the CPU caches, and the
+	// sampling ratio is applied to each event individually. The matches
+	// are reported ordered by event, and in the same order as
+	// process_event() would report them for each event. The matches
+	// vector is owned by the invoker, it is cleared at each call and can
+	// be reused across batches.
+	// Returns true if at least one rule matched one of the events.
+	//
+	// All the events must be valid at the same time, which is not the
+	// case for the ones returned by consecutive sinsp::next() calls
+	// since the inspector reuses the same event object. This suits
+	// events that are owned by the invoker, such as the ones read ahead
+	// from a capture file.
+	//
+	// This inherits the same thread-safety guarantees.
+	//
+	bool process_events(std::size_t source_idx,
+	                    sinsp_evt *const *evts,
+	                    std::size_t num_evts,
+	                    uint16_t ruleset_id,
+	                    falco_common::rule_matching strategy,
+	                    std::vector<event_match> &matches);
+
+	//
+	// Wrapper assuming the default ruleset.
+	//
+	// This inherits the same thread-safety guarantees.
+	//
+	bool process_events(std::size_t source_idx,
+	                    sinsp_evt *const *evts,
+	                    std::size_t num_evts,
+	                    falco_common::rule_matching strategy,
+	                    std::vector<event_match> &matches);
+
 	//
 	// Configure the engine to support events with the provided
 	// source, with the provided filter factory and formatter factory.
@@ -349,11 +477,19 @@ public:
 	//
 	// Given a source and output string, return an
 	// sinsp_evt_formatter that can format output strings for an
-	// event.
+	// event. Formatters cached by complete_rule_loading() are
+	// returned without being created again.
 	//
 	std::shared_ptr<sinsp_evt_formatter> create_formatter(const std::string &source,
 	                                                      const std::string &output) const;
 
+	//
+	// Return the number of create_formatter() calls that have been
+	// served from (hits) or that missed (misses) the formatters cache.
+	//
+	uint64_t get_formatter_cache_hits() const;
+	uint64_t get_formatter_cache_misses() const;
+
 	// The rule loader definition is aliased as it is exactly what we need
 	typedef rule_loader::plugin_version_info::requirement plugin_version_requirement;
 
@@ -378,7 +514,21 @@ private:
 	// Functions to retrieve state from this engine
 	void fill_engine_state_funcs(filter_ruleset::engine_state_funcs &engine_state);
 
+	// Evaluate an event against the ruleset of a source and account
+	// the matches in the rule stats, shared by process_event() and
+	// process_events()
+	bool run_ruleset(const falco_source &source,
+	                 sinsp_evt *ev,
+	                 uint16_t ruleset_id,
+	                 falco_common::rule_matching strategy,
+	                 std::vector<const falco_rule *> &matches);
+
 	filter_ruleset::engine_state_funcs m_engine_state;
+	filter_ruleset::adaptive_ordering_config m_adaptive_ordering;
+	uint32_t m_rule_profiling_sampling_ratio = 0;
+	bool m_filter_cache_enabled = false;
+	bool m_string_predicate_folding = false;
+	bool m_condition_optimizer = false;
 
 	indexed_vector<falco_source> m_sources;
 
@@ -453,6 +603,9 @@ private:
 	std::shared_ptr<rule_loader::compiler> m_rule_compiler;
 	stats_manager m_rule_stats_manager;
 
+	mutable std::atomic<uint64_t> m_formatter_cache_hits;
+	mutable std::atomic<uint64_t> m_formatter_cache_misses;
+
 	uint16_t m_next_ruleset_id;
 	std::map<std::string, uint16_t> m_known_rulesets;
 	falco_common::priority_type m_min_priority;
@@ -113,5 +113,8 @@ struct falco_rule {
 	bool capture;
 	uint32_t capture_duration;
 	std::shared_ptr<libsinsp::filter::ast::expr> condition;
+	// The condition the filter has been compiled from, if it has been
+	// rewritten by the condition optimizations, or nullptr
+	std::shared_ptr<libsinsp::filter::ast::expr> optimized_condition;
 	std::shared_ptr<sinsp_filter> filter;
 };
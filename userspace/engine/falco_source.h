@@ -18,6 +18,9 @@ limitations under the License.
 #pragma once
 
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "filter_ruleset.h"
 
 /*!
@@ -34,13 +37,17 @@ struct falco_source {
 	        ruleset(s.ruleset),
 	        ruleset_factory(s.ruleset_factory),
 	        filter_factory(s.filter_factory),
-	        formatter_factory(s.formatter_factory) {};
+	        formatter_factory(s.formatter_factory),
+	        filter_cache_factory(s.filter_cache_factory),
+	        filter_cache_metrics(s.filter_cache_metrics) {};
 	falco_source& operator=(const falco_source& s) {
 		name = s.name;
 		ruleset = s.ruleset;
 		ruleset_factory = s.ruleset_factory;
 		filter_factory = s.filter_factory;
 		formatter_factory = s.formatter_factory;
+		filter_cache_factory = s.filter_cache_factory;
+		filter_cache_metrics = s.filter_cache_metrics;
 		return *this;
 	};
 
@@ -50,9 +57,29 @@ struct falco_source {
 	std::shared_ptr<sinsp_filter_factory> filter_factory;
 	std::shared_ptr<sinsp_evt_formatter_factory> formatter_factory;
 
-	// Used by the filter_ruleset interface. Filled in when a rule
-	// matches an event.
-	mutable std::vector<falco_rule> m_rules;
+	// Shared by all the filters compiled for this source, so that a field
+	// extracted by a rule is reused by the other rules evaluated for the
+	// same event. Null when the field extraction cache is disabled.
+	std::shared_ptr<sinsp_filter_cache_factory> filter_cache_factory;
+	std::shared_ptr<sinsp_filter_cache_metrics> filter_cache_metrics;
+
+	// Used by the filter_ruleset interface. Filled in with the rules
+	// matching an event, and reused across events.
+	mutable std::vector<const falco_rule *> m_matches;
+
+	// Used by falco_engine::process_events(), and reused across batches.
+	// Filled in with the type and position of the events of a batch in
+	// evaluation order, with the rules matching the events in the same
+	// order, and with the offset and count of the matches of each event.
+	mutable std::vector<std::pair<uint16_t, std::size_t>> m_batch_order;
+	mutable std::vector<const falco_rule *> m_batch_matches;
+	mutable std::vector<std::pair<std::size_t, std::size_t>> m_batch_slots;
+
+	// Formatters created once all rules are loaded, indexed by their
+	// format string. Filled in by falco_engine::complete_rule_loading()
+	// and only read afterwards, so that alerts don't need to parse
+	// their output formats again.
+	mutable std::unordered_map<std::string, std::shared_ptr<sinsp_evt_formatter>> m_formatters;
 
 	inline bool is_valid_lhs_field(const std::string& field) const {
 		// if there's at least one parenthesis we may be parsing a field
@@ -22,6 +22,7 @@ limitations under the License.
 #include <libsinsp/utils.h>
 
 #include <re2/re2.h>
+#include <zlib.h>
 #if defined(__linux__) and !defined(MINIMAL_BUILD) and !defined(__EMSCRIPTEN__)
 #include <openssl/evp.h>
 #endif
@@ -192,6 +193,29 @@ std::string wrap_text(const std::string& in, uint32_t indent, uint32_t line_len)
 	return os.str();
 }
 
+bool gzip_compress(const std::string& in, std::string& out) {
+	z_stream zs{};
+	// 16 added to the window bits selects the gzip format
+	if(deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) !=
+	   Z_OK) {
+		out.clear();
+		return false;
+	}
+	out.resize(deflateBound(&zs, in.size()));
+	zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+	zs.avail_in = static_cast<uInt>(in.size());
+	zs.next_out = reinterpret_cast<Bytef*>(out.data());
+	zs.avail_out = static_cast<uInt>(out.size());
+	int ret = deflate(&zs, Z_FINISH);
+	out.resize(zs.total_out);
+	deflateEnd(&zs);
+	if(ret != Z_STREAM_END) {
+		out.clear();
+		return false;
+	}
+	return true;
+}
+
 uint32_t hardware_concurrency() {
 	auto hc = std::thread::hardware_concurrency();
 	return hc ? hc : 1;
@@ -36,6 +36,10 @@ std::string wrap_text(const std::string& in, uint32_t indent, uint32_t linelen);
 
 void readfile(const std::string& filename, std::string& data);
 
+// Compress the input into a gzip stream, suitable for "Content-Encoding: gzip".
+// On failure, the output is left empty.
+bool gzip_compress(const std::string& in, std::string& out);
+
 uint32_t hardware_concurrency();
 
 bool matches_wildcard(const std::string& pattern, const std::string& s);
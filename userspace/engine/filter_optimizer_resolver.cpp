@@ -0,0 +1,234 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <algorithm>
+#include <unordered_set>
+#include "filter_optimizer_resolver.h"
+
+using namespace libsinsp::filter;
+
+static inline bool has_prefix(const std::string& s, const char* prefix) {
+	return s.rfind(prefix, 0) == 0;
+}
+
+// Fields read directly from the event header
+static inline bool is_cheap_field(const std::string& f) {
+	return f == "evt.type" || f == "evt.num" || f == "evt.dir" || f == "evt.cpu" ||
+	       f == "evt.source";
+}
+
+// Fields walking the process tree
+static const std::unordered_set<std::string> s_process_tree_fields = {
+        "proc.aname",
+        "proc.apid",
+        "proc.aexe",
+        "proc.aexepath",
+        "proc.acmdline",
+        "proc.aenv",
+        "proc.sname",
+        "proc.vpgid.name",
+        "proc.vpgid.exe",
+        "proc.vpgid.exepath",
+};
+
+// Fields requiring lookups in the container, k8s or users tables, or walking
+// the process tree
+static inline bool is_expensive_field(const std::string& f) {
+	return has_prefix(f, "container.") || has_prefix(f, "k8s.") || has_prefix(f, "user.") ||
+	       has_prefix(f, "group.") || s_process_tree_fields.count(f) > 0;
+}
+
+static uint64_t operator_cost(const std::string& op) {
+	if(op == "regex") {
+		return 16;
+	}
+	if(op == "glob") {
+		return 12;
+	}
+	if(op == "contains" || op == "icontains" || op == "bcontains" || op == "endswith" ||
+	   op == "pmatch" || op == "intersects") {
+		return 4;
+	}
+	if(op == "startswith" || op == "bstartswith") {
+		return 3;
+	}
+	return 1;
+}
+
+static uint64_t field_cost(const ast::expr* e) {
+	if(auto f = dynamic_cast<const ast::field_expr*>(e)) {
+		if(is_cheap_field(f->field)) {
+			return 1;
+		}
+		return is_expensive_field(f->field) ? 16 : 4;
+	}
+	if(auto t = dynamic_cast<const ast::field_transformer_expr*>(e)) {
+		return 4 + field_cost(t->value.get());
+	}
+	return 4;
+}
+
+uint64_t filter_optimizer_resolver::estimate_cost(const ast::expr* e) {
+	if(auto c = dynamic_cast<const ast::binary_check_expr*>(e)) {
+		// comparisons between two fields extract both
+		uint64_t cost = field_cost(c->left.get()) * operator_cost(c->op);
+		if(dynamic_cast<const ast::value_expr*>(c->right.get()) == nullptr &&
+		   dynamic_cast<const ast::list_expr*>(c->right.get()) == nullptr) {
+			cost += field_cost(c->right.get());
+		}
+		return cost;
+	}
+	if(auto c = dynamic_cast<const ast::unary_check_expr*>(e)) {
+		return field_cost(c->left.get());
+	}
+	if(auto n = dynamic_cast<const ast::not_expr*>(e)) {
+		return estimate_cost(n->child.get());
+	}
+	const std::vector<std::unique_ptr<ast::expr>>* children = nullptr;
+	if(auto a = dynamic_cast<const ast::and_expr*>(e)) {
+		children = &a->children;
+	} else if(auto o = dynamic_cast<const ast::or_expr*>(e)) {
+		children = &o->children;
+	}
+	if(children != nullptr) {
+		uint64_t cost = 0;
+		for(const auto& c : *children) {
+			cost += estimate_cost(c.get());
+		}
+		return cost;
+	}
+	return 4;
+}
+
+bool filter_optimizer_resolver::run(std::shared_ptr<libsinsp::filter::ast::expr>& filter) const {
+	visitor v;
+	filter->accept(&v);
+	if(v.m_node_substitute) {
+		filter = std::move(v.m_node_substitute);
+	}
+	return v.m_changed;
+}
+
+template<typename T>
+void filter_optimizer_resolver::visitor::flatten(T* e) {
+	std::vector<std::unique_ptr<ast::expr>> children;
+	std::unordered_set<std::string> seen;
+	for(auto& c : e->children) {
+		c->accept(this);
+		if(m_node_substitute) {
+			c = std::move(m_node_substitute);
+		}
+
+		std::vector<std::unique_ptr<ast::expr>> merged;
+		if(auto same = dynamic_cast<T*>(c.get())) {
+			merged = std::move(same->children);
+			m_changed = true;
+		} else {
+			merged.push_back(std::move(c));
+		}
+
+		for(auto& m : merged) {
+			// a and a = a, a or a = a
+			if(!seen.insert(ast::as_string(m.get())).second) {
+				m_changed = true;
+				continue;
+			}
+			children.push_back(std::move(m));
+		}
+	}
+	e->children = std::move(children);
+	m_node_substitute = nullptr;
+}
+
+void filter_optimizer_resolver::visitor::visit(ast::and_expr* e) {
+	flatten(e);
+
+	// all the children are evaluated when none of them is false, and the
+	// evaluation stops at the first false one otherwise, so the cheap
+	// ones are evaluated first
+	std::vector<uint64_t> costs;
+	std::vector<size_t> order;
+	for(size_t i = 0; i < e->children.size(); i++) {
+		costs.push_back(estimate_cost(e->children[i].get()));
+		order.push_back(i);
+	}
+	std::stable_sort(order.begin(), order.end(), [&costs](size_t a, size_t b) {
+		return costs[a] < costs[b];
+	});
+	if(!std::is_sorted(order.begin(), order.end())) {
+		std::vector<std::unique_ptr<ast::expr>> children;
+		for(auto i : order) {
+			children.push_back(std::move(e->children[i]));
+		}
+		e->children = std::move(children);
+		m_changed = true;
+	}
+
+	if(e->children.size() == 1) {
+		m_node_substitute = std::move(e->children[0]);
+		m_changed = true;
+	}
+}
+
+void filter_optimizer_resolver::visitor::visit(ast::or_expr* e) {
+	flatten(e);
+	if(e->children.size() == 1) {
+		m_node_substitute = std::move(e->children[0]);
+		m_changed = true;
+	}
+}
+
+void filter_optimizer_resolver::visitor::visit(ast::not_expr* e) {
+	e->child->accept(this);
+	if(m_node_substitute) {
+		e->child = std::move(m_node_substitute);
+	}
+
+	// not not a = a
+	if(auto n = dynamic_cast<ast::not_expr*>(e->child.get())) {
+		m_node_substitute = std::move(n->child);
+		m_changed = true;
+	}
+}
+
+void filter_optimizer_resolver::visitor::visit(ast::list_expr* e) {
+	m_node_substitute = nullptr;
+}
+
+void filter_optimizer_resolver::visitor::visit(ast::binary_check_expr* e) {
+	m_node_substitute = nullptr;
+}
+
+void filter_optimizer_resolver::visitor::visit(ast::unary_check_expr* e) {
+	m_node_substitute = nullptr;
+}
+
+void filter_optimizer_resolver::visitor::visit(ast::value_expr* e) {
+	m_node_substitute = nullptr;
+}
+
+void filter_optimizer_resolver::visitor::visit(ast::field_expr* e) {
+	m_node_substitute = nullptr;
+}
+
+void filter_optimizer_resolver::visitor::visit(ast::field_transformer_expr* e) {
+	m_node_substitute = nullptr;
+}
+
+void filter_optimizer_resolver::visitor::visit(ast::identifier_expr* e) {
+	m_node_substitute = nullptr;
+}
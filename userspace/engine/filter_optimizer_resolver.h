@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <libsinsp/filter/parser.h>
+#include <string>
+#include <memory>
+
+/*!
+    \brief Rewrites a filter AST into an equivalent one that is cheaper
+    to evaluate. Nested and/or expressions are flattened, duplicate
+    children of and/or expressions and double negations are removed, and
+    the children of and expressions are sorted by their estimated
+    evaluation cost, so that cheap checks such as the ones on evt.type
+    can short-circuit the expensive ones.
+*/
+class filter_optimizer_resolver {
+public:
+	/*!
+	    \brief Visits a filter AST and optimizes it.
+	    \param filter The filter AST to be processed. Note that the pointer
+	    is passed by reference and may be transformed in order to apply
+	    the optimizations. Callers should pass a clone if they need to
+	    preserve the original AST, since it's modified in place.
+	    \return true if the filter AST has been changed
+	*/
+	bool run(std::shared_ptr<libsinsp::filter::ast::expr>& filter) const;
+
+	/*!
+	    \brief Returns the estimated evaluation cost of a filter AST, in
+	    arbitrary units. This only accounts for the kind of fields,
+	    transformers and operators it uses.
+	*/
+	static uint64_t estimate_cost(const libsinsp::filter::ast::expr* e);
+
+private:
+	struct visitor : public libsinsp::filter::ast::expr_visitor {
+		visitor(): m_changed(false) {}
+		visitor(visitor&&) = default;
+		visitor& operator=(visitor&&) = default;
+		visitor(const visitor&) = delete;
+		visitor& operator=(const visitor&) = delete;
+
+		bool m_changed;
+		std::unique_ptr<libsinsp::filter::ast::expr> m_node_substitute;
+
+		void visit(libsinsp::filter::ast::and_expr* e) override;
+		void visit(libsinsp::filter::ast::or_expr* e) override;
+		void visit(libsinsp::filter::ast::not_expr* e) override;
+		void visit(libsinsp::filter::ast::identifier_expr* e) override;
+		void visit(libsinsp::filter::ast::value_expr* e) override;
+		void visit(libsinsp::filter::ast::list_expr* e) override;
+		void visit(libsinsp::filter::ast::unary_check_expr* e) override;
+		void visit(libsinsp::filter::ast::binary_check_expr* e) override;
+		void visit(libsinsp::filter::ast::field_expr* e) override;
+		void visit(libsinsp::filter::ast::field_transformer_expr* e) override;
+
+		// Visits the children of an and/or expression, and merges
+		// the ones of the same kind and the duplicate ones.
+		template<typename T>
+		void flatten(T* e);
+	};
+};
@@ -24,3 +24,29 @@ void filter_ruleset::set_engine_state(const filter_ruleset::engine_state_funcs&
 filter_ruleset::engine_state_funcs& filter_ruleset::get_engine_state() {
 	return m_engine_state;
 }
+
+bool filter_ruleset::run(sinsp_evt* evt, const falco_rule*& match, uint16_t ruleset_id) {
+	if(m_copied_matches.size() != 1) {
+		m_copied_matches.resize(1);
+	}
+	if(!run(evt, m_copied_matches[0], ruleset_id)) {
+		return false;
+	}
+	match = &m_copied_matches[0];
+	return true;
+}
+
+bool filter_ruleset::run(sinsp_evt* evt,
+                         std::vector<const falco_rule*>& matches,
+                         uint16_t ruleset_id) {
+	std::vector<falco_rule> copies;
+	if(!run(evt, copies, ruleset_id)) {
+		return false;
+	}
+	m_copied_matches.clear();
+	for(auto& rule : copies) {
+		m_copied_matches.push_back(std::move(rule));
+		matches.push_back(&m_copied_matches.back());
+	}
+	return true;
+}
@@ -24,6 +24,8 @@ limitations under the License.
 #include <libsinsp/event.h>
 #include <libsinsp/events/sinsp_events.h>
 
+#include <deque>
+
 /*!
     \brief Manages a set of rulesets. A ruleset is a set of
     enabled rules that is able to process events and find matches for those rules.
@@ -37,11 +39,36 @@ public:
 		using ruleset_retriever_func_t =
 		        std::function<bool(const std::string &, std::shared_ptr<filter_ruleset> &ruleset)>;
 
+		using rule_evaluated_func_t = std::function<void(const falco_rule &rule, uint64_t ns)>;
+
 		ruleset_retriever_func_t get_ruleset;
+
+		// Invoked for each rule evaluation profiled by the ruleset,
+		// see set_profiling()
+		rule_evaluated_func_t on_rule_evaluated;
 	};
 
 	enum class match_type { exact, substring, wildcard };
 
+	// Settings for the adaptive ordering of rules, see set_adaptive_ordering()
+	struct adaptive_ordering_config {
+		bool enabled = false;
+		// One evaluation out of sampling_ratio is timed for each
+		// group of rules
+		uint32_t sampling_ratio = 64;
+		// Each group of rules is reordered after this many evaluations
+		uint64_t reorder_interval = 100000;
+	};
+
+	// Counters reported by rulesets supporting adaptive ordering
+	struct adaptive_ordering_stats {
+		// Number of times a group of rules has been reordered
+		uint64_t num_reorders = 0;
+		// Estimated evaluation time saved compared to the rules
+		// definition order, in nanoseconds
+		uint64_t estimated_saved_ns = 0;
+	};
+
 	virtual ~filter_ruleset() = default;
 
 	void set_engine_state(const engine_state_funcs &engine_state);
@@ -119,6 +146,67 @@ public:
 	*/
 	virtual bool run(sinsp_evt *evt, std::vector<falco_rule> &matches, uint16_t ruleset_id) = 0;
 
+	/*!
+	    \brief Same as run(evt, match, ruleset_id), but the matching rule is
+	    reported as a pointer instead of being copied. The pointed rule is
+	    owned by the ruleset and must not be retained after the ruleset is
+	    modified or destroyed. The default implementation relies on the
+	    copying version of run(), and the pointer is only valid until
+	    the next call to run().
+	    \return true if a match is found, false otherwise
+	    \param evt The event to be processed
+	    \param match If true is returned, this points to the first rule
+	    that matched the event
+	    \param ruleset_id The id of the ruleset to be used
+	*/
+	virtual bool run(sinsp_evt *evt, const falco_rule *&match, uint16_t ruleset_id);
+
+	/*!
+	    \brief Same as run(evt, matches, ruleset_id), but the matching rules
+	    are reported as pointers instead of being copied. Pointers are
+	    appended to matches, so that the same vector can be reused across
+	    events without allocating. The same lifetime considerations of
+	    run(evt, match, ruleset_id) apply to the pointed rules.
+	    \return true if a match is found, false otherwise
+	    \param evt The event to be processed
+	    \param matches If true is returned, this is filled-out with pointers
+	    to all the rules that matched the event
+	    \param ruleset_id The id of the ruleset to be used
+	*/
+	virtual bool run(sinsp_evt *evt,
+	                 std::vector<const falco_rule *> &matches,
+	                 uint16_t ruleset_id);
+
+	/*!
+	    \brief Configures the adaptive ordering of rules. When enabled, the
+	    ruleset may periodically change the order in which rules are evaluated
+	    when looking for the first rule matching an event, based on their
+	    observed evaluation cost and match rate, so that less CPU is spent
+	    before finding a match. When multiple rules match the same event, this
+	    may change which of them is reported first. This does not affect
+	    looking for all the matching rules. The default implementation
+	    ignores the setting.
+	    \param config The adaptive ordering settings
+	*/
+	virtual void set_adaptive_ordering(const adaptive_ordering_config &config) {}
+
+	/*!
+	    \brief Returns the counters of the adaptive ordering of rules. This
+	    can be invoked concurrently with run().
+	*/
+	virtual adaptive_ordering_stats get_adaptive_ordering_stats() { return {}; }
+
+	/*!
+	    \brief Configures the profiling of rule evaluations. When enabled,
+	    one invocation of run() out of sampling_ratio times the evaluation of
+	    each rule it goes through, and reports it to the on_rule_evaluated
+	    function of the engine state. The default implementation ignores
+	    the setting.
+	    \param sampling_ratio The profiling sampling ratio, or 0 to disable
+	    profiling
+	*/
+	virtual void set_profiling(uint32_t sampling_ratio) {}
+
 	/*!
 	    \brief Returns the number of rules enabled in a given ruleset
 	    \param ruleset_id The id of the ruleset to be used
@@ -205,6 +293,13 @@ public:
 	*/
 	virtual void disable_tags(const std::set<std::string> &tags, uint16_t ruleset_id) = 0;
 
+protected:
+	// Used by the default implementations of the non-copying run()
+	// methods, which hand out pointers to these rules. A deque is used so
+	// that pointers to its elements stay valid when new matches are
+	// appended.
+	std::deque<falco_rule> m_copied_matches;
+
 private:
 	engine_state_funcs m_engine_state;
 };
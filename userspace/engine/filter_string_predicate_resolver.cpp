@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <re2/re2.h>
+#include <unordered_map>
+#include <vector>
+#include "filter_string_predicate_resolver.h"
+
+using namespace libsinsp::filter;
+
+static inline bool is_foldable_operator(const std::string& op) {
+	return op == "contains" || op == "startswith" || op == "endswith";
+}
+
+// Returns the regex matching the same values as the given comparison.
+// \C matches any byte, unlike . which does not match invalid UTF-8.
+static std::string to_regex(const std::string& op, const std::string& value) {
+	auto quoted = RE2::QuoteMeta(value);
+	if(op == "startswith") {
+		return quoted + "\\C*";
+	}
+	if(op == "endswith") {
+		return "\\C*" + quoted;
+	}
+	return "\\C*" + quoted + "\\C*";
+}
+
+bool filter_string_predicate_resolver::run(libsinsp::filter::ast::expr& filter) const {
+	visitor v;
+	filter.accept(&v);
+	return v.m_folded;
+}
+
+void filter_string_predicate_resolver::visitor::visit(ast::or_expr* e) {
+	for(auto& c : e->children) {
+		c->accept(this);
+	}
+
+	// group the foldable comparisons by their left-hand side, which can
+	// be a field or a transformer
+	std::unordered_map<std::string, std::vector<size_t>> groups;
+	std::vector<std::string> group_order;
+	for(size_t i = 0; i < e->children.size(); i++) {
+		auto check = dynamic_cast<ast::binary_check_expr*>(e->children[i].get());
+		if(check == nullptr || !is_foldable_operator(check->op) ||
+		   dynamic_cast<ast::value_expr*>(check->right.get()) == nullptr) {
+			continue;
+		}
+		auto key = ast::as_string(check->left.get());
+		auto& group = groups[key];
+		if(group.empty()) {
+			group_order.push_back(key);
+		}
+		group.push_back(i);
+	}
+
+	std::vector<bool> removed(e->children.size(), false);
+	for(const auto& key : group_order) {
+		const auto& group = groups[key];
+		if(group.size() < min_group_size) {
+			continue;
+		}
+
+		std::string pattern;
+		for(auto i : group) {
+			auto check = static_cast<ast::binary_check_expr*>(e->children[i].get());
+			auto value = static_cast<ast::value_expr*>(check->right.get());
+			pattern += pattern.empty() ? "" : "|";
+			pattern += to_regex(check->op, value->value);
+		}
+		pattern = "^(?:" + pattern + ")$";
+
+		// the folded comparison takes the place of the first one
+		auto first = static_cast<ast::binary_check_expr*>(e->children[group[0]].get());
+		e->children[group[0]] = ast::binary_check_expr::create(ast::clone(first->left.get()),
+		                                                       "regex",
+		                                                       ast::value_expr::create(pattern));
+		for(size_t j = 1; j < group.size(); j++) {
+			removed[group[j]] = true;
+		}
+		m_folded = true;
+	}
+
+	std::vector<std::unique_ptr<ast::expr>> children;
+	for(size_t i = 0; i < e->children.size(); i++) {
+		if(!removed[i]) {
+			children.push_back(std::move(e->children[i]));
+		}
+	}
+	e->children = std::move(children);
+}
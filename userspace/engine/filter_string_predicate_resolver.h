@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <libsinsp/filter/parser.h>
+#include <string>
+#include <memory>
+
+/*!
+    \brief Folds groups of contains, startswith and endswith comparisons
+    on the same field inside an or expression into a single regex
+    comparison, so that the field is extracted and scanned once instead
+    of once for each comparison.
+*/
+class filter_string_predicate_resolver {
+public:
+	/*!
+	    \brief Minimum number of comparisons on the same field of an or
+	    expression for them to be folded.
+	*/
+	static constexpr size_t min_group_size = 4;
+
+	/*!
+	    \brief Visits a filter AST and folds the string comparisons that
+	    can be merged. The regex operator matches bytes even when the
+	    field values are not valid UTF-8, so the folded comparison is
+	    equivalent to the original ones.
+	    \param filter The filter AST to be processed. Note that the AST
+	    is modified in place, callers should pass a clone if they need
+	    to preserve the original one.
+	    \return true if at least one group of comparisons has been folded
+	*/
+	bool run(libsinsp::filter::ast::expr& filter) const;
+
+private:
+	struct visitor : public libsinsp::filter::ast::base_expr_visitor {
+		visitor(): m_folded(false) {}
+		visitor(visitor&&) = default;
+		visitor& operator=(visitor&&) = default;
+		visitor(const visitor&) = delete;
+		visitor& operator=(const visitor&) = delete;
+
+		bool m_folded;
+
+		void visit(libsinsp::filter::ast::or_expr* e) override;
+	};
+};
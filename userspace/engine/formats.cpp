@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "formats.h"
 #include "falco_engine.h"
+#include "alert_json_writer.h"
 
 falco_formats::falco_formats(std::shared_ptr<const falco_engine> engine,
                              bool json_include_output_property,
@@ -42,23 +43,11 @@ std::string falco_formats::format_event(sinsp_evt *evt,
                                         const std::string &format,
                                         const std::set<std::string> &tags,
                                         const std::string &hostname,
-                                        const extra_output_field_t &extra_fields) const {
-	std::string prefix_format;
-	std::string message_format = format;
-
-	if(m_time_format_iso_8601) {
-		prefix_format = "*%evt.time.iso8601: ";
-	} else {
-		prefix_format = "*%evt.time: ";
-	}
-	prefix_format += level;
-
-	if(message_format[0] != '*') {
-		message_format = "*" + message_format;
-	}
-
-	auto prefix_formatter = m_falco_engine->create_formatter(source, prefix_format);
-	auto message_formatter = m_falco_engine->create_formatter(source, message_format);
+                                        const extra_output_field_t &extra_fields,
+                                        std::map<std::string, std::string> *fields) const {
+	auto prefix_formatter =
+	        m_falco_engine->create_formatter(source, prefix_format(level, m_time_format_iso_8601));
+	auto message_formatter = m_falco_engine->create_formatter(source, lenient_format(format));
 
 	// The classic Falco output prefix with time and priority e.g. "13:53:31.726060287: Critical"
 	std::string prefix;
@@ -72,6 +61,20 @@ std::string falco_formats::format_event(sinsp_evt *evt,
 	// (proc_exe=bash)..."
 	std::string output = prefix + " " + message;
 
+	if(fields != nullptr) {
+		if(!message_formatter->get_field_values(evt, *fields)) {
+			throw falco_exception("Could not extract all field values from event");
+		}
+		for(auto const &ef : extra_fields) {
+			// when formatting the fields we always want strings,
+			// so we can simply format raw fields as string
+			if(ef.second.first.size() == 0) {
+				continue;
+			}
+			(*fields)[ef.first] = format_string(evt, lenient_format(ef.second.first), source);
+		}
+	}
+
 	if(message_formatter->get_output_format() == sinsp_evt_formatter::OF_NORMAL) {
 		return output;
 	} else if(message_formatter->get_output_format() == sinsp_evt_formatter::OF_JSON) {
@@ -85,13 +88,6 @@ std::string falco_formats::format_event(sinsp_evt *evt,
 		// Resolve prefix (e.g. time) fields
 		prefix_formatter->tostring(evt, json_fields_prefix);
 
-		// For JSON output, the formatter returned a json-as-text
-		// object containing all the fields in the original format
-		// message as well as the event time in ns. Use this to build
-		// a more detailed object containing the event time, rule,
-		// severity, full output, and fields.
-		nlohmann::json event;
-
 		// Convert the time-as-nanoseconds to a more json-friendly ISO8601.
 		time_t evttime = evt->get_ts() / 1000000000;
 		char time_sec[20];  // sizeof "YYYY-MM-DDTHH:MM:SS"
@@ -102,6 +98,118 @@ std::string falco_formats::format_event(sinsp_evt *evt,
 		snprintf(time_ns, sizeof(time_ns), ".%09luZ", evt->get_ts() % 1000000000);
 		iso8601evttime = time_sec;
 		iso8601evttime += time_ns;
+
+		// For JSON output, the formatter returned a json-as-text
+		// object containing all the fields in the original format
+		// message as well as the event time in ns. Use this to write
+		// a more detailed object containing the event time, rule,
+		// severity, full output, and fields. The object is written
+		// directly, with its keys in the sorted order of nlohmann::json.
+		thread_local alert_json_writer writer;
+		std::string json;
+		json.reserve(output.size() + message.size() + json_fields_message.size() + 256);
+		auto write_json = [&]() -> bool {
+			json += "{\"hostname\":";
+			if(!alert_json_writer::write_string(json, hostname)) {
+				return false;
+			}
+
+			if(m_json_include_message_property) {
+				json += ",\"message\":";
+				if(!alert_json_writer::write_string(json, message)) {
+					return false;
+				}
+			}
+
+			if(m_json_include_output_property) {
+				json += ",\"output\":";
+				if(!alert_json_writer::write_string(json, output)) {
+					return false;
+				}
+			}
+
+			if(m_json_include_output_fields_property) {
+				writer.clear_fields();
+				if(!writer.add_json_fields(json_fields_message) ||
+				   !writer.add_json_fields(json_fields_prefix)) {
+					return false;
+				}
+
+				for(auto const &ef : extra_fields) {
+					if(ef.second.first.size() == 0) {
+						continue;
+					}
+
+					std::string fformat = lenient_format(ef.second.first);
+
+					if(ef.second.second)  // raw field
+					{
+						std::string json_field_map;
+						auto field_formatter = m_falco_engine->create_formatter(source, fformat);
+						field_formatter->tostring_withformat(evt,
+						                                     json_field_map,
+						                                     sinsp_evt_formatter::OF_JSON);
+						if(!writer.add_json_field(ef.first, json_field_map)) {
+							return false;
+						}
+					} else if(fields != nullptr) {
+						// Already rendered, the last value of a key wins in both
+						if(!writer.add_string_field(ef.first, fields->at(ef.first))) {
+							return false;
+						}
+					} else if(!writer.add_string_field(ef.first,
+					                                   format_string(evt, fformat, source))) {
+						return false;
+					}
+				}
+
+				json += ",\"output_fields\":";
+				if(!writer.write_fields(json)) {
+					return false;
+				}
+			}
+
+			json += ",\"priority\":";
+			if(!alert_json_writer::write_string(json, level)) {
+				return false;
+			}
+			json += ",\"rule\":";
+			if(!alert_json_writer::write_string(json, rule)) {
+				return false;
+			}
+			json += ",\"source\":";
+			if(!alert_json_writer::write_string(json, source)) {
+				return false;
+			}
+
+			if(m_json_include_tags_property) {
+				json += ",\"tags\":[";
+				bool first = true;
+				for(const auto &tag : tags) {
+					if(!first) {
+						json += ',';
+					}
+					first = false;
+					if(!alert_json_writer::write_string(json, tag)) {
+						return false;
+					}
+				}
+				json += ']';
+			}
+
+			json += ",\"time\":";
+			alert_json_writer::write_string(json, iso8601evttime);
+			json += '}';
+			return true;
+		};
+		if(write_json()) {
+			return json;
+		}
+
+		// The writer rejects the few inputs it can't encode exactly as
+		// nlohmann::json does (e.g. invalid UTF-8), which are then
+		// encoded with it, to keep the same output and errors.
+		nlohmann::json event;
 		event["time"] = iso8601evttime;
 		event["rule"] = rule;
 		event["priority"] = level;
@@ -131,14 +239,11 @@ std::string falco_formats::format_event(sinsp_evt *evt,
 			}
 
 			for(auto const &ef : extra_fields) {
-				std::string fformat = ef.second.first;
-				if(fformat.size() == 0) {
+				if(ef.second.first.size() == 0) {
 					continue;
 				}
 
-				if(!(fformat[0] == '*')) {
-					fformat = "*" + fformat;
-				}
+				std::string fformat = lenient_format(ef.second.first);
 
 				if(ef.second.second)  // raw field
 				{
@@ -180,12 +285,7 @@ std::map<std::string, std::string> falco_formats::get_field_values(
         const std::string &format) const {
 	std::shared_ptr<sinsp_evt_formatter> formatter;
 
-	std::string fformat = format;
-	if(fformat[0] != '*') {
-		fformat = "*" + fformat;
-	}
-
-	formatter = m_falco_engine->create_formatter(source, fformat);
+	formatter = m_falco_engine->create_formatter(source, lenient_format(format));
 
 	std::map<std::string, std::string> ret;
 
@@ -195,3 +295,21 @@ std::map<std::string, std::string> falco_formats::get_field_values(
 
 	return ret;
 }
+
+std::string falco_formats::prefix_format(const std::string &level, bool time_format_iso_8601) {
+	std::string prefix_format;
+	if(time_format_iso_8601) {
+		prefix_format = "*%evt.time.iso8601: ";
+	} else {
+		prefix_format = "*%evt.time: ";
+	}
+	prefix_format += level;
+	return prefix_format;
+}
+
+std::string falco_formats::lenient_format(const std::string &format) {
+	if(format[0] != '*') {
+		return "*" + format;
+	}
+	return format;
+}
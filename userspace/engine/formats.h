@@ -31,6 +31,12 @@ public:
 	              bool time_format_iso_8601);
 	virtual ~falco_formats();
 
+	/*!
+	    \brief Formats the alert of a rule for the given event. If fields
+	    is not null, it is also filled with the values of the fields of the
+	    format and of the extra fields as strings, reusing the formatters
+	    and the extra fields rendered for the alert.
+	*/
 	std::string format_event(sinsp_evt *evt,
 	                         const std::string &rule,
 	                         const std::string &source,
@@ -38,7 +44,8 @@ public:
 	                         const std::string &format,
 	                         const std::set<std::string> &tags,
 	                         const std::string &hostname,
-	                         const extra_output_field_t &extra_fields) const;
+	                         const extra_output_field_t &extra_fields,
+	                         std::map<std::string, std::string> *fields = nullptr) const;
 
 	std::string format_string(sinsp_evt *evt,
 	                          const std::string &format,
@@ -48,6 +55,18 @@ public:
 	                                                    const std::string &source,
 	                                                    const std::string &format) const;
 
+	/*!
+	    \brief Returns the format string used to render the time/priority
+	    prefix of an alert with the given priority level.
+	*/
+	static std::string prefix_format(const std::string &level, bool time_format_iso_8601);
+
+	/*!
+	    \brief Returns the given format string prefixed with "*", so that
+	    fields with missing values don't prevent the formatting.
+	*/
+	static std::string lenient_format(const std::string &format);
+
 protected:
 	std::shared_ptr<const falco_engine> m_falco_engine;
 	bool m_json_include_output_property;
@@ -32,9 +32,14 @@ limitations under the License.
 #include <libsinsp/filter.h>
 #include <libsinsp/event.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <numeric>
 #include <string>
+#include <type_traits>
 
 // A filter_wrapper should implement these methods:
 //   const std::string &filter_wrapper::name();
@@ -105,6 +110,29 @@ public:
 		enable_disable_tags(tags, false, ruleset_id);
 	}
 
+	// Adaptive ordering is only applied to rulesets frozen with freeze()
+	void set_adaptive_ordering(const adaptive_ordering_config &config) override {
+		m_adaptive_ordering = config;
+		if(m_adaptive_ordering.sampling_ratio == 0) {
+			m_adaptive_ordering.sampling_ratio = 1;
+		}
+		if(m_adaptive_ordering.reorder_interval == 0) {
+			m_adaptive_ordering.enabled = false;
+		}
+	}
+
+	adaptive_ordering_stats get_adaptive_ordering_stats() override {
+		adaptive_ordering_stats stats;
+		stats.num_reorders = m_num_reorders.load(std::memory_order_relaxed);
+		stats.estimated_saved_ns = m_estimated_saved_ns.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	// Profiling is only applied to rulesets frozen with freeze()
+	void set_profiling(uint32_t sampling_ratio) override {
+		m_profiling_sampling_ratio = sampling_ratio;
+	}
+
 	// Note that subclasses do *not* implement run. Instead, they
 	// implement run_wrappers.
 	bool run(sinsp_evt *evt, falco_rule &match, uint16_t ruleset_id) override {
@@ -123,6 +151,26 @@ public:
 		return m_rulesets[ruleset_id]->run(*this, evt, matches);
 	}
 
+	bool run(sinsp_evt *evt, const falco_rule *&match, uint16_t ruleset_id) override {
+		if(m_rulesets.size() < (size_t)ruleset_id + 1) {
+			return false;
+		}
+
+		m_copied_matches.clear();
+		return m_rulesets[ruleset_id]->run(*this, evt, match);
+	}
+
+	bool run(sinsp_evt *evt,
+	         std::vector<const falco_rule *> &matches,
+	         uint16_t ruleset_id) override {
+		if(m_rulesets.size() < (size_t)ruleset_id + 1) {
+			return false;
+		}
+
+		m_copied_matches.clear();
+		return m_rulesets[ruleset_id]->run(*this, evt, matches);
+	}
+
 	typedef std::list<std::shared_ptr<filter_wrapper>> filter_wrapper_list;
 
 	// Subclasses should call add_wrapper (most likely from
@@ -148,6 +196,38 @@ public:
 		return num_filters;
 	}
 
+	// A filter and the rule it belongs to, as stored in the flat
+	// layout created by freeze().
+	struct frozen_filter {
+		sinsp_filter *filter;
+		const falco_rule *rule;
+	};
+
+	// Once all rules have been loaded and enabled, a subclass can
+	// call freeze (most likely from filter_ruleset::on_loading_complete)
+	// to copy the enabled filters of each ruleset into a flat layout:
+	// all the event type buckets of a ruleset are stored contiguously
+	// in a single pre-sized array of raw filter/rule pointers, which is
+	// much faster to iterate than the lists of shared pointers. When
+	// frozen, run() evaluates these filters directly instead of calling
+	// run_wrappers(), so subclasses should only call this if their
+	// run_wrappers() simply runs the filters and report their rules.
+	// The function passed to freeze returns the filter and rule of a
+	// wrapper, which must remain valid as long as the wrapper exists.
+	// Enabling or disabling rules afterwards freezes the affected
+	// rulesets again with the same function, so that they keep the
+	// flat layout, the adaptive ordering and the profiling.
+	typedef std::function<frozen_filter(const std::shared_ptr<filter_wrapper> &wrap)>
+	        filter_freeze_func;
+	void freeze(filter_freeze_func func) {
+		m_freeze_func = std::move(func);
+		for(const auto &ruleset_ptr : m_rulesets) {
+			if(ruleset_ptr) {
+				ruleset_ptr->freeze(m_freeze_func);
+			}
+		}
+	}
+
 	// A subclass must implement these methods. They are analogous
 	// to run() but take care of selecting filters that match a
 	// ruleset and possibly an event type.
@@ -160,7 +240,49 @@ public:
 	                          uint16_t ruleset_id,
 	                          falco_rule &match) = 0;
 
+	// Subclasses should also implement these methods, which report
+	// the matching rules as pointers to rules they own instead of
+	// copying them. The default implementations rely on the copying
+	// variants above.
+	virtual bool run_wrappers(sinsp_evt *evt,
+	                          filter_wrapper_list &wrappers,
+	                          uint16_t ruleset_id,
+	                          std::vector<const falco_rule *> &matches) {
+		auto first = m_copied_matches.size();
+		std::vector<falco_rule> copies;
+		if(!run_wrappers(evt, wrappers, ruleset_id, copies)) {
+			return false;
+		}
+		for(auto &rule : copies) {
+			m_copied_matches.push_back(std::move(rule));
+		}
+		for(auto i = first; i < m_copied_matches.size(); i++) {
+			matches.push_back(&m_copied_matches[i]);
+		}
+		return true;
+	}
+	virtual bool run_wrappers(sinsp_evt *evt,
+	                          filter_wrapper_list &wrappers,
+	                          uint16_t ruleset_id,
+	                          const falco_rule *&match) {
+		m_copied_matches.emplace_back();
+		if(!run_wrappers(evt, wrappers, ruleset_id, m_copied_matches.back())) {
+			m_copied_matches.pop_back();
+			return false;
+		}
+		match = &m_copied_matches.back();
+		return true;
+	}
+
 private:
+	// Freezes again a ruleset thawed by enabling or disabling its rules,
+	// if the rulesets were frozen before
+	void refreeze(uint16_t ruleset_id) {
+		if(m_freeze_func && m_rulesets[ruleset_id]) {
+			m_rulesets[ruleset_id]->freeze(m_freeze_func);
+		}
+	}
+
 	// Helper used by enable()/disable()
 	void enable_disable(const std::string &pattern,
 	                    match_type match,
@@ -199,6 +321,8 @@ private:
 				}
 			}
 		}
+
+		refreeze(ruleset_id);
 	}
 
 	// Helper used by enable_tags()/disable_tags()
@@ -224,6 +348,8 @@ private:
 				}
 			}
 		}
+
+		refreeze(ruleset_id);
 	}
 
 	// A group of filters all having the same ruleset
@@ -248,6 +374,7 @@ private:
 			}
 
 			m_filters.insert(wrap);
+			thaw();
 		}
 
 		void remove_filter(std::shared_ptr<filter_wrapper> wrap) {
@@ -262,6 +389,33 @@ private:
 			}
 
 			m_filters.erase(wrap);
+			thaw();
+		}
+
+		void freeze(const filter_freeze_func &func) {
+			size_t total = m_filter_all_event_types.size();
+			for(const auto &wrappers : m_filter_by_event_type) {
+				total += wrappers.size();
+			}
+
+			m_frozen_filters.clear();
+			m_frozen_filters.reserve(total);
+			m_frozen_stats.clear();
+			m_frozen_stats.reserve(total);
+			m_frozen_by_event_type.assign(m_filter_by_event_type.size(), frozen_range{});
+			for(size_t etype = 0; etype < m_filter_by_event_type.size(); etype++) {
+				m_frozen_by_event_type[etype] = freeze_list(m_filter_by_event_type[etype], func);
+			}
+			m_frozen_all_event_types = freeze_list(m_filter_all_event_types, func);
+			m_frozen = true;
+		}
+
+		void thaw() {
+			m_frozen = false;
+			m_frozen_filters.clear();
+			m_frozen_stats.clear();
+			m_frozen_by_event_type.clear();
+			m_frozen_all_event_types = frozen_range{};
 		}
 
 		uint64_t num_filters() { return m_filters.size(); }
@@ -270,45 +424,28 @@ private:
 			return m_filters;
 		}
 
-		// Evaluate an event against the ruleset and return the first rule
-		// that matched.
-		bool run(indexable_ruleset &ruleset, sinsp_evt *evt, falco_rule &match) {
-			if(evt->get_type() < m_filter_by_event_type.size() &&
-			   m_filter_by_event_type[evt->get_type()].size() > 0) {
-				if(ruleset.run_wrappers(evt,
-				                        m_filter_by_event_type[evt->get_type()],
-				                        m_ruleset_id,
-				                        match)) {
-					return true;
-				}
-			}
-
-			// Finally, try filters that are not specific to an event type.
-			if(m_filter_all_event_types.size() > 0) {
-				if(ruleset.run_wrappers(evt, m_filter_all_event_types, m_ruleset_id, match)) {
-					return true;
-				}
+		// Evaluate an event against the ruleset and fill out the match
+		// argument, which is either the first rule that matched or all
+		// the matching rules depending on its type.
+		template<typename match_t>
+		bool run(indexable_ruleset &ruleset, sinsp_evt *evt, match_t &match) {
+			if(m_frozen) {
+				return run_frozen(ruleset, evt, match);
 			}
 
-			return false;
-		}
-
-		//  Evaluate an event against the ruleset and return all the
-		//  matching rules.
-		bool run(indexable_ruleset &ruleset, sinsp_evt *evt, std::vector<falco_rule> &matches) {
 			if(evt->get_type() < m_filter_by_event_type.size() &&
 			   m_filter_by_event_type[evt->get_type()].size() > 0) {
 				if(ruleset.run_wrappers(evt,
 				                        m_filter_by_event_type[evt->get_type()],
 				                        m_ruleset_id,
-				                        matches)) {
+				                        match)) {
 					return true;
 				}
 			}
 
 			// Finally, try filters that are not specific to an event type.
 			if(m_filter_all_event_types.size() > 0) {
-				if(ruleset.run_wrappers(evt, m_filter_all_event_types, m_ruleset_id, matches)) {
+				if(ruleset.run_wrappers(evt, m_filter_all_event_types, m_ruleset_id, match)) {
 					return true;
 				}
 			}
@@ -332,6 +469,294 @@ private:
 		}
 
 	private:
+		// A range of m_frozen_filters holding one event type bucket
+		struct frozen_range {
+			uint32_t offset = 0;
+			uint32_t count = 0;
+			// Number of evaluations, only counted with adaptive ordering
+			uint64_t num_runs = 0;
+		};
+
+		// Evaluation statistics of a frozen filter, only collected
+		// with adaptive ordering
+		struct frozen_filter_stats {
+			// Position of the filter in its bucket before any reordering
+			uint32_t order = 0;
+			uint64_t num_evals = 0;
+			uint64_t num_matches = 0;
+			uint64_t num_timed_evals = 0;
+			uint64_t timed_ns = 0;
+		};
+
+		frozen_range freeze_list(const filter_wrapper_list &wrappers,
+		                         const filter_freeze_func &func) {
+			frozen_range range;
+			range.offset = (uint32_t)m_frozen_filters.size();
+			range.count = (uint32_t)wrappers.size();
+			for(const auto &wrap : wrappers) {
+				frozen_filter_stats stats;
+				stats.order = (uint32_t)m_frozen_filters.size() - range.offset;
+				m_frozen_filters.push_back(func(wrap));
+				m_frozen_stats.push_back(stats);
+			}
+			return range;
+		}
+
+		static inline bool add_frozen_match(const frozen_filter &f, falco_rule &match) {
+			match = *f.rule;
+			return true;
+		}
+
+		static inline bool add_frozen_match(const frozen_filter &f, const falco_rule *&match) {
+			match = f.rule;
+			return true;
+		}
+
+		static inline bool add_frozen_match(const frozen_filter &f,
+		                                    std::vector<falco_rule> &matches) {
+			matches.push_back(*f.rule);
+			return false;
+		}
+
+		static inline bool add_frozen_match(const frozen_filter &f,
+		                                    std::vector<const falco_rule *> &matches) {
+			matches.push_back(f.rule);
+			return false;
+		}
+
+		// Same as run_wrappers(), on a range of the frozen filters. For
+		// a single match, this stops at the first matching filter.
+		template<typename match_t>
+		inline bool run_frozen_range(sinsp_evt *evt, const frozen_range &range, match_t &match) {
+			bool match_found = false;
+			const frozen_filter *f = m_frozen_filters.data() + range.offset;
+			const frozen_filter *end = f + range.count;
+			for(; f != end; f++) {
+				if(f->filter->run(evt)) {
+					match_found = true;
+					if(add_frozen_match(*f, match)) {
+						break;
+					}
+				}
+			}
+			return match_found;
+		}
+
+		// Same as run_frozen_range() for a single match, but also collects
+		// the statistics used to periodically reorder the range.
+		template<typename match_t>
+		bool run_adaptive_range(indexable_ruleset &ruleset,
+		                        sinsp_evt *evt,
+		                        frozen_range &range,
+		                        match_t &match) {
+			const auto &config = ruleset.m_adaptive_ordering;
+			bool timed = (range.num_runs % config.sampling_ratio) == 0;
+			range.num_runs++;
+
+			bool match_found = false;
+			for(uint32_t i = range.offset; i < range.offset + range.count; i++) {
+				const auto &f = m_frozen_filters[i];
+				auto &stats = m_frozen_stats[i];
+				bool res;
+
+				stats.num_evals++;
+				if(timed) {
+					auto start = std::chrono::steady_clock::now();
+					res = f.filter->run(evt);
+					stats.timed_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+					                          std::chrono::steady_clock::now() - start)
+					                          .count();
+					stats.num_timed_evals++;
+				} else {
+					res = f.filter->run(evt);
+				}
+
+				if(res) {
+					stats.num_matches++;
+					add_frozen_match(f, match);
+					match_found = true;
+					break;
+				}
+			}
+
+			if(range.num_runs % config.reorder_interval == 0) {
+				reorder(ruleset, range);
+			}
+
+			return match_found;
+		}
+
+		// Sorts a frozen range by decreasing match rate over evaluation
+		// cost, which minimizes the expected cost of finding the first
+		// match, and accounts the savings of the order used since the
+		// previous reordering compared to the definition order.
+		void reorder(indexable_ruleset &ruleset, frozen_range &range) {
+			if(range.count < 2) {
+				return;
+			}
+
+			auto stats = m_frozen_stats.begin() + range.offset;
+			auto filters = m_frozen_filters.begin() + range.offset;
+
+			// filters that have never been timed are assumed to have the
+			// average cost of the others
+			double avg_cost = 0;
+			uint64_t num_timed = 0;
+			for(uint32_t i = 0; i < range.count; i++) {
+				if(stats[i].num_timed_evals > 0) {
+					avg_cost += (double)stats[i].timed_ns / stats[i].num_timed_evals;
+					num_timed++;
+				}
+			}
+			avg_cost = num_timed > 0 ? avg_cost / num_timed : 1;
+
+			std::vector<double> cost(range.count);
+			std::vector<double> match_rate(range.count);
+			for(uint32_t i = 0; i < range.count; i++) {
+				cost[i] = stats[i].num_timed_evals > 0
+				                  ? (double)stats[i].timed_ns / stats[i].num_timed_evals
+				                  : avg_cost;
+				cost[i] = std::max(cost[i], 1.0);
+				match_rate[i] = stats[i].num_evals > 0
+				                        ? (double)stats[i].num_matches / stats[i].num_evals
+				                        : 0;
+			}
+
+			auto expected_cost = [&](const std::vector<uint32_t> &order) {
+				double res = 0;
+				double reached = 1;
+				for(auto i : order) {
+					res += reached * cost[i];
+					reached *= 1 - match_rate[i];
+				}
+				return res;
+			};
+
+			std::vector<uint32_t> current(range.count);
+			std::iota(current.begin(), current.end(), 0);
+			std::vector<uint32_t> defined = current;
+			std::sort(defined.begin(), defined.end(), [&](uint32_t a, uint32_t b) {
+				return stats[a].order < stats[b].order;
+			});
+			double saved = expected_cost(defined) - expected_cost(current);
+			if(saved > 0) {
+				ruleset.m_estimated_saved_ns.fetch_add(
+				        (uint64_t)(saved * ruleset.m_adaptive_ordering.reorder_interval),
+				        std::memory_order_relaxed);
+			}
+
+			// rules that never matched keep their definition order
+			std::vector<uint32_t> next = defined;
+			std::stable_sort(next.begin(), next.end(), [&](uint32_t a, uint32_t b) {
+				return match_rate[a] / cost[a] > match_rate[b] / cost[b];
+			});
+
+			if(next != current) {
+				std::vector<frozen_filter> sorted_filters;
+				std::vector<frozen_filter_stats> sorted_stats;
+				sorted_filters.reserve(range.count);
+				sorted_stats.reserve(range.count);
+				for(auto i : next) {
+					sorted_filters.push_back(filters[i]);
+					sorted_stats.push_back(stats[i]);
+				}
+				std::copy(sorted_filters.begin(), sorted_filters.end(), filters);
+				std::copy(sorted_stats.begin(), sorted_stats.end(), stats);
+				ruleset.m_num_reorders.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			// decay the statistics, so that the order follows changes
+			// in the observed workload
+			for(uint32_t i = 0; i < range.count; i++) {
+				stats[i].num_evals /= 2;
+				stats[i].num_matches /= 2;
+				stats[i].num_timed_evals /= 2;
+				stats[i].timed_ns /= 2;
+			}
+		}
+
+		// Same as run_frozen_range(), but also reports the evaluation
+		// time of each filter to the engine state.
+		template<typename match_t>
+		bool run_profiled_range(indexable_ruleset &ruleset,
+		                        sinsp_evt *evt,
+		                        const frozen_range &range,
+		                        match_t &match) {
+			const auto &on_rule_evaluated = ruleset.get_engine_state().on_rule_evaluated;
+			bool match_found = false;
+			const frozen_filter *f = m_frozen_filters.data() + range.offset;
+			const frozen_filter *end = f + range.count;
+			for(; f != end; f++) {
+				auto start = std::chrono::steady_clock::now();
+				bool res = f->filter->run(evt);
+				uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				                      std::chrono::steady_clock::now() - start)
+				                      .count();
+				if(on_rule_evaluated) {
+					on_rule_evaluated(*f->rule, ns);
+				}
+				if(res) {
+					match_found = true;
+					if(add_frozen_match(*f, match)) {
+						break;
+					}
+				}
+			}
+			return match_found;
+		}
+
+		template<typename match_t>
+		inline bool run_frozen_range(indexable_ruleset &ruleset,
+		                             sinsp_evt *evt,
+		                             frozen_range &range,
+		                             match_t &match,
+		                             bool profiled) {
+			// profiled runs keep the current order, and are not accounted
+			// in the adaptive ordering statistics
+			if(profiled) {
+				return run_profiled_range(ruleset, evt, range, match);
+			}
+
+			// only looking for the first match can take advantage of
+			// a different evaluation order
+			if constexpr(std::is_same<match_t, falco_rule>::value ||
+			             std::is_same<match_t, const falco_rule *>::value) {
+				if(ruleset.m_adaptive_ordering.enabled) {
+					return run_adaptive_range(ruleset, evt, range, match);
+				}
+			}
+			return run_frozen_range(evt, range, match);
+		}
+
+		template<typename match_t>
+		bool run_frozen(indexable_ruleset &ruleset, sinsp_evt *evt, match_t &match) {
+			bool profiled = false;
+			if(ruleset.m_profiling_sampling_ratio > 0) {
+				profiled = (m_num_runs % ruleset.m_profiling_sampling_ratio) == 0;
+				m_num_runs++;
+			}
+
+			if(evt->get_type() < m_frozen_by_event_type.size() &&
+			   m_frozen_by_event_type[evt->get_type()].count > 0) {
+				if(run_frozen_range(ruleset,
+				                    evt,
+				                    m_frozen_by_event_type[evt->get_type()],
+				                    match,
+				                    profiled)) {
+					return true;
+				}
+			}
+
+			// Finally, try filters that are not specific to an event type.
+			if(m_frozen_all_event_types.count > 0) {
+				if(run_frozen_range(ruleset, evt, m_frozen_all_event_types, match, profiled)) {
+					return true;
+				}
+			}
+
+			return false;
+		}
+
 		void add_wrapper_to_list(filter_wrapper_list &wrappers,
 		                         std::shared_ptr<filter_wrapper> wrap) {
 			// This is O(n) but it's also uncommon
@@ -363,6 +788,18 @@ private:
 
 		// All filters added. Used to make num_filters() fast.
 		std::set<std::shared_ptr<filter_wrapper>> m_filters;
+
+		// Flat layout of the filters above, see indexable_ruleset::freeze.
+		// All the event type buckets share the same array, and each
+		// bucket is a range in it.
+		bool m_frozen = false;
+		std::vector<frozen_filter> m_frozen_filters;
+		std::vector<frozen_filter_stats> m_frozen_stats;
+		std::vector<frozen_range> m_frozen_by_event_type;
+		frozen_range m_frozen_all_event_types;
+
+		// Number of evaluations, only counted with profiling
+		uint64_t m_num_runs = 0;
 	};
 
 	// Vector indexes from ruleset id to set of rules.
@@ -370,4 +807,13 @@ private:
 
 	// All filters added. The set of enabled filters is held in m_rulesets
 	std::set<std::shared_ptr<filter_wrapper>> m_filters;
+
+	adaptive_ordering_config m_adaptive_ordering;
+	std::atomic<uint64_t> m_num_reorders{0};
+	std::atomic<uint64_t> m_estimated_saved_ns{0};
+
+	uint32_t m_profiling_sampling_ratio = 0;
+
+	// The function of the last call to freeze(), if any
+	filter_freeze_func m_freeze_func;
 };
@@ -343,6 +343,10 @@ struct configuration {
 	std::vector<extra_output_format_conf> extra_output_format;
 	std::vector<extra_output_field_conf> extra_output_fields;
 
+	// see filter_optimizer_resolver and filter_string_predicate_resolver
+	bool optimize_conditions = false;
+	bool fold_string_predicates = false;
+
 	// outputs
 	std::unique_ptr<result> res;
 };
@@ -21,6 +21,8 @@ limitations under the License.
 #include <vector>
 
 #include "rule_loader_compiler.h"
+#include "filter_optimizer_resolver.h"
+#include "filter_string_predicate_resolver.h"
 #include "filter_warning_resolver.h"
 
 #define MAX_VISIBILITY ((uint32_t) - 1)
@@ -90,8 +92,102 @@ static void check_deprecated_fields_in_output(const std::string& fmt,
 	}
 }
 
+static bool resolve_list(std::string& cnd, const falco_list& list);
+
+// Returns true if the given prefilter compiles for the source of the rule,
+// since not all the field types support the in operator.
+static bool is_prefilter_valid(std::string prefilter,
+                               const indexed_vector<falco_list>& lists,
+                               const std::shared_ptr<sinsp_filter_factory>& filter_factory) {
+	for(const auto& l : lists) {
+		resolve_list(prefilter, l);
+	}
+	try {
+		libsinsp::filter::parser p(prefilter);
+		std::shared_ptr<ast::expr> res_ptr(p.parse());
+		sinsp_filter_compiler(filter_factory, res_ptr.get()).compile();
+	} catch(const sinsp_exception&) {
+		return false;
+	}
+	return true;
+}
+
+// Minimum number of values of a multi-field exception for building the
+// prefilter of build_exception_prefilter()
+static const size_t s_exception_prefilter_min_values = 16;
+
+// Multi-field exceptions are compiled as a chain of or-ed comparisons, which
+// costs a linear number of evaluations in the amount of values for every
+// event reaching the exception. For large exceptions, this builds a
+// condition checking that each field compared with = or in has one of the
+// values listed for it, using the in operator which is evaluated with a hash
+// lookup. The chain is only evaluated for the events that pass this check,
+// which are normally a small fraction. Returns an empty string if no field
+// can be prefiltered.
+static std::string build_exception_prefilter(
+        const rule_loader::rule_exception_info& ex,
+        const indexed_vector<falco_list>& lists,
+        const std::shared_ptr<sinsp_filter_factory>& filter_factory) {
+	std::string prefilter;
+	for(size_t k = 0; k < ex.fields.items.size(); k++) {
+		const auto& comp = ex.comps.items[k].item;
+		if(comp != "=" && comp != "in") {
+			continue;
+		}
+
+		bool valid = true;
+		std::string values;
+		std::unordered_set<std::string> seen;
+		std::vector<std::string> items;
+		for(const auto& tuple : ex.values) {
+			const auto& val = tuple.items[k];
+			items.clear();
+			if(val.is_list && comp == "in") {
+				for(const auto& v : val.items) {
+					items.push_back(v.item);
+					quote_item(items.back());
+				}
+			} else if(val.is_list) {
+				valid = false;
+			} else if(comp == "in") {
+				// the value is pasted as a list of items, see paren_item()
+				items.push_back(val.item);
+				if(val.item.size() >= 2 && val.item.front() == '(' && val.item.back() == ')') {
+					items.back() = val.item.substr(1, val.item.size() - 2);
+				}
+			} else {
+				items.push_back(val.item);
+				quote_item(items.back());
+			}
+
+			for(const auto& item : items) {
+				if(item.empty()) {
+					valid = false;
+				} else if(seen.insert(item).second) {
+					values += values.empty() ? "" : ", ";
+					values += item;
+				}
+			}
+			if(!valid) {
+				break;
+			}
+		}
+
+		// fields not supporting the in operator are left out, and only
+		// evaluated by the original chain
+		auto field_prefilter = ex.fields.items[k].item + " in (" + values + ")";
+		if(valid && !values.empty() && is_prefilter_valid(field_prefilter, lists, filter_factory)) {
+			prefilter += prefilter.empty() ? "" : " and ";
+			prefilter += field_prefilter;
+		}
+	}
+	return prefilter;
+}
+
 static void build_rule_exception_infos(
         const std::vector<rule_loader::rule_exception_info>& exceptions,
+        const indexed_vector<falco_list>& lists,
+        const std::shared_ptr<sinsp_filter_factory>& filter_factory,
         std::set<std::string>& exception_fields,
         std::string& condition) {
 	std::string tmp;
@@ -147,6 +243,11 @@ static void build_rule_exception_infos(
 			icond += ")";
 			if(icond == "()") {
 				icond = "";
+			} else if(ex.values.size() >= s_exception_prefilter_min_values) {
+				auto prefilter = build_exception_prefilter(ex, lists, filter_factory);
+				if(!prefilter.empty()) {
+					icond = "(" + prefilter + " and " + icond + ")";
+				}
 			}
 		}
 		condition += icond.empty() ? "" : " and not " + icond;
@@ -349,18 +450,21 @@ static bool err_is_unknown_type_or_field(const std::string& err) {
 	       err.find("unknown event type") != std::string::npos;
 }
 
-bool rule_loader::compiler::compile_condition(const configuration& cfg,
-                                              filter_macro_resolver& macro_resolver,
-                                              indexed_vector<falco_list>& lists,
-                                              const indexed_vector<rule_loader::macro_info>& macros,
-                                              const std::string& condition,
-                                              std::shared_ptr<sinsp_filter_factory> filter_factory,
-                                              const rule_loader::context& cond_ctx,
-                                              const rule_loader::context& parent_ctx,
-                                              bool allow_unknown_fields,
-                                              indexed_vector<falco_macro>& macros_out,
-                                              std::shared_ptr<libsinsp::filter::ast::expr>& ast_out,
-                                              std::shared_ptr<sinsp_filter>& filter_out) const {
+bool rule_loader::compiler::compile_condition(
+        const configuration& cfg,
+        filter_macro_resolver& macro_resolver,
+        indexed_vector<falco_list>& lists,
+        const indexed_vector<rule_loader::macro_info>& macros,
+        const std::string& condition,
+        std::shared_ptr<sinsp_filter_factory> filter_factory,
+        const rule_loader::context& cond_ctx,
+        const rule_loader::context& parent_ctx,
+        bool allow_unknown_fields,
+        indexed_vector<falco_macro>& macros_out,
+        std::shared_ptr<libsinsp::filter::ast::expr>& ast_out,
+        std::shared_ptr<sinsp_filter>& filter_out,
+        std::shared_ptr<libsinsp::filter::ast::expr>& optimized_out,
+        std::shared_ptr<sinsp_filter_cache_factory> cache_factory) const {
 	std::set<falco::load_result::load_result::warning_code> warn_codes;
 	filter_warning_resolver warn_resolver;
 	ast_out = parse_condition(condition, lists, cond_ctx);
@@ -377,7 +481,7 @@ bool rule_loader::compiler::compile_condition(const configuration& cfg,
 
 	// validate the rule's condition: we compile it into a sinsp filter
 	// on-the-fly and we throw an exception with details on failure
-	sinsp_filter_compiler compiler(filter_factory, ast_out.get());
+	sinsp_filter_compiler compiler(filter_factory, ast_out.get(), cache_factory);
 	try {
 		filter_out = compiler.compile();
 	} catch(const sinsp_exception& e) {
@@ -399,6 +503,30 @@ bool rule_loader::compiler::compile_condition(const configuration& cfg,
 		cfg.res->add_warning(falco::load_result::warning_code::LOAD_COMPILE_CONDITION, w.msg, ctx);
 	}
 
+	// evaluate an equivalent condition that is cheaper to evaluate, the
+	// original AST is kept for indexing and describing the rule
+	optimized_out = nullptr;
+	if(cfg.optimize_conditions || cfg.fold_string_predicates) {
+		std::shared_ptr<libsinsp::filter::ast::expr> optimized = ast::clone(ast_out.get());
+		bool changed = false;
+		if(cfg.optimize_conditions) {
+			changed = filter_optimizer_resolver().run(optimized);
+		}
+		if(cfg.fold_string_predicates) {
+			changed = filter_string_predicate_resolver().run(*optimized) || changed;
+		}
+		if(changed) {
+			try {
+				filter_out = sinsp_filter_compiler(filter_factory, optimized.get(), cache_factory)
+				                     .compile();
+				optimized_out = optimized;
+			} catch(const sinsp_exception&) {
+				// a field doesn't support the regex operator, keep the
+				// filter compiled from the original condition
+			}
+		}
+	}
+
 	return true;
 }
 
@@ -425,7 +553,11 @@ void rule_loader::compiler::compile_rule_infos(const configuration& cfg,
 
 		condition = r.cond;
 		if(!r.exceptions.empty()) {
-			build_rule_exception_infos(r.exceptions, rule.exception_fields, condition);
+			build_rule_exception_infos(r.exceptions,
+			                           lists,
+			                           source->filter_factory,
+			                           rule.exception_fields,
+			                           condition);
 		}
 
 		// build rule output message
@@ -521,7 +653,9 @@ void rule_loader::compiler::compile_rule_infos(const configuration& cfg,
 		                      r.skip_if_unknown_filter,
 		                      macros,
 		                      rule.condition,
-		                      rule.filter)) {
+		                      rule.filter,
+		                      rule.optimized_condition,
+		                      cfg.sources.at(r.source)->filter_cache_factory)) {
 			continue;
 		}
 
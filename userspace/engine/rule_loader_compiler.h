@@ -56,18 +56,21 @@ protected:
 	   ast_out/filter_out with the compiled filter + ast. Returns false if
 	   the condition could not be compiled and should be skipped.
 	   */
-	bool compile_condition(const configuration& cfg,
-	                       filter_macro_resolver& macro_resolver,
-	                       indexed_vector<falco_list>& lists,
-	                       const indexed_vector<rule_loader::macro_info>& macros,
-	                       const std::string& condition,
-	                       std::shared_ptr<sinsp_filter_factory> filter_factory,
-	                       const rule_loader::context& cond_ctx,
-	                       const rule_loader::context& parent_ctx,
-	                       bool allow_unknown_fields,
-	                       indexed_vector<falco_macro>& macros_out,
-	                       std::shared_ptr<libsinsp::filter::ast::expr>& ast_out,
-	                       std::shared_ptr<sinsp_filter>& filter_out) const;
+	bool compile_condition(
+	        const configuration& cfg,
+	        filter_macro_resolver& macro_resolver,
+	        indexed_vector<falco_list>& lists,
+	        const indexed_vector<rule_loader::macro_info>& macros,
+	        const std::string& condition,
+	        std::shared_ptr<sinsp_filter_factory> filter_factory,
+	        const rule_loader::context& cond_ctx,
+	        const rule_loader::context& parent_ctx,
+	        bool allow_unknown_fields,
+	        indexed_vector<falco_macro>& macros_out,
+	        std::shared_ptr<libsinsp::filter::ast::expr>& ast_out,
+	        std::shared_ptr<sinsp_filter>& filter_out,
+	        std::shared_ptr<libsinsp::filter::ast::expr>& optimized_out,
+	        std::shared_ptr<sinsp_filter_cache_factory> cache_factory = nullptr) const;
 
 private:
 	void compile_list_infos(const configuration& cfg,
@@ -28,6 +28,14 @@ void stats_manager::clear() {
 	m_total = 0;
 	m_by_rule_id.clear();
 	m_by_priority.clear();
+	m_profile_by_rule_id.clear();
+}
+
+uint64_t stats_manager::profile_bucket_upper_bound(size_t bucket) {
+	if(bucket + 1 >= num_profile_buckets) {
+		return UINT64_MAX;
+	}
+	return uint64_t(128) << bucket;
 }
 
 void stats_manager::format(const indexed_vector<falco_rule>& rules, std::string& out) const {
@@ -55,6 +63,9 @@ void stats_manager::on_rule_loaded(const falco_rule& rule) {
 	while(m_by_rule_id.size() <= rule.id) {
 		m_by_rule_id.emplace_back(std::make_unique<std::atomic<uint64_t>>(0));
 	}
+	while(m_profile_by_rule_id.size() <= rule.id) {
+		m_profile_by_rule_id.emplace_back(std::make_unique<rule_profile>());
+	}
 	while(m_by_priority.size() <= (size_t)rule.priority) {
 		m_by_priority.emplace_back(std::make_unique<std::atomic<uint64_t>>(0));
 	}
@@ -68,3 +79,17 @@ void stats_manager::on_event(const falco_rule& rule) {
 	m_by_rule_id[rule.id]->fetch_add(1, std::memory_order_relaxed);
 	m_by_priority[(size_t)rule.priority]->fetch_add(1, std::memory_order_relaxed);
 }
+
+void stats_manager::on_rule_evaluated(const falco_rule& rule, uint64_t ns) {
+	if(m_profile_by_rule_id.size() <= rule.id) {
+		throw falco_exception("rule id out of bounds");
+	}
+	auto& profile = *m_profile_by_rule_id[rule.id];
+	profile.num_evals.fetch_add(1, std::memory_order_relaxed);
+	profile.total_ns.fetch_add(ns, std::memory_order_relaxed);
+	size_t bucket = 0;
+	while(ns > profile_bucket_upper_bound(bucket)) {
+		bucket++;
+	}
+	profile.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
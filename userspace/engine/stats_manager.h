@@ -17,6 +17,7 @@ limitations under the License.
 
 #pragma once
 
+#include <array>
 #include <vector>
 #include <string>
 #include <atomic>
@@ -32,6 +33,28 @@ limitations under the License.
 */
 class stats_manager {
 public:
+	/*!
+	    \brief Number of buckets of the per-rule evaluation latency
+	    histogram. Bucket i counts evaluations that took at most
+	    (128 << i) nanoseconds, and the last one counts all the others.
+	*/
+	static constexpr size_t num_profile_buckets = 12;
+
+	/*!
+	    \brief Upper bound in nanoseconds of the given histogram bucket,
+	    or UINT64_MAX for the last one.
+	*/
+	static uint64_t profile_bucket_upper_bound(size_t bucket);
+
+	/*!
+	    \brief Sampled evaluation cost of a single rule
+	*/
+	struct rule_profile {
+		std::atomic<uint64_t> num_evals{0};
+		std::atomic<uint64_t> total_ns{0};
+		std::array<std::atomic<uint64_t>, num_profile_buckets> buckets{};
+	};
+
 	stats_manager();
 	virtual ~stats_manager();
 
@@ -55,6 +78,15 @@ public:
 	*/
 	virtual void on_event(const falco_rule& rule);
 
+	/*!
+	    \brief Callback for when the evaluation of a given rule's condition
+	    has been profiled, with the time it took in nanoseconds.
+	    This method is thread-safe.
+	    \throws falco_exception if rule has not been passed to
+	    on_rule_loaded() first
+	*/
+	virtual void on_rule_evaluated(const falco_rule& rule, uint64_t ns);
+
 	/*!
 	    \brief Formats the internal statistics into the out string.
 	*/
@@ -71,8 +103,13 @@ public:
 		return m_by_rule_id;
 	}
 
+	inline const std::vector<std::unique_ptr<rule_profile>>& get_profile_by_rule_id() const {
+		return m_profile_by_rule_id;
+	}
+
 private:
 	std::atomic<uint64_t> m_total;
 	std::vector<std::unique_ptr<std::atomic<uint64_t>>> m_by_priority;
 	std::vector<std::unique_ptr<std::atomic<uint64_t>>> m_by_rule_id;
+	std::vector<std::unique_ptr<rule_profile>> m_profile_by_rule_id;
 };
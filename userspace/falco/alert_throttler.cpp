@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "alert_throttler.h"
+
+#include <algorithm>
+#include <limits>
+
+alert_throttler::alert_throttler(const config &config):
+        m_config(config),
+        m_next_expire(std::numeric_limits<uint64_t>::max()),
+        m_num_rate_limited(0),
+        m_num_deduplicated(0) {}
+
+bool alert_throttler::admit(const std::string &rule,
+                            falco_common::priority_type priority,
+                            const std::map<std::string, std::string> &key_fields,
+                            uint64_t now) {
+	std::unique_lock<std::mutex> lock(m_mtx);
+
+	m_key = rule;
+	for(const auto &f : key_fields) {
+		m_key += '\0';
+		m_key += f.second;
+	}
+
+	auto it = m_windows.find(m_key);
+	if(it != m_windows.end() && now >= it->second.end) {
+		close_window(it->second, m_pending);
+		m_windows.erase(it);
+		it = m_windows.end();
+		m_next_expire = 0;
+	}
+
+	if(m_config.dedup_enabled && it != m_windows.end() && it->second.delivered) {
+		it->second.num_suppressed++;
+		m_num_deduplicated++;
+		return false;
+	}
+
+	if(m_config.rate_limit_enabled) {
+		auto [bucket, inserted] = m_buckets.try_emplace(rule);
+		if(inserted) {
+			bucket->second.init(m_config.rate, m_config.max_burst, now);
+		}
+		if(!bucket->second.claim(1, now)) {
+			auto &w = it != m_windows.end() ? it->second
+			                                : open_window(rule, priority, key_fields, now);
+			w.num_suppressed++;
+			m_num_rate_limited++;
+			return false;
+		}
+	}
+
+	if(m_config.dedup_enabled) {
+		// the alerts rate limited so far stay accounted in the window
+		auto &w = it != m_windows.end() ? it->second : open_window(rule, priority, key_fields, now);
+		w.delivered = true;
+	}
+	return true;
+}
+
+void alert_throttler::expire(uint64_t now, std::vector<summary> &summaries) {
+	if(now < m_next_expire.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(m_mtx);
+	summaries.insert(summaries.end(), m_pending.begin(), m_pending.end());
+	m_pending.clear();
+
+	uint64_t next_expire = std::numeric_limits<uint64_t>::max();
+	for(auto it = m_windows.begin(); it != m_windows.end();) {
+		if(it->second.end <= now) {
+			close_window(it->second, summaries);
+			it = m_windows.erase(it);
+		} else {
+			next_expire = std::min(next_expire, it->second.end);
+			++it;
+		}
+	}
+	m_next_expire = next_expire;
+}
+
+alert_throttler::window &alert_throttler::open_window(
+        const std::string &rule,
+        falco_common::priority_type priority,
+        const std::map<std::string, std::string> &key_fields,
+        uint64_t now) {
+	uint64_t end = now + m_config.window_ns;
+	if(end < m_next_expire.load()) {
+		m_next_expire = end;
+	}
+	auto &w = m_windows[m_key];
+	w = {end, rule, priority, key_fields, 0, false};
+	return w;
+}
+
+void alert_throttler::close_window(const window &w, std::vector<summary> &summaries) {
+	if(w.num_suppressed > 0) {
+		summaries.push_back({w.end, w.rule, w.priority, w.key_fields, w.num_suppressed});
+	}
+}
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <libsinsp/token_bucket.h>
+
+#include "falco_common.h"
+
+/*!
+    \brief Decides which alerts are delivered when rules trigger too often,
+    before they are formatted.
+
+    With rate limiting, each rule has a token bucket, and its alerts are
+    suppressed while the bucket is empty. With deduplication, the alerts of
+    a rule that have the same values for the key fields are collapsed: the
+    first one is delivered, and the identical ones that follow within the
+    window are suppressed.
+
+    The suppressed alerts are counted in windows, one per rule and key
+    fields values, and a summary of each window that suppressed some alerts
+    is returned once the window is over, so that they are still reported.
+
+    This class is thread-safe.
+*/
+class alert_throttler {
+public:
+	struct config {
+		uint64_t window_ns = 0;
+		bool rate_limit_enabled = false;
+		double rate = 0;
+		double max_burst = 0;
+		bool dedup_enabled = false;
+		std::vector<std::string> dedup_key_fields;
+
+		bool enabled() const { return rate_limit_enabled || dedup_enabled; }
+	};
+
+	struct summary {
+		uint64_t ts;
+		std::string rule;
+		falco_common::priority_type priority;
+		std::map<std::string, std::string> key_fields;
+		uint64_t num_suppressed;
+	};
+
+	explicit alert_throttler(const config& config);
+
+	const config& get_config() const { return m_config; }
+
+	/*!
+	    \brief Returns whether an alert of the given rule must be delivered,
+	    or is suppressed.
+	    \param key_fields values of the deduplication key fields, if enabled
+	*/
+	bool admit(const std::string& rule,
+	           falco_common::priority_type priority,
+	           const std::map<std::string, std::string>& key_fields,
+	           uint64_t now);
+
+	/*!
+	    \brief Appends to summaries those of the windows over at now.
+	*/
+	void expire(uint64_t now, std::vector<summary>& summaries);
+
+	uint64_t get_num_rate_limited() const { return m_num_rate_limited.load(); }
+
+	uint64_t get_num_deduplicated() const { return m_num_deduplicated.load(); }
+
+private:
+	struct window {
+		uint64_t end;
+		std::string rule;
+		falco_common::priority_type priority;
+		std::map<std::string, std::string> key_fields;
+		uint64_t num_suppressed;
+		// Whether an alert was delivered in the window, so that the
+		// identical ones that follow are deduplicated. A window opened by
+		// a rate limited alert only counts the suppressed alerts.
+		bool delivered;
+	};
+
+	window& open_window(const std::string& rule,
+	                    falco_common::priority_type priority,
+	                    const std::map<std::string, std::string>& key_fields,
+	                    uint64_t now);
+	void close_window(const window& w, std::vector<summary>& summaries);
+
+	config m_config;
+	std::mutex m_mtx;
+	std::unordered_map<std::string, token_bucket> m_buckets;
+	std::unordered_map<std::string, window> m_windows;
+	std::string m_key;
+	// Summaries of the windows found over while admitting alerts
+	std::vector<summary> m_pending;
+	std::atomic<uint64_t> m_next_expire;
+	std::atomic<uint64_t> m_num_rate_limited;
+	std::atomic<uint64_t> m_num_deduplicated;
+};
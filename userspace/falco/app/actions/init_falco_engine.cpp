@@ -165,6 +165,14 @@ falco::app::run_result falco::app::actions::init_falco_engine(falco::app::state&
 
 	configure_output_format(s);
 	s.engine->set_min_priority(s.config->m_min_priority);
+	s.engine->set_adaptive_rule_ordering(s.config->m_rule_evaluation_adaptive_ordering);
+	s.engine->set_rule_profiling(s.config->m_rule_evaluation_profiling_enabled
+	                                     ? s.config->m_rule_evaluation_profiling_sampling_ratio
+	                                     : 0);
+	s.engine->set_filter_cache(s.config->m_rule_evaluation_field_extraction_cache_enabled);
+	s.engine->set_string_predicate_folding(
+	        s.config->m_rule_evaluation_string_predicate_folding_enabled);
+	s.engine->set_condition_optimizer(s.config->m_rule_evaluation_condition_optimizer_enabled);
 
 	return run_result::ok();
 }
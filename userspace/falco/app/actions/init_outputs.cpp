@@ -68,6 +68,10 @@ falco::app::run_result falco::app::actions::init_outputs(falco::app::state& s) {
 	                                            s.config->m_output_timeout,
 	                                            s.config->m_buffered_outputs,
 	                                            s.config->m_outputs_queue_capacity,
+	                                            s.config->m_outputs_queue_shed_threshold,
+	                                            s.config->m_outputs_queue_per_output,
+	                                            s.config->m_outputs_queue_spool,
+	                                            s.config->m_alert_throttling,
 	                                            s.config->m_time_format_iso_8601,
 	                                            hostname);
 
@@ -118,6 +118,9 @@ static falco::app::run_result do_inspect(
 	const bool is_capture_mode = source.empty();
 	size_t source_engine_idx = 0;
 
+	// rules matching the current event, reused across events
+	std::vector<const falco_rule*> matches;
+
 	// note(jasondellaluce): The "syscall" event source will always be loaded
 	// by default in an inspector, and at index 0. As such, in live mode we would
 	// expect the event source index to always be 0 in case of "syscall" source,
@@ -297,34 +300,38 @@ static falco::app::run_result do_inspect(
 			return run_result::fatal("Drop manager internal error");
 		}
 
+		// Report the alerts suppressed by throttling in the windows
+		// that are over, before the event can open new ones
+		s.outputs->close_alert_windows(ev->get_ts());
+
 		// As the inspector has no filter at its level, all
 		// events are returned here. Pass them to the falco
 		// engine, which will match the event against the set
 		// of rules. If a match is found, pass the event to
 		// the outputs.
-		auto res = s.engine->process_event(source_engine_idx, ev, s.config->m_rule_matching);
-		if(res != nullptr) {
+		if(s.engine->process_event(source_engine_idx, ev, s.config->m_rule_matching, matches)) {
 			auto capture = s.config->m_capture_enabled &&
 			               capture_mode_t::ALL_RULES == s.config->m_capture_mode;
-			for(auto& rule_res : *res) {
+			for(const auto* rule : matches) {
 				// Process output
-				s.outputs->handle_event(rule_res.evt,
-				                        rule_res.rule,
-				                        rule_res.source,
-				                        rule_res.priority_num,
-				                        rule_res.format,
-				                        rule_res.tags,
-				                        rule_res.extra_output_fields);
+				s.outputs->handle_event(ev,
+				                        rule->name,
+				                        rule->source,
+				                        rule->priority,
+				                        rule->output,
+				                        rule->tags,
+				                        rule->extra_output_fields);
 				// Compute capture params, if enabled
 				if(s.config->m_capture_enabled) {
-					if(capture_mode_t::RULES == s.config->m_capture_mode && rule_res.capture) {
+					if(capture_mode_t::RULES == s.config->m_capture_mode && rule->capture) {
 						capture = true;
 					}
 					// Compute the capture deadline for this event,
 					// based on the rule’s duration or the default one if unspecified
+					auto capture_duration_ns = uint64_t(rule->capture_duration) * 1000000LL;
 					auto evt_deadline_ts =
-					        ev->get_ts() + (rule_res.capture_duration_ns > 0
-					                                ? rule_res.capture_duration_ns
+					        ev->get_ts() + (capture_duration_ns > 0
+					                                ? capture_duration_ns
 					                                : s.config->m_capture_default_duration_ns);
 					// Update the capture deadline if this event needs to extend it beyond the
 					// current deadline or if no deadline is currently set
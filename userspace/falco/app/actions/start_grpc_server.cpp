@@ -39,15 +39,15 @@ falco::app::run_result falco::app::actions::start_grpc_server(falco::app::state&
 	falco_logger::log(falco_logger::level::INFO,
 	                  "gRPC server threadiness equals to " +
 	                          std::to_string(s.config->m_grpc_threadiness) + "\n");
-	// TODO(fntlnz,leodido): when we want to spawn multiple threads we need to have a queue per
-	// thread, or implement different queuing mechanisms, round robin, fanout? What we want to
-	// achieve?
 	s.grpc_server.init(s.config->m_grpc_bind_address,
 	                   s.config->m_grpc_threadiness,
 	                   s.config->m_grpc_private_key,
 	                   s.config->m_grpc_cert_chain,
 	                   s.config->m_grpc_root_certs,
-	                   s.config->m_log_level);
+	                   s.config->m_log_level,
+	                   s.config->m_grpc_batch_size,
+	                   s.config->m_grpc_batch_max_delay_ms,
+	                   s.config->m_grpc_cpu_affinity);
 	s.grpc_server_thread = std::thread([&s] { s.grpc_server.run(); });
 #endif
 	return run_result::ok();
@@ -142,6 +142,9 @@ const char config_schema_string[] = LONG_STRING_CONST(
                 "outputs_queue": {
                     "$ref": "#/definitions/OutputsQueue"
                 },
+                "alert_throttling": {
+                    "$ref": "#/definitions/AlertThrottling"
+                },
                 "stdout_output": {
                     "$ref": "#/definitions/Output"
                 },
@@ -158,7 +161,7 @@ const char config_schema_string[] = LONG_STRING_CONST(
                     "$ref": "#/definitions/ProgramOutput"
                 },
                 "grpc_output": {
-                    "$ref": "#/definitions/Output"
+                    "$ref": "#/definitions/GrpcOutput"
                 },
                 "grpc": {
                     "$ref": "#/definitions/Grpc"
@@ -196,6 +199,9 @@ const char config_schema_string[] = LONG_STRING_CONST(
                 "falco_libs": {
                     "$ref": "#/definitions/FalcoLibs"
                 },
+                "rule_evaluation": {
+                    "$ref": "#/definitions/RuleEvaluation"
+                },
                 "container_engines": {
                     "type": "object",
                     "additionalProperties": false,
@@ -357,6 +363,68 @@ const char config_schema_string[] = LONG_STRING_CONST(
             "minProperties": 1,
             "title": "BaseSyscalls"
         },
+        "RuleEvaluation": {
+            "type": "object",
+            "additionalProperties": false,
+            "properties": {
+                "adaptive_ordering": {
+                    "type": "object",
+                    "additionalProperties": false,
+                    "properties": {
+                        "enabled": {
+                            "type": "boolean"
+                        },
+                        "sampling_ratio": {
+                            "type": "integer"
+                        },
+                        "reorder_interval": {
+                            "type": "integer"
+                        }
+                    }
+                },
+                "profiling": {
+                    "type": "object",
+                    "additionalProperties": false,
+                    "properties": {
+                        "enabled": {
+                            "type": "boolean"
+                        },
+                        "sampling_ratio": {
+                            "type": "integer"
+                        }
+                    }
+                },
+                "field_extraction_cache": {
+                    "type": "object",
+                    "additionalProperties": false,
+                    "properties": {
+                        "enabled": {
+                            "type": "boolean"
+                        }
+                    }
+                },
+                "string_predicate_folding": {
+                    "type": "object",
+                    "additionalProperties": false,
+                    "properties": {
+                        "enabled": {
+                            "type": "boolean"
+                        }
+                    }
+                },
+                "condition_optimizer": {
+                    "type": "object",
+                    "additionalProperties": false,
+                    "properties": {
+                        "enabled": {
+                            "type": "boolean"
+                        }
+                    }
+                }
+            },
+            "minProperties": 1,
+            "title": "RuleEvaluation"
+        },
         "Engine": {
             "type": "object",
             "additionalProperties": false,
@@ -496,11 +564,57 @@ const char config_schema_string[] = LONG_STRING_CONST(
                 },
                 "filename": {
                     "type": "string"
+                },
+                "buffer_size_kb": {
+                    "type": "integer",
+                    "minimum": 1
+                },
+                "flush_interval_ms": {
+                    "type": "integer",
+                    "minimum": 1
+                },
+                "fsync": {
+                    "type": "string",
+                    "enum": [
+                      "never",
+                      "flush",
+                      "rotation"
+                    ]
+                },
+                "rotation": {
+                    "$ref": "#/definitions/FileOutputRotation"
                 }
             },
             "minProperties": 1,
             "title": "FileOutput"
         },
+        "FileOutputRotation": {
+            "type": "object",
+            "additionalProperties": false,
+            "properties": {
+                "max_size_mb": {
+                    "type": "integer",
+                    "minimum": 0
+                },
+                "max_age_sec": {
+                    "type": "integer",
+                    "minimum": 0
+                },
+                "max_files": {
+                    "type": "integer",
+                    "minimum": 0
+                },
+                "compression": {
+                    "type": "string",
+                    "enum": [
+                      "none",
+                      "gzip"
+                    ]
+                }
+            },
+            "minProperties": 1,
+            "title": "FileOutputRotation"
+        },
         "Grpc": {
             "type": "object",
             "additionalProperties": false,
@@ -513,6 +627,21 @@ const char config_schema_string[] = LONG_STRING_CONST(
                 },
                 "threadiness": {
                     "type": "integer"
+                },
+                "batch_size": {
+                    "type": "integer",
+                    "minimum": 1
+                },
+                "batch_max_delay_ms": {
+                    "type": "integer",
+                    "minimum": 1
+                },
+                "cpu_affinity": {
+                    "type": "array",
+                    "items": {
+                        "type": "integer",
+                        "minimum": 0
+                    }
                 }
             },
             "minProperties": 1,
@@ -529,6 +658,28 @@ const char config_schema_string[] = LONG_STRING_CONST(
             "minProperties": 1,
             "title": "Output"
         },
+        "GrpcOutput": {
+            "type": "object",
+            "additionalProperties": false,
+            "properties": {
+                "enabled": {
+                    "type": "boolean"
+                },
+                "subscriber_buffer_size": {
+                    "type": "integer",
+                    "minimum": 1
+                },
+                "slow_subscriber_policy": {
+                    "type": "string",
+                    "enum": [
+                      "drop_oldest",
+                      "disconnect"
+                    ]
+                }
+            },
+            "minProperties": 1,
+            "title": "GrpcOutput"
+        },
         "HTTPOutput": {
             "type": "object",
             "additionalProperties": false,
@@ -578,11 +729,48 @@ const char config_schema_string[] = LONG_STRING_CONST(
                 },
                 "max_consecutive_timeouts": {
                     "type": "integer"
+                },
+                "batching": {
+                    "$ref": "#/definitions/HTTPOutputBatching"
                 }
             },
             "minProperties": 1,
             "title": "HTTPOutput"
         },
+        "HTTPOutputBatching": {
+            "type": "object",
+            "additionalProperties": false,
+            "properties": {
+                "enabled": {
+                    "type": "boolean"
+                },
+                "format": {
+                    "type": "string",
+                    "enum": [
+                        "ndjson",
+                        "json_array"
+                    ]
+                },
+                "max_messages": {
+                    "type": "integer",
+                    "minimum": 1
+                },
+                "max_bytes": {
+                    "type": "integer",
+                    "minimum": 1
+                },
+                "flush_interval_ms": {
+                    "type": "integer",
+                    "minimum": 1
+                },
+                "max_in_flight": {
+                    "type": "integer",
+                    "minimum": 1
+                }
+            },
+            "minProperties": 1,
+            "title": "HTTPOutputBatching"
+        },
         "LibsLogger": {
             "type": "object",
             "additionalProperties": false,
@@ -653,11 +841,104 @@ const char config_schema_string[] = LONG_STRING_CONST(
             "properties": {
                 "capacity": {
                     "type": "integer"
+                },
+                "shed_threshold": {
+                    "type": "number",
+                    "minimum": 0,
+                    "maximum": 1
+                },
+                "per_output": {
+                    "type": "boolean"
+                },
+                "spool": {
+                    "$ref": "#/definitions/OutputsQueueSpool"
                 }
             },
             "minProperties": 1,
             "title": "OutputsQueue"
         },
+        "OutputsQueueSpool": {
+            "type": "object",
+            "additionalProperties": false,
+            "properties": {
+                "enabled": {
+                    "type": "boolean"
+                },
+                "directory": {
+                    "type": "string"
+                },
+                "outputs": {
+                    "type": "array",
+                    "items": {
+                        "type": "string"
+                    }
+                },
+                "segment_size_mb": {
+                    "type": "integer",
+                    "minimum": 1
+                },
+                "max_size_mb": {
+                    "type": "integer",
+                    "minimum": 1
+                }
+            },
+            "minProperties": 1,
+            "title": "OutputsQueueSpool"
+        },
+        "AlertThrottling": {
+            "type": "object",
+            "additionalProperties": false,
+            "properties": {
+                "window_sec": {
+                    "type": "integer",
+                    "minimum": 1
+                },
+                "rate_limit": {
+                    "$ref": "#/definitions/AlertThrottlingRateLimit"
+                },
+                "dedup": {
+                    "$ref": "#/definitions/AlertThrottlingDedup"
+                }
+            },
+            "minProperties": 1,
+            "title": "AlertThrottling"
+        },
+        "AlertThrottlingRateLimit": {
+            "type": "object",
+            "additionalProperties": false,
+            "properties": {
+                "enabled": {
+                    "type": "boolean"
+                },
+                "rate": {
+                    "type": "number",
+                    "exclusiveMinimum": 0
+                },
+                "max_burst": {
+                    "type": "number",
+                    "minimum": 1
+                }
+            },
+            "minProperties": 1,
+            "title": "AlertThrottlingRateLimit"
+        },
+        "AlertThrottlingDedup": {
+            "type": "object",
+            "additionalProperties": false,
+            "properties": {
+                "enabled": {
+                    "type": "boolean"
+                },
+                "key_fields": {
+                    "type": "array",
+                    "items": {
+                        "type": "string"
+                    }
+                }
+            },
+            "minProperties": 1,
+            "title": "AlertThrottlingDedup"
+        },
         "Plugin": {
             "type": "object",
             "additionalProperties": false,
@@ -703,6 +984,21 @@ const char config_schema_string[] = LONG_STRING_CONST(
                 },
                 "program": {
                     "type": "string"
+                },
+                "framing": {
+                    "type": "string",
+                    "enum": [
+                      "newline",
+                      "length_prefixed"
+                    ]
+                },
+                "num_children": {
+                    "type": "integer",
+                    "minimum": 1
+                },
+                "max_pending_kb": {
+                    "type": "integer",
+                    "minimum": 1
                 }
             },
             "required": [
@@ -797,6 +1093,9 @@ const char config_schema_string[] = LONG_STRING_CONST(
                 "prometheus_metrics_enabled": {
                     "type": "boolean"
                 },
+                "prometheus_metrics_gzip_enabled": {
+                    "type": "boolean"
+                },
                 "ssl_enabled": {
                     "type": "boolean"
                 },
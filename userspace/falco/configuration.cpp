@@ -74,11 +74,15 @@ falco_configuration::falco_configuration():
         m_watch_config_files(true),
         m_buffered_outputs(false),
         m_outputs_queue_capacity(DEFAULT_OUTPUTS_QUEUE_CAPACITY_UNBOUNDED_MAX_LONG_VALUE),
+        m_outputs_queue_shed_threshold(0.8),
+        m_outputs_queue_per_output(false),
         m_time_format_iso_8601(false),
         m_buffer_format_base64(false),
         m_output_timeout(2000),
         m_grpc_enabled(false),
         m_grpc_threadiness(0),
+        m_grpc_batch_size(100),
+        m_grpc_batch_max_delay_ms(100),
         m_webserver_enabled(false),
         m_syscall_evt_drop_threshold(.1),
         m_syscall_evt_drop_rate(.03333),
@@ -93,6 +97,11 @@ falco_configuration::falco_configuration():
         m_falco_libs_snaplen(0),
         m_base_syscalls_all(false),
         m_base_syscalls_repair(false),
+        m_rule_evaluation_profiling_enabled(false),
+        m_rule_evaluation_profiling_sampling_ratio(100),
+        m_rule_evaluation_field_extraction_cache_enabled(false),
+        m_rule_evaluation_string_predicate_folding_enabled(false),
+        m_rule_evaluation_condition_optimizer_enabled(false),
         m_metrics_enabled(false),
         m_metrics_interval_str("5000"),
         m_metrics_interval(5000),
@@ -371,6 +380,39 @@ void falco_configuration::load_yaml(const std::string &config_name) {
 		keep_alive = m_config.get_scalar<std::string>("file_output.keep_alive", "");
 		file_output.options["keep_alive"] = keep_alive;
 
+		uint64_t buffer_size_kb = m_config.get_scalar<uint64_t>("file_output.buffer_size_kb", 256);
+		uint64_t flush_interval_ms =
+		        m_config.get_scalar<uint64_t>("file_output.flush_interval_ms", 1000);
+		if(buffer_size_kb == 0 || flush_interval_ms == 0 || flush_interval_ms > INT32_MAX) {
+			throw std::logic_error("Error reading config file (" + config_name +
+			                       "): file_output buffering bounds must be greater than 0");
+		}
+		file_output.options["buffer_size"] = std::to_string(buffer_size_kb * 1024);
+		file_output.options["flush_interval_ms"] = std::to_string(flush_interval_ms);
+
+		std::string fsync = m_config.get_scalar<std::string>("file_output.fsync", "never");
+		if(fsync != "never" && fsync != "flush" && fsync != "rotation") {
+			throw std::logic_error("Error reading config file (" + config_name +
+			                       "): file_output.fsync must be one of never, flush, rotation");
+		}
+		file_output.options["fsync"] = fsync;
+
+		file_output.options["rotation_max_size"] = std::to_string(
+		        m_config.get_scalar<uint64_t>("file_output.rotation.max_size_mb", 0) * 1024 *
+		        1024);
+		file_output.options["rotation_max_age_sec"] = std::to_string(
+		        m_config.get_scalar<uint64_t>("file_output.rotation.max_age_sec", 0));
+		file_output.options["rotation_max_files"] = std::to_string(
+		        m_config.get_scalar<uint64_t>("file_output.rotation.max_files", 0));
+		std::string compression =
+		        m_config.get_scalar<std::string>("file_output.rotation.compression", "none");
+		if(compression != "none" && compression != "gzip") {
+			throw std::logic_error("Error reading config file (" + config_name +
+			                       "): file_output.rotation.compression must be one of none, "
+			                       "gzip");
+		}
+		file_output.options["rotation_compression"] = compression;
+
 		m_outputs.push_back(file_output);
 	}
 
@@ -401,6 +443,26 @@ void falco_configuration::load_yaml(const std::string &config_name) {
 		keep_alive = m_config.get_scalar<std::string>("program_output.keep_alive", "");
 		program_output.options["keep_alive"] = keep_alive;
 
+		std::string framing =
+		        m_config.get_scalar<std::string>("program_output.framing", "newline");
+		if(framing != "newline" && framing != "length_prefixed") {
+			throw std::logic_error("Error reading config file (" + config_name +
+			                       "): program_output.framing must be one of newline, "
+			                       "length_prefixed");
+		}
+		program_output.options["framing"] = framing;
+
+		uint64_t num_children = m_config.get_scalar<uint64_t>("program_output.num_children", 1);
+		uint64_t max_pending_kb =
+		        m_config.get_scalar<uint64_t>("program_output.max_pending_kb", 1024);
+		if(num_children == 0 || max_pending_kb == 0) {
+			throw std::logic_error("Error reading config file (" + config_name +
+			                       "): program_output.num_children and "
+			                       "program_output.max_pending_kb must be greater than 0");
+		}
+		program_output.options["num_children"] = std::to_string(num_children);
+		program_output.options["max_pending"] = std::to_string(max_pending_kb * 1024);
+
 		m_outputs.push_back(program_output);
 	}
 
@@ -469,6 +531,37 @@ void falco_configuration::load_yaml(const std::string &config_name) {
 		        m_config.get_scalar<uint8_t>("http_output.max_consecutive_timeouts", 5);
 		http_output.options["max_consecutive_timeouts"] = std::to_string(max_consecutive_timeouts);
 
+		bool batch_enabled = m_config.get_scalar<bool>("http_output.batching.enabled", false);
+		http_output.options["batch_enabled"] =
+		        batch_enabled ? std::string("true") : std::string("false");
+
+		std::string batch_format =
+		        m_config.get_scalar<std::string>("http_output.batching.format", "ndjson");
+		if(batch_format != "ndjson" && batch_format != "json_array") {
+			throw std::logic_error("Error reading config file (" + config_name +
+			                       "): http_output.batching.format must be one of ndjson, "
+			                       "json_array");
+		}
+		http_output.options["batch_format"] = batch_format;
+
+		uint64_t batch_max_messages =
+		        m_config.get_scalar<uint64_t>("http_output.batching.max_messages", 100);
+		uint64_t batch_max_bytes =
+		        m_config.get_scalar<uint64_t>("http_output.batching.max_bytes", 1048576);
+		uint64_t batch_flush_interval_ms =
+		        m_config.get_scalar<uint64_t>("http_output.batching.flush_interval_ms", 1000);
+		uint64_t max_in_flight =
+		        m_config.get_scalar<uint64_t>("http_output.batching.max_in_flight", 4);
+		if(batch_max_messages == 0 || batch_max_bytes == 0 || batch_flush_interval_ms == 0 ||
+		   batch_flush_interval_ms > INT32_MAX || max_in_flight == 0) {
+			throw std::logic_error("Error reading config file (" + config_name +
+			                       "): http_output.batching bounds must be greater than 0");
+		}
+		http_output.options["batch_max_messages"] = std::to_string(batch_max_messages);
+		http_output.options["batch_max_bytes"] = std::to_string(batch_max_bytes);
+		http_output.options["batch_flush_interval_ms"] = std::to_string(batch_flush_interval_ms);
+		http_output.options["max_in_flight"] = std::to_string(max_in_flight);
+
 		m_outputs.push_back(http_output);
 	}
 
@@ -485,9 +578,39 @@ void falco_configuration::load_yaml(const std::string &config_name) {
 	        m_config.get_scalar<std::string>("grpc.cert_chain", "/etc/falco/certs/server.crt");
 	m_grpc_root_certs =
 	        m_config.get_scalar<std::string>("grpc.root_certs", "/etc/falco/certs/ca.crt");
+	m_grpc_batch_size = m_config.get_scalar<uint64_t>("grpc.batch_size", 100);
+	m_grpc_batch_max_delay_ms = m_config.get_scalar<uint32_t>("grpc.batch_max_delay_ms", 100);
+	if(m_grpc_batch_size == 0 || m_grpc_batch_max_delay_ms == 0) {
+		throw std::logic_error("Error reading config file (" + config_name +
+		                       "): grpc.batch_size and grpc.batch_max_delay_ms must be greater "
+		                       "than 0");
+	}
+	m_grpc_cpu_affinity.clear();
+	m_config.get_sequence(m_grpc_cpu_affinity, "grpc.cpu_affinity");
 
 	falco::outputs::config grpc_output;
 	grpc_output.name = "grpc";
+	uint64_t subscriber_buffer_size =
+	        m_config.get_scalar<uint64_t>("grpc_output.subscriber_buffer_size", 10000);
+	if(subscriber_buffer_size == 0) {
+		throw std::logic_error("Error reading config file (" + config_name +
+		                       "): grpc_output.subscriber_buffer_size must be greater than 0");
+	}
+	// Otherwise, the batches would never be full
+	if(m_grpc_batch_size > subscriber_buffer_size) {
+		throw std::logic_error("Error reading config file (" + config_name +
+		                       "): grpc.batch_size must not be greater than "
+		                       "grpc_output.subscriber_buffer_size");
+	}
+	grpc_output.options["subscriber_buffer_size"] = std::to_string(subscriber_buffer_size);
+	std::string slow_subscriber_policy =
+	        m_config.get_scalar<std::string>("grpc_output.slow_subscriber_policy", "drop_oldest");
+	if(slow_subscriber_policy != "drop_oldest" && slow_subscriber_policy != "disconnect") {
+		throw std::logic_error("Error reading config file (" + config_name +
+		                       "): grpc_output.slow_subscriber_policy must be one of drop_oldest, "
+		                       "disconnect");
+	}
+	grpc_output.options["slow_subscriber_policy"] = slow_subscriber_policy;
 	// gRPC output is enabled only if gRPC server is enabled too
 	if(m_config.get_scalar<bool>("grpc_output.enabled", true) && m_grpc_enabled) {
 		m_outputs.push_back(grpc_output);
@@ -516,6 +639,55 @@ void falco_configuration::load_yaml(const std::string &config_name) {
 	if(m_outputs_queue_capacity == 0) {
 		m_outputs_queue_capacity = DEFAULT_OUTPUTS_QUEUE_CAPACITY_UNBOUNDED_MAX_LONG_VALUE;
 	}
+	m_outputs_queue_shed_threshold =
+	        m_config.get_scalar<double>("outputs_queue.shed_threshold", 0.8);
+	if(m_outputs_queue_shed_threshold < 0 || m_outputs_queue_shed_threshold > 1) {
+		throw std::logic_error("Error reading config file (" + config_name +
+		                       "): outputs_queue.shed_threshold must be between 0 and 1");
+	}
+	m_outputs_queue_per_output = m_config.get_scalar<bool>("outputs_queue.per_output", false);
+
+	m_outputs_queue_spool = {};
+	m_outputs_queue_spool.enabled = m_config.get_scalar<bool>("outputs_queue.spool.enabled", false);
+	m_outputs_queue_spool.directory =
+	        m_config.get_scalar<std::string>("outputs_queue.spool.directory", "/var/spool/falco");
+	m_config.get_sequence(m_outputs_queue_spool.outputs, "outputs_queue.spool.outputs");
+	m_outputs_queue_spool.segment_size =
+	        m_config.get_scalar<size_t>("outputs_queue.spool.segment_size_mb", 16) * 1024 * 1024;
+	m_outputs_queue_spool.max_size =
+	        m_config.get_scalar<size_t>("outputs_queue.spool.max_size_mb", 1024) * 1024 * 1024;
+	if(m_outputs_queue_spool.enabled && !m_outputs_queue_per_output) {
+		throw std::logic_error("Error reading config file (" + config_name +
+		                       "): outputs_queue.spool requires outputs_queue.per_output");
+	}
+	if(m_outputs_queue_spool.enabled &&
+	   m_outputs_queue_spool.segment_size > m_outputs_queue_spool.max_size) {
+		throw std::logic_error("Error reading config file (" + config_name +
+		                       "): outputs_queue.spool.segment_size_mb must not exceed "
+		                       "outputs_queue.spool.max_size_mb");
+	}
+
+	m_alert_throttling = {};
+	m_alert_throttling.window_ns =
+	        m_config.get_scalar<uint64_t>("alert_throttling.window_sec", 10) * 1000000000ULL;
+	m_alert_throttling.rate_limit_enabled =
+	        m_config.get_scalar<bool>("alert_throttling.rate_limit.enabled", false);
+	m_alert_throttling.rate = m_config.get_scalar<double>("alert_throttling.rate_limit.rate", 10);
+	m_alert_throttling.max_burst =
+	        m_config.get_scalar<double>("alert_throttling.rate_limit.max_burst", 100);
+	m_alert_throttling.dedup_enabled =
+	        m_config.get_scalar<bool>("alert_throttling.dedup.enabled", false);
+	m_config.get_sequence(m_alert_throttling.dedup_key_fields, "alert_throttling.dedup.key_fields");
+	if(m_alert_throttling.enabled() && m_alert_throttling.window_ns == 0) {
+		throw std::logic_error("Error reading config file (" + config_name +
+		                       "): alert_throttling.window_sec must be greater than 0");
+	}
+	if(m_alert_throttling.rate_limit_enabled &&
+	   (m_alert_throttling.rate <= 0 || m_alert_throttling.max_burst < 1)) {
+		throw std::logic_error("Error reading config file (" + config_name +
+		                       "): alert_throttling.rate_limit.rate must be greater than 0 and "
+		                       "alert_throttling.rate_limit.max_burst at least 1");
+	}
 
 	m_time_format_iso_8601 = m_config.get_scalar<bool>("time_format_iso_8601", false);
 	m_buffer_format_base64 = m_config.get_scalar<bool>("buffer_format_base64", false);
@@ -541,6 +713,8 @@ void falco_configuration::load_yaml(const std::string &config_name) {
 	}
 	m_webserver_config.m_prometheus_metrics_enabled =
 	        m_config.get_scalar<bool>("webserver.prometheus_metrics_enabled", false);
+	m_webserver_config.m_prometheus_metrics_gzip_enabled =
+	        m_config.get_scalar<bool>("webserver.prometheus_metrics_gzip_enabled", true);
 
 	std::list<std::string> syscall_event_drop_acts;
 	m_config.get_sequence(syscall_event_drop_acts, "syscall_event_drops.actions");
@@ -614,6 +788,37 @@ void falco_configuration::load_yaml(const std::string &config_name) {
 	m_base_syscalls_repair = m_config.get_scalar<bool>("base_syscalls.repair", false);
 	m_base_syscalls_all = m_config.get_scalar<bool>("base_syscalls.all", false);
 
+	m_rule_evaluation_adaptive_ordering.enabled =
+	        m_config.get_scalar<bool>("rule_evaluation.adaptive_ordering.enabled", false);
+	m_rule_evaluation_adaptive_ordering.sampling_ratio =
+	        m_config.get_scalar<uint32_t>("rule_evaluation.adaptive_ordering.sampling_ratio", 64);
+	m_rule_evaluation_adaptive_ordering.reorder_interval = m_config.get_scalar<uint64_t>(
+	        "rule_evaluation.adaptive_ordering.reorder_interval",
+	        100000);
+	if(m_rule_evaluation_adaptive_ordering.sampling_ratio == 0 ||
+	   m_rule_evaluation_adaptive_ordering.reorder_interval == 0) {
+		throw std::logic_error(
+		        "Error reading config file (" + config_name +
+		        "): rule_evaluation.adaptive_ordering sampling_ratio and reorder_interval must be "
+		        "greater than 0");
+	}
+
+	m_rule_evaluation_profiling_enabled =
+	        m_config.get_scalar<bool>("rule_evaluation.profiling.enabled", false);
+	m_rule_evaluation_profiling_sampling_ratio =
+	        m_config.get_scalar<uint32_t>("rule_evaluation.profiling.sampling_ratio", 100);
+	if(m_rule_evaluation_profiling_sampling_ratio == 0) {
+		throw std::logic_error("Error reading config file (" + config_name +
+		                       "): rule_evaluation.profiling.sampling_ratio must be greater than 0");
+	}
+
+	m_rule_evaluation_field_extraction_cache_enabled =
+	        m_config.get_scalar<bool>("rule_evaluation.field_extraction_cache.enabled", false);
+	m_rule_evaluation_string_predicate_folding_enabled =
+	        m_config.get_scalar<bool>("rule_evaluation.string_predicate_folding.enabled", false);
+	m_rule_evaluation_condition_optimizer_enabled =
+	        m_config.get_scalar<bool>("rule_evaluation.condition_optimizer.enabled", false);
+
 	m_metrics_enabled = m_config.get_scalar<bool>("metrics.enabled", false);
 	m_metrics_interval_str = m_config.get_scalar<std::string>("metrics.interval", "5000");
 	m_metrics_interval = falco::utils::parse_prometheus_interval(m_metrics_interval_str);
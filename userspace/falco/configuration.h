@@ -95,6 +95,7 @@ public:
 		bool m_ssl_enabled = false;
 		std::string m_ssl_certificate;
 		bool m_prometheus_metrics_enabled = false;
+		bool m_prometheus_metrics_gzip_enabled = true;
 	};
 
 	enum class rule_selection_operation { enable, disable };
@@ -166,6 +167,10 @@ public:
 	bool m_watch_config_files;
 	bool m_buffered_outputs;
 	size_t m_outputs_queue_capacity;
+	double m_outputs_queue_shed_threshold;
+	bool m_outputs_queue_per_output;
+	falco::outputs::spool_config m_outputs_queue_spool;
+	alert_throttler::config m_alert_throttling;
 	bool m_time_format_iso_8601;
 	bool m_buffer_format_base64;
 	uint32_t m_output_timeout;
@@ -176,6 +181,9 @@ public:
 	std::string m_grpc_private_key;
 	std::string m_grpc_cert_chain;
 	std::string m_grpc_root_certs;
+	uint64_t m_grpc_batch_size;
+	uint32_t m_grpc_batch_max_delay_ms;
+	std::vector<uint32_t> m_grpc_cpu_affinity;
 
 	bool m_webserver_enabled;
 	webserver_config m_webserver_config;
@@ -199,6 +207,14 @@ public:
 	bool m_base_syscalls_all;
 	bool m_base_syscalls_repair;
 
+	// rule evaluation tuning configs
+	filter_ruleset::adaptive_ordering_config m_rule_evaluation_adaptive_ordering;
+	bool m_rule_evaluation_profiling_enabled;
+	uint32_t m_rule_evaluation_profiling_sampling_ratio;
+	bool m_rule_evaluation_field_extraction_cache_enabled;
+	bool m_rule_evaluation_string_predicate_folding_enabled;
+	bool m_rule_evaluation_condition_optimizer_enabled;
+
 	// metrics configs
 	bool m_metrics_enabled;
 	std::string m_metrics_interval_str;
@@ -20,9 +20,12 @@ limitations under the License.
 #include "falco_metrics.h"
 
 #include "app/state.h"
+#include "falco_utils.h"
 
 #include <libsinsp/sinsp.h>
 
+#include <cstdio>
+
 #ifdef HAS_JEMALLOC
 #include <jemalloc.h>
 #endif
@@ -100,6 +103,51 @@ static std::string convert_metric_to_text_prometheus_with_deprecation_notice(
 	return prometheus_text;
 }
 
+static std::string escape_prometheus_label_value(const std::string& value) {
+	std::string escaped;
+	escaped.reserve(value.size());
+	for(char c : value) {
+		switch(c) {
+		case '\\':
+			escaped += "\\\\";
+			break;
+		case '"':
+			escaped += "\\\"";
+			break;
+		case '\n':
+			escaped += "\\n";
+			break;
+		default:
+			escaped += c;
+			break;
+		}
+	}
+	return escaped;
+}
+
+// Helper function to convert the sampled evaluation cost of a rule to the samples of a
+// prometheus histogram, the HELP and TYPE lines are expected to be emitted once by the caller
+static std::string convert_rule_profile_to_text_prometheus(
+        const std::string& metric_name,
+        const falco_rule& rule,
+        const stats_manager::rule_profile& profile) {
+	std::string labels = "rule_name=\"" + escape_prometheus_label_value(rule.name) +
+	                     "\",source=\"" + escape_prometheus_label_value(rule.source) + "\"";
+	std::string prometheus_text;
+	uint64_t cumulative = 0;
+	for(size_t i = 0; i < stats_manager::num_profile_buckets; i++) {
+		cumulative += profile.buckets[i].load();
+		uint64_t upper_bound = stats_manager::profile_bucket_upper_bound(i);
+		std::string le = upper_bound == UINT64_MAX ? "+Inf" : std::to_string(upper_bound);
+		prometheus_text += metric_name + "_bucket{" + labels + ",le=\"" + le + "\"} " +
+		                   std::to_string(cumulative) + "\n";
+	}
+	prometheus_text += metric_name + "_sum{" + labels + "} " +
+	                   std::to_string(profile.total_ns.load()) + "\n";
+	prometheus_text += metric_name + "_count{" + labels + "} " + std::to_string(cumulative) + "\n";
+	return prometheus_text;
+}
+
 std::string falco_metrics::falco_to_text_prometheus(
         const falco::app::state& state,
         libs::metrics::prometheus_metrics_converter& prometheus_metrics_converter,
@@ -158,6 +206,216 @@ std::string falco_metrics::falco_to_text_prometheus(
 	        METRIC_VALUE_METRIC_TYPE_MONOTONIC,
 	        state.outputs->get_outputs_queue_num_drops()));
 
+	// # HELP falcosecurity_falco_outputs_rate_limited_alerts_total https://falco.org/docs/metrics/
+	// # TYPE falcosecurity_falco_outputs_rate_limited_alerts_total counter
+	// falcosecurity_falco_outputs_rate_limited_alerts_total 0
+	additional_wrapper_metrics.emplace_back(libs::metrics::libsinsp_metrics::new_metric(
+	        "outputs_rate_limited_alerts",
+	        METRICS_V2_MISC,
+	        METRIC_VALUE_TYPE_U64,
+	        METRIC_VALUE_UNIT_COUNT,
+	        METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+	        state.outputs->get_num_rate_limited_alerts()));
+
+	// # HELP falcosecurity_falco_outputs_deduplicated_alerts_total https://falco.org/docs/metrics/
+	// # TYPE falcosecurity_falco_outputs_deduplicated_alerts_total counter
+	// falcosecurity_falco_outputs_deduplicated_alerts_total 0
+	additional_wrapper_metrics.emplace_back(libs::metrics::libsinsp_metrics::new_metric(
+	        "outputs_deduplicated_alerts",
+	        METRICS_V2_MISC,
+	        METRIC_VALUE_TYPE_U64,
+	        METRIC_VALUE_UNIT_COUNT,
+	        METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+	        state.outputs->get_num_deduplicated_alerts()));
+
+	// # HELP falcosecurity_falco_outputs_queue_num_drops_by_priority_total
+	// https://falco.org/docs/metrics/
+	// # TYPE falcosecurity_falco_outputs_queue_num_drops_by_priority_total counter
+	// falcosecurity_falco_outputs_queue_num_drops_by_priority_total{priority="Notice"} 0
+	for(const auto& [priority, num_drops] :
+	    state.outputs->get_outputs_queue_num_drops_by_priority()) {
+		auto metric = libs::metrics::libsinsp_metrics::new_metric(
+		        "outputs_queue_num_drops_by_priority",
+		        METRICS_V2_MISC,
+		        METRIC_VALUE_TYPE_U64,
+		        METRIC_VALUE_UNIT_COUNT,
+		        METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+		        num_drops);
+		prometheus_metrics_converter.convert_metric_to_unit_convention(metric);
+		prometheus_text += prometheus_metrics_converter.convert_metric_to_text_prometheus(
+		        metric,
+		        "falcosecurity",
+		        "falco",
+		        {{"priority", priority}});
+	}
+
+	// # HELP falcosecurity_falco_outputs_queue_num_drops_by_rule_total
+	// https://falco.org/docs/metrics/
+	// # TYPE falcosecurity_falco_outputs_queue_num_drops_by_rule_total counter
+	// falcosecurity_falco_outputs_queue_num_drops_by_rule_total{rule_name="Terminal shell in
+	// container"} 0
+	for(const auto& [rule, num_drops] : state.outputs->get_outputs_queue_num_drops_by_rule()) {
+		auto metric = libs::metrics::libsinsp_metrics::new_metric(
+		        "outputs_queue_num_drops_by_rule",
+		        METRICS_V2_MISC,
+		        METRIC_VALUE_TYPE_U64,
+		        METRIC_VALUE_UNIT_COUNT,
+		        METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+		        num_drops);
+		prometheus_metrics_converter.convert_metric_to_unit_convention(metric);
+		prometheus_text += prometheus_metrics_converter.convert_metric_to_text_prometheus(
+		        metric,
+		        "falcosecurity",
+		        "falco",
+		        {{"rule_name", rule}});
+	}
+
+	// # HELP falcosecurity_falco_outputs_num_drops_total https://falco.org/docs/metrics/
+	// # TYPE falcosecurity_falco_outputs_num_drops_total counter
+	// falcosecurity_falco_outputs_num_drops_total{output="http"} 0
+	for(const auto& [output, num_drops] : state.outputs->get_outputs_num_drops()) {
+		auto metric = libs::metrics::libsinsp_metrics::new_metric(
+		        "outputs_num_drops",
+		        METRICS_V2_MISC,
+		        METRIC_VALUE_TYPE_U64,
+		        METRIC_VALUE_UNIT_COUNT,
+		        METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+		        num_drops);
+		prometheus_metrics_converter.convert_metric_to_unit_convention(metric);
+		prometheus_text += prometheus_metrics_converter.convert_metric_to_text_prometheus(
+		        metric,
+		        "falcosecurity",
+		        "falco",
+		        {{"output", output}});
+	}
+
+	// # HELP falcosecurity_falco_outputs_spool_depth https://falco.org/docs/metrics/
+	// # TYPE falcosecurity_falco_outputs_spool_depth gauge
+	// falcosecurity_falco_outputs_spool_depth{output="http"} 0
+	for(const auto& [output, spool_stats] : state.outputs->get_outputs_spool_stats()) {
+		std::vector<metrics_v2> spool_metrics = {
+		        libs::metrics::libsinsp_metrics::new_metric(
+		                "outputs_spool_depth",
+		                METRICS_V2_MISC,
+		                METRIC_VALUE_TYPE_U64,
+		                METRIC_VALUE_UNIT_COUNT,
+		                METRIC_VALUE_METRIC_TYPE_NON_MONOTONIC_CURRENT,
+		                spool_stats.depth),
+		        libs::metrics::libsinsp_metrics::new_metric(
+		                "outputs_spool_disk_usage_bytes",
+		                METRICS_V2_MISC,
+		                METRIC_VALUE_TYPE_U64,
+		                METRIC_VALUE_UNIT_MEMORY_BYTES,
+		                METRIC_VALUE_METRIC_TYPE_NON_MONOTONIC_CURRENT,
+		                spool_stats.bytes),
+		        libs::metrics::libsinsp_metrics::new_metric(
+		                "outputs_spool_drained",
+		                METRICS_V2_MISC,
+		                METRIC_VALUE_TYPE_U64,
+		                METRIC_VALUE_UNIT_COUNT,
+		                METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+		                spool_stats.drained),
+		};
+		for(auto& metric : spool_metrics) {
+			prometheus_metrics_converter.convert_metric_to_unit_convention(metric);
+			prometheus_text += prometheus_metrics_converter.convert_metric_to_text_prometheus(
+			        metric,
+			        "falcosecurity",
+			        "falco",
+			        {{"output", output}});
+		}
+	}
+
+	// # HELP falcosecurity_falco_outputs_http_requests_total https://falco.org/docs/metrics/
+	// # TYPE falcosecurity_falco_outputs_http_requests_total counter
+	// falcosecurity_falco_outputs_http_requests_total 0
+	for(const auto& [name, value] : state.outputs->get_outputs_metrics()) {
+		additional_wrapper_metrics.emplace_back(libs::metrics::libsinsp_metrics::new_metric(
+		        ("outputs_" + name).c_str(),
+		        METRICS_V2_MISC,
+		        METRIC_VALUE_TYPE_U64,
+		        METRIC_VALUE_UNIT_COUNT,
+		        METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+		        value));
+	}
+
+	// # HELP falcosecurity_falco_formatter_cache_hits_total https://falco.org/docs/metrics/
+	// # TYPE falcosecurity_falco_formatter_cache_hits_total counter
+	// falcosecurity_falco_formatter_cache_hits_total 0
+	additional_wrapper_metrics.emplace_back(libs::metrics::libsinsp_metrics::new_metric(
+	        "formatter_cache_hits",
+	        METRICS_V2_MISC,
+	        METRIC_VALUE_TYPE_U64,
+	        METRIC_VALUE_UNIT_COUNT,
+	        METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+	        state.engine->get_formatter_cache_hits()));
+
+	// # HELP falcosecurity_falco_formatter_cache_misses_total https://falco.org/docs/metrics/
+	// # TYPE falcosecurity_falco_formatter_cache_misses_total counter
+	// falcosecurity_falco_formatter_cache_misses_total 0
+	additional_wrapper_metrics.emplace_back(libs::metrics::libsinsp_metrics::new_metric(
+	        "formatter_cache_misses",
+	        METRICS_V2_MISC,
+	        METRIC_VALUE_TYPE_U64,
+	        METRIC_VALUE_UNIT_COUNT,
+	        METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+	        state.engine->get_formatter_cache_misses()));
+
+	if(state.config->m_rule_evaluation_adaptive_ordering.enabled) {
+		auto ordering_stats = state.engine->get_adaptive_rule_ordering_stats();
+
+		// # HELP falcosecurity_falco_rules_adaptive_reorders_total https://falco.org/docs/metrics/
+		// # TYPE falcosecurity_falco_rules_adaptive_reorders_total counter
+		// falcosecurity_falco_rules_adaptive_reorders_total 0
+		additional_wrapper_metrics.emplace_back(libs::metrics::libsinsp_metrics::new_metric(
+		        "rules_adaptive_reorders",
+		        METRICS_V2_MISC,
+		        METRIC_VALUE_TYPE_U64,
+		        METRIC_VALUE_UNIT_COUNT,
+		        METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+		        ordering_stats.num_reorders));
+
+		// # HELP falcosecurity_falco_rules_adaptive_estimated_saved_nanoseconds_total
+		// https://falco.org/docs/metrics/
+		// # TYPE falcosecurity_falco_rules_adaptive_estimated_saved_nanoseconds_total counter
+		// falcosecurity_falco_rules_adaptive_estimated_saved_nanoseconds_total 0
+		additional_wrapper_metrics.emplace_back(libs::metrics::libsinsp_metrics::new_metric(
+		        "rules_adaptive_estimated_saved_ns",
+		        METRICS_V2_MISC,
+		        METRIC_VALUE_TYPE_U64,
+		        METRIC_VALUE_UNIT_TIME_NS_COUNT,
+		        METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+		        ordering_stats.estimated_saved_ns));
+	}
+
+	if(state.config->m_rule_evaluation_field_extraction_cache_enabled) {
+		auto cache_metrics = state.engine->get_filter_cache_metrics();
+
+		// # HELP falcosecurity_falco_rules_field_extractions_total
+		// https://falco.org/docs/metrics/
+		// # TYPE falcosecurity_falco_rules_field_extractions_total counter
+		// falcosecurity_falco_rules_field_extractions_total 0
+		additional_wrapper_metrics.emplace_back(libs::metrics::libsinsp_metrics::new_metric(
+		        "rules_field_extractions",
+		        METRICS_V2_MISC,
+		        METRIC_VALUE_TYPE_U64,
+		        METRIC_VALUE_UNIT_COUNT,
+		        METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+		        cache_metrics.m_num_extract));
+
+		// # HELP falcosecurity_falco_rules_field_extractions_cached_total
+		// https://falco.org/docs/metrics/
+		// # TYPE falcosecurity_falco_rules_field_extractions_cached_total counter
+		// falcosecurity_falco_rules_field_extractions_cached_total 0
+		additional_wrapper_metrics.emplace_back(libs::metrics::libsinsp_metrics::new_metric(
+		        "rules_field_extractions_cached",
+		        METRICS_V2_MISC,
+		        METRIC_VALUE_TYPE_U64,
+		        METRIC_VALUE_UNIT_COUNT,
+		        METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+		        cache_metrics.m_num_extract_cache));
+	}
+
 	// # HELP falcosecurity_falco_reload_timestamp_nanoseconds https://falco.org/docs/metrics/
 	// # TYPE falcosecurity_falco_reload_timestamp_nanoseconds gauge
 	// falcosecurity_falco_reload_timestamp_nanoseconds 1748338536592811359
@@ -216,6 +474,35 @@ std::string falco_metrics::falco_to_text_prometheus(
 				        const_labels);
 			}
 		}
+
+		if(state.config->m_rule_evaluation_profiling_enabled) {
+			// # HELP falcosecurity_falco_rules_evaluation_duration_nanoseconds
+			// https://falco.org/docs/metrics/
+			// # TYPE falcosecurity_falco_rules_evaluation_duration_nanoseconds histogram
+			// falcosecurity_falco_rules_evaluation_duration_nanoseconds_bucket{rule_name="Terminal
+			// shell in container",source="syscall",le="128"} 1204
+			// ...
+			// falcosecurity_falco_rules_evaluation_duration_nanoseconds_sum{rule_name="Terminal
+			// shell in container",source="syscall"} 301542
+			// falcosecurity_falco_rules_evaluation_duration_nanoseconds_count{rule_name="Terminal
+			// shell in container",source="syscall"} 1337
+			const std::string metric_name =
+			        "falcosecurity_falco_rules_evaluation_duration_nanoseconds";
+			const auto& profiles = rule_stats_manager.get_profile_by_rule_id();
+			std::string histogram_text;
+			for(size_t i = 0; i < profiles.size(); i++) {
+				if(profiles[i]->num_evals.load() > 0) {
+					histogram_text += convert_rule_profile_to_text_prometheus(metric_name,
+					                                                          *rules.at(i),
+					                                                          *profiles[i]);
+				}
+			}
+			if(!histogram_text.empty()) {
+				prometheus_text += "# HELP " + metric_name + " https://falco.org/docs/metrics/\n";
+				prometheus_text += "# TYPE " + metric_name + " histogram\n";
+				prometheus_text += histogram_text;
+			}
+		}
 	}
 #ifdef HAS_JEMALLOC
 	if(state.config->m_metrics_flags & METRICS_V2_JEMALLOC_STATS) {
@@ -543,3 +830,22 @@ std::string falco_metrics::to_text_prometheus(const falco::app::state& state) {
 
 	return prometheus_text;
 }
+
+std::shared_ptr<const falco_metrics::prometheus_snapshot> falco_metrics::to_prometheus_snapshot(
+        const falco::app::state& state,
+        bool gzip) {
+	auto res = std::make_shared<prometheus_snapshot>();
+	res->text = to_text_prometheus(state);
+	if(gzip) {
+		falco::utils::gzip_compress(res->text, res->text_gzip);
+	}
+	char etag[32];
+	auto hash = std::hash<std::string>{}(res->text);
+	snprintf(etag, sizeof(etag), "\"%016zx\"", hash);
+	res->etag = etag;
+	if(!res->text_gzip.empty()) {
+		snprintf(etag, sizeof(etag), "\"%016zx-gzip\"", hash);
+		res->etag_gzip = etag;
+	}
+	return res;
+}
@@ -20,14 +20,32 @@ limitations under the License.
 
 #include <libsinsp/sinsp.h>
 
+#include <memory>
+#include <string>
+
 namespace falco::app {
 struct state;
 }
 
 class falco_metrics {
 public:
+	// The Prometheus text rendered at a given time, immutable once created
+	struct prometheus_snapshot {
+		std::string text;
+		// The text compressed with gzip, empty if not requested or if it failed
+		std::string text_gzip;
+		// An entity tag identifying the text, quoted as in the ETag HTTP header
+		std::string etag;
+		// The entity tag of the compressed text, as the two representations
+		// must have distinct strong entity tags
+		std::string etag_gzip;
+	};
+
 	static const std::string content_type_prometheus;
 	static std::string to_text_prometheus(const falco::app::state& state);
+	static std::shared_ptr<const prometheus_snapshot> to_prometheus_snapshot(
+	        const falco::app::state& state,
+	        bool gzip);
 
 private:
 	static std::string falco_to_text_prometheus(
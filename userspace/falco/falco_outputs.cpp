@@ -19,6 +19,10 @@ limitations under the License.
 #include <google/protobuf/util/time_util.h>
 #endif
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 #include "falco_outputs.h"
 #include "config_falco.h"
 
@@ -39,6 +43,95 @@ limitations under the License.
 
 static const char *s_internal_source = "internal";
 
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+// Spooled messages are encoded as their fixed-size members followed by
+// their length-prefixed strings, in the host byte order, as the spool is
+// only read back by the same host
+template<typename T>
+static void spool_write(std::string &out, const T &v) {
+	out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+static void spool_write(std::string &out, const std::string &s) {
+	spool_write(out, static_cast<uint32_t>(s.size()));
+	out += s;
+}
+
+template<typename T>
+static bool spool_read(const std::string &in, size_t &offset, T &v) {
+	if(in.size() - offset < sizeof(v)) {
+		return false;
+	}
+	memcpy(&v, in.data() + offset, sizeof(v));
+	offset += sizeof(v);
+	return true;
+}
+
+static bool spool_read(const std::string &in, size_t &offset, std::string &s) {
+	uint32_t len;
+	if(!spool_read(in, offset, len) || in.size() - offset < len) {
+		return false;
+	}
+	s.assign(in, offset, len);
+	offset += len;
+	return true;
+}
+
+static void encode_msg(const falco::outputs::message &msg, std::string &out) {
+	out.clear();
+	spool_write(out, msg.ts);
+	spool_write(out, static_cast<uint32_t>(msg.priority));
+	spool_write(out, msg.msg);
+	spool_write(out, *msg.rule);
+	spool_write(out, *msg.source);
+	spool_write(out, static_cast<uint32_t>(msg.tags->size()));
+	for(const auto &tag : *msg.tags) {
+		spool_write(out, tag);
+	}
+	spool_write(out, static_cast<uint32_t>(msg.fields.size()));
+	for(const auto &f : msg.fields) {
+		spool_write(out, f.first);
+		spool_write(out, f.second);
+	}
+}
+
+static bool decode_msg(const std::string &in,
+                       falco::outputs::message &msg,
+                       std::string &rule,
+                       std::string &source,
+                       std::set<std::string> &tags) {
+	size_t offset = 0;
+	uint32_t priority, num;
+	if(!spool_read(in, offset, msg.ts) || !spool_read(in, offset, priority) ||
+	   !spool_read(in, offset, msg.msg) || !spool_read(in, offset, rule) ||
+	   !spool_read(in, offset, source) || !spool_read(in, offset, num)) {
+		return false;
+	}
+	msg.priority = static_cast<falco_common::priority_type>(priority);
+
+	tags.clear();
+	std::string tag;
+	for(uint32_t i = 0; i < num; i++) {
+		if(!spool_read(in, offset, tag)) {
+			return false;
+		}
+		tags.insert(tag);
+	}
+
+	if(!spool_read(in, offset, num)) {
+		return false;
+	}
+	for(uint32_t i = 0; i < num; i++) {
+		std::pair<std::string, std::string> f;
+		if(!spool_read(in, offset, f.first) || !spool_read(in, offset, f.second)) {
+			return false;
+		}
+		msg.fields.push_back(std::move(f));
+	}
+	return offset == in.size();
+}
+#endif
+
 falco_outputs::falco_outputs(std::shared_ptr<falco_engine> engine,
                              const std::vector<falco::outputs::config> &outputs,
                              bool json_output,
@@ -49,8 +142,13 @@ falco_outputs::falco_outputs(std::shared_ptr<falco_engine> engine,
                              uint32_t timeout,
                              bool buffered,
                              size_t outputs_queue_capacity,
+                             double outputs_queue_shed_threshold,
+                             bool per_output_queues,
+                             const falco::outputs::spool_config &spool_config,
+                             const alert_throttler::config &alert_throttling,
                              bool time_format_iso_8601,
                              const std::string &hostname):
+        m_engine(engine),
         m_formats(std::make_unique<falco_formats>(engine,
                                                   json_include_output_property,
                                                   json_include_tags_property,
@@ -58,23 +156,68 @@ falco_outputs::falco_outputs(std::shared_ptr<falco_engine> engine,
                                                   json_include_output_fields_property,
                                                   time_format_iso_8601)),
         m_buffered(buffered),
+        m_per_output_queues(per_output_queues),
+        m_outputs_use_fields(false),
         m_json_output(json_output),
         m_time_format_iso_8601(time_format_iso_8601),
         m_timeout(std::chrono::milliseconds(timeout)),
         m_hostname(hostname) {
+	if(alert_throttling.enabled()) {
+		m_throttler = std::make_unique<alert_throttler>(alert_throttling);
+		for(const auto &field : alert_throttling.dedup_key_fields) {
+			m_dedup_key_format += (m_dedup_key_format.empty() ? "%" : " %") + field;
+		}
+		if(!m_dedup_key_format.empty()) {
+			m_dedup_key_format = falco_formats::lenient_format(m_dedup_key_format);
+		}
+	}
+
 	for(const auto &output : outputs) {
 		add_output(output);
 	}
 
 #ifndef __EMSCRIPTEN__
-	m_queue.set_capacity(outputs_queue_capacity);
-	m_worker_thread = std::thread(&falco_outputs::worker, this);
+	if(m_per_output_queues) {
+		for(const auto &o : m_outputs) {
+			auto channel = std::make_unique<output_channel>();
+			channel->output = o.get();
+			channel->queue.set_capacity(outputs_queue_capacity, outputs_queue_shed_threshold);
+#ifndef _WIN32
+			if(spool_config.enabled && spool_config.outputs.count(o->get_name()) > 0) {
+				channel->spool = std::make_unique<falco::outputs::spool>(
+				        spool_config.directory + "/" + o->get_name(),
+				        spool_config.segment_size,
+				        spool_config.max_size);
+				if(!channel->spool->empty()) {
+					falco_logger::log(falco_logger::level::INFO,
+					                  "Replaying " +
+					                          std::to_string(channel->spool->get_stats().depth) +
+					                          " spooled alerts for output " + o->get_name() +
+					                          "\n");
+				}
+			}
+#endif
+			m_channels.push_back(std::move(channel));
+		}
+		for(const auto &channel : m_channels) {
+			channel->worker_thread =
+			        std::thread(&falco_outputs::channel_worker, this, channel.get());
+		}
+	} else {
+		m_queue.set_capacity(outputs_queue_capacity, outputs_queue_shed_threshold);
+		m_worker_thread = std::thread(&falco_outputs::worker, this);
+	}
 #endif
 }
 
 falco_outputs::~falco_outputs() {
 #ifndef __EMSCRIPTEN__
 	this->stop_worker();
+
+	ctrl_msg *cmsg;
+	while(m_msg_pool.try_pop(cmsg)) {
+		delete cmsg;
+	}
 #endif
 }
 
@@ -111,6 +254,7 @@ void falco_outputs::add_output(const falco::outputs::config &oc) {
 
 	std::string init_err;
 	if(oo->init(oc, m_buffered, m_hostname, m_json_output, init_err)) {
+		m_outputs_use_fields |= oo->uses_fields();
 		m_outputs.push_back(std::move(oo));
 	} else {
 		falco_logger::log(falco_logger::level::ERR, "Failed to init output: " + init_err);
@@ -122,45 +266,104 @@ void falco_outputs::handle_event(sinsp_evt *evt,
                                  const std::string &source,
                                  falco_common::priority_type priority,
                                  const std::string &format,
-                                 std::set<std::string> &tags,
-                                 extra_output_field_t &extra_fields) {
-	falco_outputs::ctrl_msg cmsg = {};
-	cmsg.ts = evt->get_ts();
-	cmsg.priority = priority;
-	cmsg.source = source;
-	cmsg.rule = rule;
-
-	cmsg.msg = m_formats->format_event(evt,
-	                                   rule,
-	                                   source,
-	                                   falco_common::format_priority(priority),
-	                                   format,
-	                                   tags,
-	                                   m_hostname,
-	                                   extra_fields);
-
-	auto fields = m_formats->get_field_values(evt, source, format);
-	for(auto const &ef : extra_fields) {
-		// when formatting for the control message we always want strings,
-		// so we can simply format raw fields as string
-		std::string fformat = ef.second.first;
-		if(fformat.size() == 0) {
-			continue;
+                                 const std::set<std::string> &tags,
+                                 const extra_output_field_t &extra_fields) {
+	// Throttling is decided before paying for the formatting
+	if(m_throttler) {
+		std::map<std::string, std::string> key_fields;
+		if(m_throttler->get_config().dedup_enabled) {
+			get_dedup_key_fields(evt, source, key_fields);
+		}
+		if(!m_throttler->admit(rule, priority, key_fields, evt->get_ts())) {
+			return;
 		}
+	}
 
-		if(!(fformat[0] == '*')) {
-			fformat = "*" + fformat;
+	auto cmsg = acquire_msg();
+	cmsg->ts = evt->get_ts();
+	cmsg->priority = priority;
+	cmsg->source = intern(source);
+	cmsg->rule = intern(rule);
+	cmsg->tags = intern(tags);
+
+	try {
+		// The fields are extracted along with the message, and only when an
+		// output reads them
+		std::map<std::string, std::string> fields;
+		cmsg->msg = m_formats->format_event(evt,
+		                                    rule,
+		                                    source,
+		                                    falco_common::format_priority(priority),
+		                                    format,
+		                                    tags,
+		                                    m_hostname,
+		                                    extra_fields,
+		                                    m_outputs_use_fields ? &fields : nullptr);
+		for(auto &f : fields) {
+			cmsg->fields.emplace_back(f.first, std::move(f.second));
 		}
+	} catch(...) {
+		release_msg(cmsg);
+		throw;
+	}
+
+	cmsg->type = ctrl_msg_type::CTRL_MSG_OUTPUT;
+	this->push(cmsg);
+}
 
-		fields[ef.first] = m_formats->format_string(evt, fformat, source);
+void falco_outputs::get_dedup_key_fields(sinsp_evt *evt,
+                                         const std::string &source,
+                                         std::map<std::string, std::string> &key_fields) {
+	if(m_dedup_key_format.empty()) {
+		return;
 	}
 
-	cmsg.fields = fields;
+	std::shared_ptr<sinsp_evt_formatter> formatter;
+	{
+		std::shared_lock<std::shared_mutex> lock(m_dedup_formatters_mtx);
+		auto it = m_dedup_formatters.find(source);
+		if(it != m_dedup_formatters.end()) {
+			formatter = it->second;
+		}
+	}
+	if(!formatter) {
+		std::unique_lock<std::shared_mutex> lock(m_dedup_formatters_mtx);
+		auto it = m_dedup_formatters.find(source);
+		if(it == m_dedup_formatters.end()) {
+			try {
+				formatter = m_engine->create_formatter(source, m_dedup_key_format);
+			} catch(const std::exception &e) {
+				falco_logger::log(falco_logger::level::WARNING,
+				                  "Alerts of source " + source +
+				                          " are deduplicated by rule only: " + e.what() + "\n");
+			}
+			it = m_dedup_formatters.emplace(source, formatter).first;
+		}
+		formatter = it->second;
+	}
 
-	cmsg.tags.insert(tags.begin(), tags.end());
+	if(formatter) {
+		formatter->get_field_values(evt, key_fields);
+	}
+}
 
-	cmsg.type = ctrl_msg_type::CTRL_MSG_OUTPUT;
-	this->push(cmsg);
+void falco_outputs::close_alert_windows(uint64_t now) {
+	if(!m_throttler) {
+		return;
+	}
+
+	std::vector<alert_throttler::summary> summaries;
+	m_throttler->expire(now, summaries);
+	for(const auto &s : summaries) {
+		nlohmann::json output_fields = nlohmann::json::object();
+		for(const auto &[field, value] : s.key_fields) {
+			output_fields[field] = value;
+		}
+		output_fields["n_suppressed"] = std::to_string(s.num_suppressed);
+		std::string msg = std::to_string(s.num_suppressed) + " alerts of rule \"" + s.rule +
+		                  "\" suppressed by throttling";
+		handle_msg(s.ts, s.priority, msg, s.rule, output_fields);
+	}
 }
 
 void falco_outputs::handle_msg(uint64_t ts,
@@ -172,13 +375,35 @@ void falco_outputs::handle_msg(uint64_t ts,
 		throw falco_exception("falco_outputs: output fields must be key-value maps");
 	}
 
-	falco_outputs::ctrl_msg cmsg = {};
-	cmsg.ts = ts;
-	cmsg.priority = priority;
-	cmsg.source = s_internal_source;
-	cmsg.rule = rule;
-	cmsg.fields = output_fields;
+	auto cmsg = acquire_msg();
+	cmsg->ts = ts;
+	cmsg->priority = priority;
+	cmsg->source = intern(s_internal_source);
+	cmsg->rule = intern(rule);
+	cmsg->tags = intern(std::set<std::string>());
+	for(auto const &pair : output_fields.items()) {
+		cmsg->fields.emplace_back(pair.key(),
+		                          pair.value().is_string() ? pair.value().get<std::string>()
+		                                                   : pair.value().dump());
+	}
+
+	try {
+		format_msg(*cmsg, ts, priority, msg, rule, output_fields);
+	} catch(...) {
+		release_msg(cmsg);
+		throw;
+	}
 
+	cmsg->type = ctrl_msg_type::CTRL_MSG_OUTPUT;
+	this->push(cmsg);
+}
+
+void falco_outputs::format_msg(ctrl_msg &cmsg,
+                               uint64_t ts,
+                               falco_common::priority_type priority,
+                               const std::string &msg,
+                               const std::string &rule,
+                               nlohmann::json &output_fields) {
 	if(m_json_output) {
 		nlohmann::json jmsg;
 
@@ -221,9 +446,6 @@ void falco_outputs::handle_msg(uint64_t ts,
 		}
 		cmsg.msg += ")";
 	}
-
-	cmsg.type = ctrl_msg_type::CTRL_MSG_OUTPUT;
-	this->push(cmsg);
 }
 
 void falco_outputs::cleanup_outputs() {
@@ -241,40 +463,204 @@ void falco_outputs::stop_worker() {
 		        falco_logger::level::NOTICE,
 		        "output channels still blocked, discarding all remaining notifications\n");
 #ifndef __EMSCRIPTEN__
-		m_queue.clear();
+		discard_queued_msgs();
 #endif
 		this->push_ctrl(falco_outputs::ctrl_msg_type::CTRL_MSG_STOP);
 	});
 	wd.set_timeout(m_timeout, nullptr);
 
+	close_alert_windows(std::numeric_limits<uint64_t>::max());
 	this->push_ctrl(falco_outputs::ctrl_msg_type::CTRL_MSG_STOP);
 	if(m_worker_thread.joinable()) {
 		m_worker_thread.join();
 	}
+#ifndef __EMSCRIPTEN__
+	for(const auto &channel : m_channels) {
+		if(channel->worker_thread.joinable()) {
+			channel->worker_thread.join();
+		}
+	}
+
+	// The stop message pushed by the watchdog is left in the queues of
+	// the workers that were already stopped
+	wd.stop();
+	discard_queued_msgs();
+#endif
 }
 
 inline void falco_outputs::push_ctrl(ctrl_msg_type cmt) {
-	falco_outputs::ctrl_msg cmsg = {};
-	cmsg.type = cmt;
+	auto cmsg = acquire_msg();
+	cmsg->type = cmt;
 	this->push(cmsg);
 }
 
-inline void falco_outputs::push(const ctrl_msg &cmsg) {
+inline void falco_outputs::push(ctrl_msg *cmsg) {
 #ifndef __EMSCRIPTEN__
-	if(!m_queue.try_push(cmsg)) {
+	if(m_per_output_queues) {
+		bool dropped = false;
+		// The last worker to process the message recycles it
+		cmsg->num_pending = m_channels.size() + 1;
+		for(const auto &channel : m_channels) {
+			if(!enqueue(channel.get(), cmsg)) {
+				if(channel->num_drops.load() == 0) {
+					falco_logger::log(falco_logger::level::ERR,
+					                  "Outputs queue of " + channel->output->get_name() +
+					                          " out of memory. Drop event and continue on ...");
+				}
+				channel->num_drops++;
+				cmsg->num_pending--;
+				dropped = true;
+			}
+		}
+		if(dropped) {
+			count_drop(cmsg);
+		}
+		if(--cmsg->num_pending == 0) {
+			release_msg(cmsg);
+		}
+	} else if(!try_push(m_queue, cmsg)) {
 		if(m_outputs_queue_num_drops.load() == 0) {
 			falco_logger::log(falco_logger::level::ERR,
 			                  "Outputs queue out of memory. Drop event and continue on ...");
 		}
-		m_outputs_queue_num_drops++;
+		count_drop(cmsg);
+		release_msg(cmsg);
 	}
 #else
 	for(const auto &o : m_outputs) {
-		process_msg(o.get(), cmsg);
+		process_msg(o.get(), *cmsg);
 	}
+	release_msg(cmsg);
 #endif
 }
 
+#ifndef __EMSCRIPTEN__
+bool falco_outputs::enqueue(output_channel *channel, ctrl_msg *cmsg) {
+#ifndef _WIN32
+	if(channel->spool) {
+		// Control messages are never spooled, and can overtake the spooled
+		// alerts. In particular, the alerts still spooled on shutdown are
+		// replayed after the next start.
+		std::unique_lock<std::mutex> lock(channel->spool_mtx);
+		if((channel->spool->empty() || cmsg->type != ctrl_msg_type::CTRL_MSG_OUTPUT) &&
+		   try_push(channel->queue, cmsg)) {
+			return true;
+		}
+		if(cmsg->type != ctrl_msg_type::CTRL_MSG_OUTPUT) {
+			return false;
+		}
+		try {
+			encode_msg(*cmsg, channel->spool_record);
+			if(!channel->spool->push(channel->spool_record)) {
+				return false;
+			}
+		} catch(const std::exception &) {
+			// Counted as a drop by the caller
+			return false;
+		}
+		// The channel reads the spooled copy instead
+		cmsg->num_pending--;
+		return true;
+	}
+#endif
+	return try_push(channel->queue, cmsg);
+}
+
+bool falco_outputs::try_push(falco_outputs_cbq &queue, ctrl_msg *cmsg) {
+	// The stop message must reach every worker, even when its queue is
+	// full, otherwise the worker would never terminate
+	if(cmsg->type == ctrl_msg_type::CTRL_MSG_STOP) {
+		queue.push(cmsg, queue_lane(cmsg));
+		return true;
+	}
+	return queue.try_push(cmsg, queue_lane(cmsg));
+}
+
+size_t falco_outputs::queue_lane(const ctrl_msg *cmsg) {
+	if(cmsg->type != ctrl_msg_type::CTRL_MSG_OUTPUT) {
+		return 0;
+	}
+	return 1 + std::min<size_t>(cmsg->priority, falco_common::PRIORITY_DEBUG);
+}
+#endif
+
+void falco_outputs::count_drop(const ctrl_msg *cmsg) {
+	m_outputs_queue_num_drops++;
+	if(cmsg->type != ctrl_msg_type::CTRL_MSG_OUTPUT) {
+		return;
+	}
+	m_outputs_queue_num_drops_by_priority[std::min<size_t>(cmsg->priority,
+	                                                       falco_common::PRIORITY_DEBUG)]++;
+	std::unique_lock<std::mutex> lock(m_outputs_queue_num_drops_by_rule_mtx);
+	m_outputs_queue_num_drops_by_rule[cmsg->rule]++;
+}
+
+falco_outputs::ctrl_msg *falco_outputs::acquire_msg() {
+#ifndef __EMSCRIPTEN__
+	ctrl_msg *cmsg;
+	if(m_msg_pool.try_pop(cmsg)) {
+		m_num_pooled_msgs--;
+		return cmsg;
+	}
+#endif
+	return new ctrl_msg();
+}
+
+void falco_outputs::release_msg(ctrl_msg *cmsg) {
+#ifndef __EMSCRIPTEN__
+	// The pool is bounded, so that the memory of an alert storm is
+	// eventually given back
+	if(m_num_pooled_msgs.load() < s_max_pooled_msgs) {
+		cmsg->msg.clear();
+		cmsg->fields.clear();
+		m_num_pooled_msgs++;
+		m_msg_pool.push(cmsg);
+		return;
+	}
+#endif
+	delete cmsg;
+}
+
+#ifndef __EMSCRIPTEN__
+void falco_outputs::discard_queued_msgs() {
+	ctrl_msg *cmsg;
+	while(m_queue.try_pop(cmsg)) {
+		release_msg(cmsg);
+	}
+	for(const auto &channel : m_channels) {
+		while(channel->queue.try_pop(cmsg)) {
+			if(--cmsg->num_pending == 0) {
+				release_msg(cmsg);
+			}
+		}
+	}
+}
+#endif
+
+const std::string *falco_outputs::intern(const std::string &s) {
+	{
+		std::shared_lock<std::shared_mutex> lock(m_interned_mtx);
+		auto it = m_interned_strings.find(s);
+		if(it != m_interned_strings.end()) {
+			return &*it;
+		}
+	}
+	std::unique_lock<std::shared_mutex> lock(m_interned_mtx);
+	return &*m_interned_strings.insert(s).first;
+}
+
+const std::set<std::string> *falco_outputs::intern(const std::set<std::string> &tags) {
+	{
+		std::shared_lock<std::shared_mutex> lock(m_interned_mtx);
+		auto it = m_interned_tags.find(tags);
+		if(it != m_interned_tags.end()) {
+			return &*it;
+		}
+	}
+	std::unique_lock<std::shared_mutex> lock(m_interned_mtx);
+	return &*m_interned_tags.insert(tags).first;
+}
+
 // todo(leogr,leodido): this function is not supposed to throw exceptions, and with "noexcept",
 // the program is terminated if that occurs. Although that's the wanted behavior,
 // we still need to improve the error reporting since some inner functions can throw exceptions.
@@ -287,26 +673,147 @@ void falco_outputs::worker() noexcept {
 
 	auto timeout = m_timeout;
 
-	falco_outputs::ctrl_msg cmsg;
-	do {
-		// Block until a message becomes available.
+	falco_outputs::ctrl_msg *stop_msg = nullptr;
+	while(true) {
+		falco_outputs::ctrl_msg *cmsg = nullptr;
 #ifndef __EMSCRIPTEN__
-		m_queue.pop(cmsg);
+		if(stop_msg == nullptr) {
+			// Block until a message becomes available.
+			m_queue.pop(cmsg);
+		} else if(!m_queue.try_pop(cmsg)) {
+			cmsg = stop_msg;
+		}
+
+		// The stop message can overtake the alerts of lower priority, and
+		// is held back until they are delivered
+		if(cmsg->type == ctrl_msg_type::CTRL_MSG_STOP && cmsg != stop_msg) {
+			if(stop_msg != nullptr) {
+				release_msg(stop_msg);
+			}
+			stop_msg = cmsg;
+			continue;
+		}
 #endif
 
 		for(const auto &o : m_outputs) {
 			wd.set_timeout(timeout, o->get_name());
 			try {
-				process_msg(o.get(), cmsg);
+				process_msg(o.get(), *cmsg);
 			} catch(const std::exception &e) {
 				falco_logger::log(falco_logger::level::ERR,
 				                  o->get_name() + ": " + std::string(e.what()) + "\n");
 			}
 		}
 		wd.cancel_timeout();
-	} while(cmsg.type != ctrl_msg_type::CTRL_MSG_STOP);
+
+		auto type = cmsg->type;
+		release_msg(cmsg);
+		if(type == ctrl_msg_type::CTRL_MSG_STOP) {
+			break;
+		}
+	}
+}
+
+#ifndef __EMSCRIPTEN__
+// Same as worker(), for the queue of a single output
+void falco_outputs::channel_worker(output_channel *channel) noexcept {
+	watchdog<std::string> wd;
+	wd.start([&](const std::string &payload) -> void {
+		falco_logger::log(falco_logger::level::CRIT,
+		                  "\"" + payload + "\" output timeout, the output channel is blocked\n");
+	});
+
+	auto o = channel->output;
+	falco_outputs::ctrl_msg *stop_msg = nullptr;
+#ifndef _WIN32
+	std::string record;
+#endif
+	while(true) {
+		falco_outputs::ctrl_msg *cmsg = nullptr;
+		if(stop_msg != nullptr) {
+			// The spooled alerts are left for the next start
+			if(!channel->queue.try_pop(cmsg)) {
+				cmsg = stop_msg;
+			}
+		} else {
+#ifndef _WIN32
+			// The queued messages are older than the spooled ones
+			if(channel->spool && !channel->queue.try_pop(cmsg)) {
+				cmsg = unspool(channel, record);
+			}
+#endif
+			// Block until a message becomes available.
+			if(cmsg == nullptr) {
+				channel->queue.pop(cmsg);
+			}
+		}
+
+		if(cmsg->type == ctrl_msg_type::CTRL_MSG_STOP && cmsg != stop_msg) {
+			if(stop_msg != nullptr && --stop_msg->num_pending == 0) {
+				release_msg(stop_msg);
+			}
+			stop_msg = cmsg;
+			continue;
+		}
+
+		wd.set_timeout(m_timeout, o->get_name());
+		try {
+			process_msg(o, *cmsg);
+		} catch(const std::exception &e) {
+			falco_logger::log(falco_logger::level::ERR,
+			                  o->get_name() + ": " + std::string(e.what()) + "\n");
+		}
+		wd.cancel_timeout();
+
+		auto type = cmsg->type;
+		if(--cmsg->num_pending == 0) {
+			release_msg(cmsg);
+		}
+		if(type == ctrl_msg_type::CTRL_MSG_STOP) {
+			break;
+		}
+	}
 }
 
+#ifndef _WIN32
+falco_outputs::ctrl_msg *falco_outputs::unspool(output_channel *channel, std::string &record) {
+	while(true) {
+		bool popped;
+		{
+			// If the spool is empty, the next messages are queued, since
+			// deciding so happens under the same lock
+			std::unique_lock<std::mutex> lock(channel->spool_mtx);
+			popped = channel->spool->pop(record);
+		}
+
+		// The disk writes don't hold back the event thread
+		channel->spool->sync();
+		if(!popped) {
+			return nullptr;
+		}
+
+		auto cmsg = acquire_msg();
+		std::string rule, source;
+		std::set<std::string> tags;
+		if(decode_msg(record, *cmsg, rule, source, tags)) {
+			cmsg->rule = intern(rule);
+			cmsg->source = intern(source);
+			cmsg->tags = intern(tags);
+			cmsg->type = ctrl_msg_type::CTRL_MSG_OUTPUT;
+			cmsg->num_pending = 1;
+			return cmsg;
+		}
+
+		falco_logger::log(falco_logger::level::ERR,
+		                  "Skipping corrupted spooled alert for output " +
+		                          channel->output->get_name() + "\n");
+		channel->num_drops++;
+		release_msg(cmsg);
+	}
+}
+#endif
+#endif
+
 inline void falco_outputs::process_msg(falco::outputs::abstract_output *o, const ctrl_msg &cmsg) {
 	switch(cmsg.type) {
 	case ctrl_msg_type::CTRL_MSG_OUTPUT:
@@ -328,3 +835,64 @@ inline void falco_outputs::process_msg(falco::outputs::abstract_output *o, const
 uint64_t falco_outputs::get_outputs_queue_num_drops() {
 	return m_outputs_queue_num_drops.load();
 }
+
+std::vector<std::pair<std::string, uint64_t>>
+falco_outputs::get_outputs_queue_num_drops_by_priority() {
+	std::vector<std::pair<std::string, uint64_t>> res;
+	for(int p = falco_common::PRIORITY_EMERGENCY; p <= falco_common::PRIORITY_DEBUG; p++) {
+		res.emplace_back(falco_common::format_priority((falco_common::priority_type)p),
+		                 m_outputs_queue_num_drops_by_priority[p].load());
+	}
+	return res;
+}
+
+std::vector<std::pair<std::string, uint64_t>> falco_outputs::get_outputs_queue_num_drops_by_rule() {
+	std::vector<std::pair<std::string, uint64_t>> res;
+	std::unique_lock<std::mutex> lock(m_outputs_queue_num_drops_by_rule_mtx);
+	for(const auto &[rule, num_drops] : m_outputs_queue_num_drops_by_rule) {
+		res.emplace_back(*rule, num_drops);
+	}
+	return res;
+}
+
+uint64_t falco_outputs::get_num_rate_limited_alerts() {
+	return m_throttler ? m_throttler->get_num_rate_limited() : 0;
+}
+
+uint64_t falco_outputs::get_num_deduplicated_alerts() {
+	return m_throttler ? m_throttler->get_num_deduplicated() : 0;
+}
+
+std::vector<std::pair<std::string, uint64_t>> falco_outputs::get_outputs_num_drops() {
+	std::vector<std::pair<std::string, uint64_t>> res;
+#ifndef __EMSCRIPTEN__
+	for(const auto &channel : m_channels) {
+		res.emplace_back(channel->output->get_name(), channel->num_drops.load());
+	}
+#endif
+	return res;
+}
+
+std::vector<std::pair<std::string, falco::outputs::spool::stats>>
+falco_outputs::get_outputs_spool_stats() {
+	std::vector<std::pair<std::string, falco::outputs::spool::stats>> res;
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+	for(const auto &channel : m_channels) {
+		if(channel->spool) {
+			std::unique_lock<std::mutex> lock(channel->spool_mtx);
+			res.emplace_back(channel->output->get_name(), channel->spool->get_stats());
+		}
+	}
+#endif
+	return res;
+}
+
+std::vector<std::pair<std::string, uint64_t>> falco_outputs::get_outputs_metrics() {
+	std::vector<std::pair<std::string, uint64_t>> res;
+	for(const auto &o : m_outputs) {
+		for(const auto &[name, value] : o->get_metrics()) {
+			res.emplace_back(o->get_name() + "_" + name, value);
+		}
+	}
+	return res;
+}
@@ -17,16 +17,25 @@ limitations under the License.
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <map>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
+#include "alert_throttler.h"
 #include "falco_common.h"
 #include "falco_engine.h"
 #include "outputs.h"
+#include "outputs_spool.h"
 #include "formats.h"
 #ifndef __EMSCRIPTEN__
 #include "tbb/concurrent_queue.h"
+#include "outputs_queue.h"
 #endif
 
 /*!
@@ -50,6 +59,10 @@ public:
 	              uint32_t timeout,
 	              bool buffered,
 	              size_t outputs_queue_capacity,
+	              double outputs_queue_shed_threshold,
+	              bool per_output_queues,
+	              const falco::outputs::spool_config &spool_config,
+	              const alert_throttler::config &alert_throttling,
 	              bool time_format_iso_8601,
 	              const std::string &hostname);
 
@@ -64,8 +77,8 @@ public:
 	                  const std::string &source,
 	                  falco_common::priority_type priority,
 	                  const std::string &format,
-	                  std::set<std::string> &tags,
-	                  extra_output_field_t &extra_fields);
+	                  const std::set<std::string> &tags,
+	                  const extra_output_field_t &extra_fields);
 
 	/*!
 	    \brief Format then send a generic message to all outputs.
@@ -77,6 +90,13 @@ public:
 	                const std::string &rule,
 	                nlohmann::json &output_fields);
 
+	/*!
+	    \brief Sends the summaries of the alerts suppressed by throttling
+	    in the windows that are over at the given time. Cheap to call when
+	    no window is over.
+	*/
+	void close_alert_windows(uint64_t now);
+
 	/*!
 	    \brief Sends a cleanup message to all outputs.
 	    Each output can have an implementation-specific behavior.
@@ -96,12 +116,65 @@ public:
 	*/
 	uint64_t get_outputs_queue_num_drops();
 
+	/*!
+	    \brief Return the number of events dropped due to failed push
+	    attempts into the outputs queues, for each priority
+	*/
+	std::vector<std::pair<std::string, uint64_t>> get_outputs_queue_num_drops_by_priority();
+
+	/*!
+	    \brief Return the number of events dropped due to failed push
+	    attempts into the outputs queues, for each rule that had some
+	*/
+	std::vector<std::pair<std::string, uint64_t>> get_outputs_queue_num_drops_by_rule();
+
+	/*!
+	    \brief Return the number of alerts suppressed by rate limiting
+	*/
+	uint64_t get_num_rate_limited_alerts();
+
+	/*!
+	    \brief Return the number of alerts suppressed by deduplication
+	*/
+	uint64_t get_num_deduplicated_alerts();
+
+	/*!
+	    \brief Return the number of events dropped by each output due to
+	    failed push attempts into its own queue, when each output has its
+	    own queue
+	*/
+	std::vector<std::pair<std::string, uint64_t>> get_outputs_num_drops();
+
+	/*!
+	    \brief Return the counters of the outputs that have their own,
+	    each prefixed by the name of the output
+	*/
+	std::vector<std::pair<std::string, uint64_t>> get_outputs_metrics();
+
+	/*!
+	    \brief Return the state of the disk spool of each output that has one
+	*/
+	std::vector<std::pair<std::string, falco::outputs::spool::stats>> get_outputs_spool_stats();
+
 private:
+	std::shared_ptr<falco_engine> m_engine;
 	std::unique_ptr<falco_formats> m_formats;
+	std::unique_ptr<alert_throttler> m_throttler;
+
+	// The values of the deduplication key fields are extracted with a
+	// formatter for each source, or none if the source lacks the fields
+	std::string m_dedup_key_format;
+	std::shared_mutex m_dedup_formatters_mtx;
+	std::unordered_map<std::string, std::shared_ptr<sinsp_evt_formatter>> m_dedup_formatters;
+	void get_dedup_key_fields(sinsp_evt *evt,
+	                          const std::string &source,
+	                          std::map<std::string, std::string> &key_fields);
 
 	std::vector<std::unique_ptr<falco::outputs::abstract_output>> m_outputs;
 
 	bool m_buffered;
+	bool m_per_output_queues;
+	bool m_outputs_use_fields;
 	bool m_json_output;
 	bool m_time_format_iso_8601;
 	std::chrono::milliseconds m_timeout;
@@ -116,16 +189,79 @@ private:
 
 	struct ctrl_msg : falco::outputs::message {
 		ctrl_msg_type type;
+		// Number of workers that still have to process the message
+		// before it can be recycled
+		std::atomic<size_t> num_pending = 0;
 	};
 
+	// The messages are passed by pointer through the queues, and are
+	// recycled once processed, so that their buffers are reused and
+	// alerts don't need to allocate them again.
+	static constexpr size_t s_max_pooled_msgs = 1024;
+	ctrl_msg *acquire_msg();
+	void release_msg(ctrl_msg *cmsg);
+
+	// Rule names, sources and tags repeat across messages, which point
+	// to their interned values instead of copying them.
+	std::shared_mutex m_interned_mtx;
+	std::unordered_set<std::string> m_interned_strings;
+	std::set<std::set<std::string>> m_interned_tags;
+	const std::string *intern(const std::string &s);
+	const std::set<std::string> *intern(const std::set<std::string> &tags);
+
 #ifndef __EMSCRIPTEN__
-	typedef tbb::concurrent_bounded_queue<ctrl_msg> falco_outputs_cbq;
-	falco_outputs_cbq m_queue;
+	// The queues have a lane for the control messages, followed by one
+	// lane per priority, so that the alerts of higher priority are
+	// delivered first and shed last
+	static constexpr size_t s_num_queue_lanes = falco_common::PRIORITY_DEBUG + 2;
+	static size_t queue_lane(const ctrl_msg *cmsg);
+	typedef falco::outputs::prioritized_queue<ctrl_msg *> falco_outputs_cbq;
+	static bool try_push(falco_outputs_cbq &queue, ctrl_msg *cmsg);
+	falco_outputs_cbq m_queue{s_num_queue_lanes};
+	tbb::concurrent_queue<ctrl_msg *> m_msg_pool;
+	std::atomic<size_t> m_num_pooled_msgs = 0;
+
+	// With per-output queues, each output is served by its own worker
+	// thread, so that a slow output does not delay the other ones. A
+	// message is formatted once and shared by all the queues.
+	struct output_channel {
+		falco::outputs::abstract_output *output;
+		falco_outputs_cbq queue{s_num_queue_lanes};
+		std::atomic<uint64_t> num_drops = 0;
+		std::thread worker_thread;
+#ifndef _WIN32
+		// When the queue is full, the messages are appended to the spool
+		// instead, and so are the following ones until it is drained, to
+		// keep them in order. Guarded by spool_mtx, also held while
+		// deciding whether a message goes to the queue or to the spool.
+		std::unique_ptr<falco::outputs::spool> spool;
+		std::mutex spool_mtx;
+		std::string spool_record;
+#endif
+	};
+	std::vector<std::unique_ptr<output_channel>> m_channels;
+	void channel_worker(output_channel *channel) noexcept;
+	bool enqueue(output_channel *channel, ctrl_msg *cmsg);
+#ifndef _WIN32
+	ctrl_msg *unspool(output_channel *channel, std::string &record);
+#endif
+	void discard_queued_msgs();
 #endif
 
 	std::atomic<uint64_t> m_outputs_queue_num_drops = 0;
+	std::atomic<uint64_t> m_outputs_queue_num_drops_by_priority[falco_common::PRIORITY_DEBUG + 1] =
+	        {};
+	std::mutex m_outputs_queue_num_drops_by_rule_mtx;
+	std::unordered_map<const std::string *, uint64_t> m_outputs_queue_num_drops_by_rule;
+	void count_drop(const ctrl_msg *cmsg);
 	std::thread m_worker_thread;
-	inline void push(const ctrl_msg &cmsg);
+	inline void push(ctrl_msg *cmsg);
+	void format_msg(ctrl_msg &cmsg,
+	                uint64_t ts,
+	                falco_common::priority_type priority,
+	                const std::string &msg,
+	                const std::string &rule,
+	                nlohmann::json &output_fields);
 	inline void push_ctrl(ctrl_msg_type cmt);
 	void worker() noexcept;
 	void stop_worker();
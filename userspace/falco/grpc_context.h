@@ -17,7 +17,12 @@ limitations under the License.
 
 #pragma once
 
+#include <chrono>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include "grpc_queue.h"
 
 #ifdef GRPC_INCLUDE_IS_GRPCPP
 #include <grpcpp/grpcpp.h>
@@ -53,6 +58,20 @@ public:
 	mutable void* m_stream = nullptr;  // todo(fntlnz, leodido) > useful in the future
 	mutable bool m_has_more = false;
 	mutable bool m_is_running = true;
+
+	// The response to write next, when m_has_more is true
+	mutable response_ptr m_response;
+	// The responses to write next in a single batch, when m_has_more is true
+	mutable std::vector<response_ptr> m_responses;
+	// When a batch is written even if it is not full
+	mutable std::chrono::system_clock::time_point m_flush_deadline =
+	        std::chrono::system_clock::time_point::max();
+	// The responses fanned out to this stream, when it subscribed to them
+	mutable std::shared_ptr<subscription> m_subscription;
+	// The filters of the request, compiled on the first call
+	mutable std::unique_ptr<response_filter> m_filter;
+	// The status the stream is finished with
+	mutable ::grpc::Status m_finish_status = ::grpc::Status::OK;
 };
 
 class bidi_context : public stream_context {
@@ -17,13 +17,258 @@ limitations under the License.
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
 #include "outputs.pb.h"
-#include "tbb/concurrent_queue.h"
+#include "falco_utils.h"
 
 namespace falco {
 namespace grpc {
-typedef tbb::concurrent_queue<outputs::response> response_cq;
 
+// The responses are immutable once pushed, and shared by all the
+// subscriptions they are delivered to
+typedef std::shared_ptr<const outputs::response> response_ptr;
+
+enum class slow_subscriber_policy { DROP_OLDEST, DISCONNECT };
+
+/*!
+    \brief The filters of a request, compiled to be evaluated on each of the
+    responses before they are delivered to its stream.
+*/
+class response_filter {
+public:
+	response_filter() = default;
+
+	explicit response_filter(const outputs::request& req):
+	        m_tags(req.tags().begin(), req.tags().end()),
+	        m_sources(req.sources().begin(), req.sources().end()) {
+		if(req.has_min_priority()) {
+			m_has_min_priority = true;
+			m_min_priority = req.min_priority();
+		}
+		for(const auto& rule : req.rules()) {
+			if(rule.find('*') == std::string::npos) {
+				m_rules.insert(rule);
+			} else {
+				m_rule_patterns.push_back(rule);
+			}
+		}
+	}
+
+	bool matches(const outputs::response& res) const {
+		// The priorities are sorted from the most severe one
+		if(m_has_min_priority && res.priority() > m_min_priority) {
+			return false;
+		}
+		if(!m_sources.empty() && m_sources.find(res.source()) == m_sources.end()) {
+			return false;
+		}
+		if((!m_rules.empty() || !m_rule_patterns.empty()) && !matches_rule(res.rule())) {
+			return false;
+		}
+		if(!m_tags.empty()) {
+			return std::any_of(res.tags().begin(), res.tags().end(), [this](const auto& tag) {
+				return m_tags.find(tag) != m_tags.end();
+			});
+		}
+		return true;
+	}
+
+private:
+	bool matches_rule(const std::string& rule) const {
+		if(m_rules.find(rule) != m_rules.end()) {
+			return true;
+		}
+		return std::any_of(m_rule_patterns.begin(),
+		                   m_rule_patterns.end(),
+		                   [&rule](const std::string& pattern) {
+			                   return falco::utils::matches_wildcard(pattern, rule);
+		                   });
+	}
+
+	bool m_has_min_priority = false;
+	schema::priority m_min_priority = schema::DEBUG;
+	std::unordered_set<std::string> m_tags;
+	std::unordered_set<std::string> m_sources;
+	std::unordered_set<std::string> m_rules;
+	std::vector<std::string> m_rule_patterns;
+};
+
+/*!
+    \brief The responses waiting to be delivered to a single consumer, in a
+    bounded ring. Only the responses matching its filter are kept.
+*/
+class subscription {
+public:
+	explicit subscription(size_t capacity, response_filter filter = {}):
+	        m_filter(std::move(filter)),
+	        m_ring(std::max<size_t>(capacity, 1)) {}
+
+	/*!
+	    \brief Pushes a response. When the ring is full, either the oldest
+	    response is dropped, or the subscription is marked as overflowed and
+	    emptied, so that its consumer gets disconnected.
+	*/
+	void push(const response_ptr& res, slow_subscriber_policy policy) {
+		if(!m_filter.matches(*res)) {
+			return;
+		}
+		std::unique_lock<std::mutex> lock(m_mtx);
+		if(m_overflowed) {
+			m_num_drops++;
+			return;
+		}
+		if(m_size == m_ring.size()) {
+			m_num_drops++;
+			if(policy == slow_subscriber_policy::DISCONNECT) {
+				m_overflowed = true;
+				m_num_drops += m_size;
+				std::fill(m_ring.begin(), m_ring.end(), nullptr);
+				m_size = 0;
+				if(m_wakeup) {
+					wake();
+				}
+				return;
+			}
+			m_ring[m_head] = nullptr;
+			m_head = (m_head + 1) % m_ring.size();
+			m_size--;
+		}
+		m_ring[(m_head + m_size) % m_ring.size()] = res;
+		m_size++;
+		if(m_wakeup && m_size >= m_wakeup_size) {
+			wake();
+		}
+	}
+
+	bool try_pop(response_ptr& res) {
+		std::unique_lock<std::mutex> lock(m_mtx);
+		if(m_size == 0) {
+			return false;
+		}
+		res = std::move(m_ring[m_head]);
+		m_head = (m_head + 1) % m_ring.size();
+		m_size--;
+		return true;
+	}
+
+	/*!
+	    \brief Pops up to max responses, in the order they were pushed, and
+	    returns how many were popped.
+	*/
+	size_t try_pop(std::vector<response_ptr>& res, size_t max) {
+		std::unique_lock<std::mutex> lock(m_mtx);
+		size_t n = std::min(max, m_size);
+		for(size_t i = 0; i < n; i++) {
+			res.push_back(std::move(m_ring[m_head]));
+			m_head = (m_head + 1) % m_ring.size();
+		}
+		m_size -= n;
+		return n;
+	}
+
+	/*!
+	    \brief Pops the oldest response matching the given filter, and
+	    leaves the other ones in place.
+	*/
+	bool try_pop(response_ptr& res, const response_filter& filter) {
+		std::unique_lock<std::mutex> lock(m_mtx);
+		for(size_t i = 0; i < m_size; i++) {
+			auto& slot = m_ring[(m_head + i) % m_ring.size()];
+			if(!filter.matches(*slot)) {
+				continue;
+			}
+			res = std::move(slot);
+			// Fill the gap with the responses before it
+			for(size_t j = i; j > 0; j--) {
+				m_ring[(m_head + j) % m_ring.size()] =
+				        std::move(m_ring[(m_head + j - 1) % m_ring.size()]);
+			}
+			m_head = (m_head + 1) % m_ring.size();
+			m_size--;
+			return true;
+		}
+		return false;
+	}
+
+	size_t size() {
+		std::unique_lock<std::mutex> lock(m_mtx);
+		return m_size;
+	}
+
+	/*!
+	    \brief Calls wakeup, once, as soon as at least min_size responses
+	    are pending or the subscription overflowed. It may be called right
+	    away, and it is called with the subscription locked.
+	*/
+	void wait(size_t min_size, std::function<void()> wakeup) {
+		std::unique_lock<std::mutex> lock(m_mtx);
+		m_wakeup = std::move(wakeup);
+		m_wakeup_size = std::max<size_t>(min_size, 1);
+		if(m_size >= m_wakeup_size || m_overflowed || m_interrupted) {
+			wake();
+		}
+	}
+
+	/*!
+	    \brief Calls the pending wakeup right away, if any, and the ones of
+	    all the following waits.
+	*/
+	void interrupt() {
+		std::unique_lock<std::mutex> lock(m_mtx);
+		m_interrupted = true;
+		if(m_wakeup) {
+			wake();
+		}
+	}
+
+	/*!
+	    \brief Cancels the pending wait, if any. Once this returns, its wakeup
+	    won't be called.
+	*/
+	void stop_waiting() {
+		std::unique_lock<std::mutex> lock(m_mtx);
+		m_wakeup = nullptr;
+	}
+
+	bool overflowed() const { return m_overflowed.load(); }
+
+	uint64_t get_num_drops() const { return m_num_drops.load(); }
+
+private:
+	void wake() {
+		auto wakeup = std::move(m_wakeup);
+		m_wakeup = nullptr;
+		wakeup();
+	}
+
+	const response_filter m_filter;
+	std::mutex m_mtx;
+	std::vector<response_ptr> m_ring;
+	size_t m_head = 0;
+	size_t m_size = 0;
+	std::function<void()> m_wakeup;
+	size_t m_wakeup_size = 1;
+	bool m_interrupted = false;
+	std::atomic<bool> m_overflowed = false;
+	std::atomic<uint64_t> m_num_drops = 0;
+};
+
+/*!
+    \brief Fans out the responses to each of the subscriptions of the
+    gRPC streams, so that every subscriber receives all of them.
+
+    The responses are also kept in a bounded backlog, which is consumed by
+    the streams that get the responses queued so far without subscribing.
+*/
 class queue {
 public:
 	static queue& get() {
@@ -31,14 +276,109 @@ public:
 		return instance;
 	}
 
-	bool try_pop(outputs::response& res) { return m_queue.try_pop(res); }
+	void configure(size_t capacity, slow_subscriber_policy policy) {
+		std::unique_lock<std::shared_mutex> lock(m_mtx);
+		m_capacity = capacity;
+		m_policy = policy;
+		m_backlog = std::make_shared<subscription>(capacity);
+	}
+
+	std::shared_ptr<subscription> subscribe(response_filter filter = {}) {
+		std::unique_lock<std::shared_mutex> lock(m_mtx);
+		auto sub = std::make_shared<subscription>(m_capacity, std::move(filter));
+		if(m_interrupted) {
+			sub->interrupt();
+		}
+		m_subscriptions.push_back(sub);
+		return sub;
+	}
 
-	void push(outputs::response& res) { m_queue.push(res); }
+	/*!
+	    \brief Interrupts the waits of all the subscriptions, including the
+	    ones subscribing afterwards, until resume() is called. This lets
+	    the streams notice right away that the server is shutting down.
+	*/
+	void interrupt() {
+		std::unique_lock<std::shared_mutex> lock(m_mtx);
+		m_interrupted = true;
+		for(const auto& sub : m_subscriptions) {
+			sub->interrupt();
+		}
+	}
+
+	void resume() {
+		std::unique_lock<std::shared_mutex> lock(m_mtx);
+		m_interrupted = false;
+	}
+
+	void unsubscribe(const std::shared_ptr<subscription>& sub) {
+		std::unique_lock<std::shared_mutex> lock(m_mtx);
+		auto it = std::find(m_subscriptions.begin(), m_subscriptions.end(), sub);
+		if(it != m_subscriptions.end()) {
+			m_subscriptions.erase(it);
+			m_num_drops += sub->get_num_drops();
+			m_num_disconnects += sub->overflowed() ? 1 : 0;
+		}
+	}
+
+	/*!
+	    \brief Pops the oldest response of the backlog matching the given
+	    filter. The ones not matching it are left to the other streams.
+	*/
+	bool try_pop(response_ptr& res, const response_filter& filter) {
+		std::shared_lock<std::shared_mutex> lock(m_mtx);
+		return m_backlog->try_pop(res, filter);
+	}
+
+	void push(outputs::response&& res) {
+		auto shared = std::make_shared<const outputs::response>(std::move(res));
+		std::shared_lock<std::shared_mutex> lock(m_mtx);
+		m_backlog->push(shared, slow_subscriber_policy::DROP_OLDEST);
+		for(const auto& sub : m_subscriptions) {
+			sub->push(shared, m_policy);
+		}
+	}
+
+	/*!
+	    \brief Return the number of responses dropped for slow subscribers,
+	    including the ones that are gone.
+	*/
+	uint64_t get_num_drops() {
+		std::shared_lock<std::shared_mutex> lock(m_mtx);
+		uint64_t res = m_num_drops;
+		for(const auto& sub : m_subscriptions) {
+			res += sub->get_num_drops();
+		}
+		return res;
+	}
+
+	uint64_t get_num_disconnects() {
+		std::shared_lock<std::shared_mutex> lock(m_mtx);
+		uint64_t res = m_num_disconnects;
+		for(const auto& sub : m_subscriptions) {
+			res += sub->overflowed() ? 1 : 0;
+		}
+		return res;
+	}
+
+	uint64_t get_num_backlog_drops() {
+		std::shared_lock<std::shared_mutex> lock(m_mtx);
+		return m_backlog->get_num_drops();
+	}
 
 private:
-	queue() {}
+	static constexpr size_t s_default_capacity = 10000;
+
+	queue(): m_backlog(std::make_shared<subscription>(s_default_capacity)) {}
 
-	response_cq m_queue;
+	std::shared_mutex m_mtx;
+	size_t m_capacity = s_default_capacity;
+	slow_subscriber_policy m_policy = slow_subscriber_policy::DROP_OLDEST;
+	std::shared_ptr<subscription> m_backlog;
+	std::vector<std::shared_ptr<subscription>> m_subscriptions;
+	bool m_interrupted = false;
+	uint64_t m_num_drops = 0;
+	uint64_t m_num_disconnects = 0;
 
 	// We can use the better technique of deleting the methods we don't want.
 public:
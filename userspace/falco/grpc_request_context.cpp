@@ -31,7 +31,7 @@ void request_stream_context<outputs::service, outputs::request, outputs::respons
 	m_res_writer = std::make_unique<::grpc::ServerAsyncWriter<outputs::response>>(srvctx);
 	m_stream_ctx.reset();
 	m_req.Clear();
-	auto cq = srv->m_completion_queue.get();
+	auto cq = m_completion_queue;
 	// todo(leodido) > log "calling m_request_func: tag=this, state=m_state"
 	(srv->m_output_svc.*m_request_func)(srvctx, &m_req, m_res_writer.get(), cq, cq, this);
 }
@@ -46,19 +46,18 @@ void request_stream_context<outputs::service, outputs::request, outputs::respons
 	}
 
 	// Processing
-	outputs::response res;
-	(srv->*m_process_func)(*m_stream_ctx, m_req, res);  // get()
+	(srv->*m_process_func)(*m_stream_ctx, m_req);  // get()
 
 	if(!m_stream_ctx->m_is_running) {
 		m_state = request_context_base::FINISH;
-		m_res_writer->Finish(::grpc::Status::OK, this);
+		m_res_writer->Finish(m_stream_ctx->m_finish_status, this);
 		return;
 	}
 
 	// When there are still more responses to stream
 	if(m_stream_ctx->m_has_more) {
 		// todo(leodido) > log "write: tag=this, state=m_state"
-		m_res_writer->Write(res, this);
+		m_res_writer->Write(*m_stream_ctx->m_response, this);
 		return;
 	}
 
@@ -82,8 +81,7 @@ void request_stream_context<outputs::service, outputs::request, outputs::respons
 		m_stream_ctx->m_status = error ? stream_context::ERROR : stream_context::SUCCESS;
 
 		// Complete the processing
-		outputs::response res;
-		(srv->*m_process_func)(*m_stream_ctx, m_req, res);  // get()
+		(srv->*m_process_func)(*m_stream_ctx, m_req);  // get()
 	} else {
 		// Flow enters here when the processing of "m_request_func" fails.
 		// Since this happens into the `start()` function, the processing does not advance to the
@@ -97,6 +95,69 @@ void request_stream_context<outputs::service, outputs::request, outputs::respons
 	start(srv);
 }
 
+template<>
+void request_stream_context<outputs::service, outputs::request, outputs::batch>::start(
+        server* srv) {
+	m_state = request_context_base::REQUEST;
+	m_srv_ctx = std::make_unique<::grpc::ServerContext>();
+	auto srvctx = m_srv_ctx.get();
+	m_res_writer = std::make_unique<::grpc::ServerAsyncWriter<outputs::batch>>(srvctx);
+	m_stream_ctx.reset();
+	m_req.Clear();
+	auto cq = m_completion_queue;
+	(srv->m_output_svc.*m_request_func)(srvctx, &m_req, m_res_writer.get(), cq, cq, this);
+}
+
+template<>
+void request_stream_context<outputs::service, outputs::request, outputs::batch>::process(
+        server* srv) {
+	// When it is the 1st process call
+	if(m_state == request_context_base::REQUEST) {
+		m_stream_ctx = std::make_unique<stream_context>(m_srv_ctx.get());
+	}
+	m_state = request_context_base::WRITE;
+
+	// Processing
+	(srv->*m_process_func)(*m_stream_ctx, m_req);  // sub_batch()
+
+	if(!m_stream_ctx->m_is_running) {
+		m_state = request_context_base::FINISH;
+		m_res_writer->Finish(m_stream_ctx->m_finish_status, this);
+		return;
+	}
+
+	if(m_stream_ctx->m_has_more) {
+		outputs::batch res;
+		res.mutable_outputs()->Reserve(m_stream_ctx->m_responses.size());
+		for(const auto& r : m_stream_ctx->m_responses) {
+			*res.add_outputs() = *r;
+		}
+		m_stream_ctx->m_responses.clear();
+		m_res_writer->Write(res, this);
+		return;
+	}
+
+	// Wait for a full batch, or for the deadline set by sub_batch(), without polling.
+	// The alarm is set before the subscription can cancel it to wake us up.
+	m_state = request_context_base::WAIT;
+	m_alarm.Set(m_completion_queue, m_stream_ctx->m_flush_deadline, this);
+	m_stream_ctx->m_subscription->wait(srv->m_batch_size, [this]() { m_alarm.Cancel(); });
+}
+
+template<>
+void request_stream_context<outputs::service, outputs::request, outputs::batch>::end(server* srv,
+                                                                                   bool error) {
+	if(m_stream_ctx) {
+		m_stream_ctx->m_status = error ? stream_context::ERROR : stream_context::SUCCESS;
+
+		// Complete the processing
+		(srv->*m_process_func)(*m_stream_ctx, m_req);  // sub_batch()
+	}
+
+	// Ask to start processing requests
+	start(srv);
+}
+
 template<>
 void request_context<version::service, version::request, version::response>::start(server* srv) {
 	m_state = request_context_base::REQUEST;
@@ -104,7 +165,7 @@ void request_context<version::service, version::request, version::response>::sta
 	auto srvctx = m_srv_ctx.get();
 	m_res_writer = std::make_unique<::grpc::ServerAsyncResponseWriter<version::response>>(srvctx);
 	m_req.Clear();
-	auto cq = srv->m_completion_queue.get();
+	auto cq = m_completion_queue;
 	// Request to start processing given requests.
 	// Using "this" - ie., the memory address of this context - as the tag that uniquely identifies
 	// the request. In this way, different contexts can serve different requests concurrently.
@@ -141,7 +202,7 @@ void request_bidi_context<outputs::service, outputs::request, outputs::response>
 	        std::make_unique<::grpc::ServerAsyncReaderWriter<outputs::response, outputs::request>>(
 	                srvctx);
 	m_req.Clear();
-	auto cq = srv->m_completion_queue.get();
+	auto cq = m_completion_queue;
 	// Request to start processing given requests.
 	// Using "this" - ie., the memory address of this context - as the tag that uniquely identifies
 	// the request. In this way, different contexts can serve different requests concurrently.
@@ -161,18 +222,17 @@ void request_bidi_context<outputs::service, outputs::request, outputs::response>
 	case request_context_base::WRITE:
 		// Processing
 		{
-			outputs::response res;
-			(srv->*m_process_func)(*m_bidi_ctx, m_req, res);  // sub()
+			(srv->*m_process_func)(*m_bidi_ctx, m_req);  // sub()
 
 			if(!m_bidi_ctx->m_is_running) {
 				m_state = request_context_base::FINISH;
-				m_reader_writer->Finish(::grpc::Status::OK, this);
+				m_reader_writer->Finish(m_bidi_ctx->m_finish_status, this);
 				return;
 			}
 
 			if(m_bidi_ctx->m_has_more) {
 				m_state = request_context_base::WRITE;
-				m_reader_writer->Write(res, this);
+				m_reader_writer->Write(*m_bidi_ctx->m_response, this);
 				return;
 			}
 
@@ -193,8 +253,7 @@ void request_bidi_context<outputs::service, outputs::request, outputs::response>
 		m_bidi_ctx->m_status = error ? bidi_context::ERROR : bidi_context::SUCCESS;
 
 		// Complete the processing
-		outputs::response res;
-		(srv->*m_process_func)(*m_bidi_ctx, m_req, res);  // sub()
+		(srv->*m_process_func)(*m_bidi_ctx, m_req);  // sub()
 	}
 
 	// Ask to start processing requests
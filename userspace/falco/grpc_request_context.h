@@ -19,6 +19,12 @@ limitations under the License.
 
 #pragma once
 
+#ifdef GRPC_INCLUDE_IS_GRPCPP
+#include <grpcpp/alarm.h>
+#else
+#include <grpc++/alarm.h>
+#endif
+
 #include "grpc_server.h"
 
 namespace falco {
@@ -31,7 +37,9 @@ public:
 	virtual ~request_context_base() = default;
 
 	std::unique_ptr<::grpc::ServerContext> m_srv_ctx;
-	enum : char { UNKNOWN = 0, REQUEST, WRITE, FINISH } m_state = UNKNOWN;
+	enum : char { UNKNOWN = 0, REQUEST, WRITE, WAIT, FINISH } m_state = UNKNOWN;
+	// The completion queue of all the events of this context, polled by a single thread
+	::grpc::ServerCompletionQueue* m_completion_queue = nullptr;
 
 	virtual void start(server* srv) = 0;
 	virtual void process(server* srv) = 0;
@@ -46,8 +54,9 @@ public:
 	request_stream_context(): m_process_func(nullptr), m_request_func(nullptr) {};
 	~request_stream_context() override = default;
 
-	// Pointer to function that does actual processing
-	void (server::*m_process_func)(const stream_context&, const Request&, Response&);
+	// Pointer to function that does actual processing, which sets the response to write next
+	// into the context
+	void (server::*m_process_func)(const stream_context&, const Request&);
 
 	// Pointer to function that requests the system to start processing given requests
 	void (Service::AsyncService::*m_request_func)(::grpc::ServerContext*,
@@ -65,6 +74,9 @@ private:
 	std::unique_ptr<::grpc::ServerAsyncWriter<Response>> m_res_writer;
 	std::unique_ptr<stream_context> m_stream_ctx;
 	Request m_req;
+	// Wakes up the stream while it waits for responses (WAIT state), either when it expires or
+	// when it gets cancelled
+	::grpc::Alarm m_alarm;
 };
 
 // The responsibility of `request_context` template class
@@ -101,8 +113,9 @@ public:
 	request_bidi_context(): m_process_func(nullptr), m_request_func(nullptr) {};
 	~request_bidi_context() override = default;
 
-	// Pointer to function that does actual processing
-	void (server::*m_process_func)(const bidi_context&, const Request&, Response&);
+	// Pointer to function that does actual processing, which sets the response to write next
+	// into the context
+	void (server::*m_process_func)(const bidi_context&, const Request&);
 
 	// Pointer to function that requests the system to start processing given requests
 	void (Service::AsyncService::*m_request_func)(
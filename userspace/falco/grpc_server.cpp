@@ -30,11 +30,18 @@ limitations under the License.
 #include "grpc_request_context.h"
 #include "falco_utils.h"
 
+#include <cstring>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #define REGISTER_STREAM(req, res, svc, rpc, impl, num)                      \
 	std::vector<request_stream_context<svc, req, res>> rpc##_contexts(num); \
 	for(request_stream_context<svc, req, res> & c : rpc##_contexts) {       \
 		c.m_process_func = &server::impl;                                   \
 		c.m_request_func = &svc::AsyncService::Request##rpc;                \
+		c.m_completion_queue = next_completion_queue();                     \
 		c.start(this);                                                      \
 	}
 
@@ -43,6 +50,7 @@ limitations under the License.
 	for(request_context<svc, req, res> & c : rpc##_contexts) {       \
 		c.m_process_func = &server::impl;                            \
 		c.m_request_func = &svc::AsyncService::Request##rpc;         \
+		c.m_completion_queue = next_completion_queue();              \
 		c.start(this);                                               \
 	}
 
@@ -51,6 +59,7 @@ limitations under the License.
 	for(request_bidi_context<svc, req, res> & c : rpc##_contexts) {       \
 		c.m_process_func = &server::impl;                                 \
 		c.m_request_func = &svc::AsyncService::Request##rpc;              \
+		c.m_completion_queue = next_completion_queue();                   \
 		c.start(this);                                                    \
 	}
 
@@ -74,10 +83,39 @@ static void gpr_log_dispatcher_func(gpr_log_func_args* args) {
 	falco_logger::log(priority, std::move(copy));
 }
 
+static void set_thread_affinity(int thread_index, uint32_t cpu) {
+	std::string err;
+#ifdef __linux__
+	if(cpu < CPU_SETSIZE) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+		if(ret == 0) {
+			return;
+		}
+		err = strerror(ret);
+	} else {
+		err = "CPU out of range";
+	}
+#else
+	err = "not supported on this platform";
+#endif
+	falco_logger::log(falco_logger::level::WARNING,
+	                  "Unable to pin the gRPC thread " + std::to_string(thread_index) +
+	                          " to CPU " + std::to_string(cpu) + ": " + err + "\n");
+}
+
 void falco::grpc::server::thread_process(int thread_index) {
+	if(!m_cpu_affinity.empty()) {
+		set_thread_affinity(thread_index, m_cpu_affinity[thread_index % m_cpu_affinity.size()]);
+	}
+
+	// Each thread only polls its own completion queue
+	auto& cq = m_completion_queues[thread_index];
 	void* tag = nullptr;
 	bool event_read_success = false;
-	while(m_completion_queue->Next(&tag, &event_read_success)) {
+	while(cq->Next(&tag, &event_read_success)) {
 		if(tag == nullptr) {
 			// todo(leodido) > log error "server completion queue error: empty tag"
 			continue;
@@ -91,7 +129,10 @@ void falco::grpc::server::thread_process(int thread_index) {
 
 		// When event has not been read successfully
 		if(!event_read_success) {
-			if(ctx->m_state != request_context_base::REQUEST) {
+			if(ctx->m_state == request_context_base::WAIT) {
+				// The alarm of a waiting stream got cancelled to wake it up
+				ctx->process(this);
+			} else if(ctx->m_state != request_context_base::REQUEST) {
 				// todo(leodido) > log error "server completion queue failing to read: tag=tag"
 
 				// End the context with error
@@ -106,6 +147,8 @@ void falco::grpc::server::thread_process(int thread_index) {
 			// Completion of m_request_func
 		case request_context_base::WRITE:
 			// Completion of Write()
+		case request_context_base::WAIT:
+			// Expiration of the alarm of a waiting stream
 			ctx->process(this);
 			break;
 		case request_context_base::FINISH:
@@ -127,12 +170,18 @@ void falco::grpc::server::init(const std::string& server_addr,
                                const std::string& private_key,
                                const std::string& cert_chain,
                                const std::string& root_certs,
-                               const std::string& log_level) {
+                               const std::string& log_level,
+                               size_t batch_size,
+                               uint32_t batch_max_delay_ms,
+                               const std::vector<uint32_t>& cpu_affinity) {
 	m_server_addr = server_addr;
 	m_threadiness = threadiness;
 	m_private_key = private_key;
 	m_cert_chain = cert_chain;
 	m_root_certs = root_certs;
+	m_batch_size = batch_size;
+	m_batch_max_delay = std::chrono::milliseconds(batch_max_delay_ms);
+	m_cpu_affinity = cpu_affinity;
 
 	// Set the verbosity level of gpr logger
 	falco::schema::priority logging_level = falco::schema::INFORMATIONAL;
@@ -184,7 +233,14 @@ void falco::grpc::server::run() {
 	m_server_builder.RegisterService(&m_output_svc);
 	m_server_builder.RegisterService(&m_version_svc);
 
-	m_completion_queue = m_server_builder.AddCompletionQueue();
+	// The waits may have been interrupted by a previous shutdown
+	queue::get().resume();
+
+	m_completion_queues.clear();
+	for(int i = 0; i < m_threadiness; i++) {
+		m_completion_queues.push_back(m_server_builder.AddCompletionQueue());
+	}
+	m_next_completion_queue = 0;
 	m_server = m_server_builder.BuildAndStart();
 	if(m_server == nullptr) {
 		falco_logger::log(falco_logger::level::EMERG, "Error starting gRPC server\n");
@@ -195,7 +251,7 @@ void falco::grpc::server::run() {
 	// The number of contexts is multiple of the number of threads
 	// This defines the number of simultaneous completion queue requests of the same type
 	// (service::AsyncService::Request##RPC) For this approach to be sufficient server::IMPL have to
-	// be fast
+	// be fast. The contexts of each type are spread evenly across the completion queues
 	int context_num = m_threadiness * 10;
 	// todo(leodido) > take a look at thread_stress_test.cc into grpc repository
 
@@ -207,6 +263,12 @@ void falco::grpc::server::run() {
 	               context_num)
 	REGISTER_STREAM(outputs::request, outputs::response, outputs::service, get, get, context_num)
 	REGISTER_BIDI(outputs::request, outputs::response, outputs::service, sub, sub, context_num)
+	REGISTER_STREAM(outputs::request,
+	                outputs::batch,
+	                outputs::service,
+	                sub_batch,
+	                sub_batch,
+	                context_num)
 
 	m_threads.resize(m_threadiness);
 	int thread_idx = 0;
@@ -224,7 +286,9 @@ void falco::grpc::server::stop() {
 	falco_logger::log(falco_logger::level::INFO,
 	                  "Shutting down gRPC server. Waiting until external connections are closed by "
 	                  "clients\n");
-	m_completion_queue->Shutdown();
+	for(auto& cq : m_completion_queues) {
+		cq->Shutdown();
+	}
 
 	falco_logger::log(falco_logger::level::INFO, "Waiting for the gRPC threads to complete\n");
 	for(std::thread& t : m_threads) {
@@ -238,12 +302,20 @@ void falco::grpc::server::stop() {
 	// Ignore remaining events
 	void* ignore_tag = nullptr;
 	bool ignore_ok = false;
-	while(m_completion_queue->Next(&ignore_tag, &ignore_ok)) {
+	for(auto& cq : m_completion_queues) {
+		while(cq->Next(&ignore_tag, &ignore_ok)) {
+		}
 	}
 
 	falco_logger::log(falco_logger::level::INFO, "Shutting down gRPC server complete\n");
 }
 
+::grpc::ServerCompletionQueue* falco::grpc::server::next_completion_queue() {
+	auto cq = m_completion_queues[m_next_completion_queue].get();
+	m_next_completion_queue = (m_next_completion_queue + 1) % m_completion_queues.size();
+	return cq;
+}
+
 bool falco::grpc::server::is_running() {
 	if(m_stop) {
 		return false;
@@ -251,12 +323,11 @@ bool falco::grpc::server::is_running() {
 	return true;
 }
 
-void falco::grpc::server::get(const stream_context& ctx,
-                              const outputs::request& req,
-                              outputs::response& res) {
+void falco::grpc::server::get(const stream_context& ctx, const outputs::request& req) {
 	if(ctx.m_status == stream_context::SUCCESS || ctx.m_status == stream_context::ERROR) {
 		// todo(leodido) > log "status=ctx->m_status, stream=ctx->m_stream"
 		ctx.m_stream = nullptr;
+		ctx.m_response.reset();
 		return;
 	}
 
@@ -266,24 +337,93 @@ void falco::grpc::server::get(const stream_context& ctx,
 	// m_status == stream_context::STREAMING?
 	// todo(leodido) > set m_stream
 
-	ctx.m_has_more = queue::get().try_pop(res);
+	if(!ctx.m_filter) {
+		ctx.m_filter = std::make_unique<response_filter>(req);
+	}
+
+	ctx.m_has_more = queue::get().try_pop(ctx.m_response, *ctx.m_filter);
+}
+
+// Ends the subscription of a stream, if any
+static void unsubscribe(const falco::grpc::stream_context& ctx) {
+	if(!ctx.m_subscription) {
+		return;
+	}
+	ctx.m_subscription->stop_waiting();
+	falco::grpc::queue::get().unsubscribe(ctx.m_subscription);
+	auto num_drops = ctx.m_subscription->get_num_drops();
+	if(num_drops > 0) {
+		falco_logger::log(falco_logger::level::WARNING,
+		                  "gRPC subscriber dropped " + std::to_string(num_drops) +
+		                          " output events because it was too slow to consume them\n");
+	}
+	ctx.m_subscription.reset();
 }
 
-void falco::grpc::server::sub(const bidi_context& ctx,
-                              const outputs::request& req,
-                              outputs::response& res) {
+// Subscribes a stream on its first call, and returns false if it must be disconnected because its
+// buffer overflowed
+static bool subscribe(const falco::grpc::stream_context& ctx, const falco::outputs::request& req) {
+	if(!ctx.m_subscription) {
+		ctx.m_subscription = falco::grpc::queue::get().subscribe(falco::grpc::response_filter(req));
+	}
+
+	if(ctx.m_subscription->overflowed()) {
+		ctx.m_is_running = false;
+		ctx.m_finish_status =
+		        ::grpc::Status(::grpc::StatusCode::RESOURCE_EXHAUSTED,
+		                       "subscriber too slow, output events buffer overflowed");
+		return false;
+	}
+	return true;
+}
+
+void falco::grpc::server::sub(const bidi_context& ctx, const outputs::request& req) {
 	if(ctx.m_status == stream_context::SUCCESS || ctx.m_status == stream_context::ERROR) {
 		ctx.m_stream = nullptr;
+		ctx.m_response.reset();
+		unsubscribe(ctx);
 		return;
 	}
 
 	ctx.m_is_running = is_running();
 
-	// Start or continue streaming
-	// m_status == stream_context::STREAMING?
-	// todo(leodido) > set m_stream
+	// Each subscriber receives the responses matching the filters of its first request, pushed
+	// since then, into its own bounded buffer
+	if(!subscribe(ctx, req)) {
+		return;
+	}
+
+	ctx.m_has_more = ctx.m_subscription->try_pop(ctx.m_response);
+}
 
-	ctx.m_has_more = queue::get().try_pop(res);
+void falco::grpc::server::sub_batch(const stream_context& ctx, const outputs::request& req) {
+	if(ctx.m_status == stream_context::SUCCESS || ctx.m_status == stream_context::ERROR) {
+		ctx.m_stream = nullptr;
+		ctx.m_responses.clear();
+		unsubscribe(ctx);
+		return;
+	}
+
+	ctx.m_is_running = is_running();
+
+	if(!subscribe(ctx, req)) {
+		return;
+	}
+	ctx.m_subscription->stop_waiting();
+
+	// Write a batch as soon as it is full, or when its deadline expires
+	auto now = std::chrono::system_clock::now();
+	ctx.m_responses.clear();
+	if(now >= ctx.m_flush_deadline || ctx.m_subscription->size() >= m_batch_size) {
+		ctx.m_subscription->try_pop(ctx.m_responses, m_batch_size);
+		ctx.m_flush_deadline = std::chrono::system_clock::time_point::max();
+	}
+	ctx.m_has_more = !ctx.m_responses.empty();
+
+	// Otherwise, wait for the next batch for up to the maximum delay
+	if(!ctx.m_has_more && ctx.m_flush_deadline == std::chrono::system_clock::time_point::max()) {
+		ctx.m_flush_deadline = now + m_batch_max_delay;
+	}
 }
 
 void falco::grpc::server::version(const context& ctx,
@@ -312,5 +452,8 @@ void falco::grpc::server::version(const context& ctx,
 
 void falco::grpc::server::shutdown() {
 	m_stop = true;
+	// The streams waiting for a batch would otherwise only notice when
+	// their alarm expires
+	queue::get().interrupt();
 	m_server->Shutdown();
 }
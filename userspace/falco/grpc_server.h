@@ -20,6 +20,8 @@ limitations under the License.
 #include <thread>
 #include <string>
 #include <atomic>
+#include <chrono>
+#include <vector>
 
 #include "outputs.grpc.pb.h"
 #include "version.grpc.pb.h"
@@ -38,7 +40,10 @@ public:
 	          const std::string& private_key,
 	          const std::string& cert_chain,
 	          const std::string& root_certs,
-	          const std::string& log_level);
+	          const std::string& log_level,
+	          size_t batch_size,
+	          uint32_t batch_max_delay_ms,
+	          const std::vector<uint32_t>& cpu_affinity);
 	void thread_process(int thread_index);
 	void run();
 	void stop();
@@ -47,11 +52,18 @@ public:
 	outputs::service::AsyncService m_output_svc;
 	version::service::AsyncService m_version_svc;
 
-	std::unique_ptr<::grpc::ServerCompletionQueue> m_completion_queue;
+	// One completion queue per thread, so that the threads don't contend on a single one
+	std::vector<std::unique_ptr<::grpc::ServerCompletionQueue>> m_completion_queues;
+
+	// The maximum number of responses per batch, and the maximum time a batch waits to be full
+	size_t m_batch_size = 100;
+	std::chrono::milliseconds m_batch_max_delay{100};
 
 private:
 	std::string m_server_addr;
 	int m_threadiness = 1;
+	std::vector<uint32_t> m_cpu_affinity;
+	size_t m_next_completion_queue = 0;
 	std::string m_private_key;
 	std::string m_cert_chain;
 	std::string m_root_certs;
@@ -60,12 +72,14 @@ private:
 	::grpc::ServerBuilder m_server_builder;
 	void init_mtls_server_builder();
 	void init_unix_server_builder();
+	::grpc::ServerCompletionQueue* next_completion_queue();
 
 	bool is_running();
 
 	// Outputs
-	void get(const stream_context& ctx, const outputs::request& req, outputs::response& res);
-	void sub(const bidi_context& ctx, const outputs::request& req, outputs::response& res);
+	void get(const stream_context& ctx, const outputs::request& req);
+	void sub(const bidi_context& ctx, const outputs::request& req);
+	void sub_batch(const stream_context& ctx, const outputs::request& req);
 
 	// Version
 	void version(const context& ctx, const version::request& req, version::response& res);
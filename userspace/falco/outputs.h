@@ -19,6 +19,8 @@ limitations under the License.
 
 #include <string>
 #include <map>
+#include <set>
+#include <vector>
 
 #include "falco_common.h"
 #include <nlohmann/json.hpp>
@@ -40,14 +42,19 @@ struct config {
 //  - an event that has matched some rule,
 //  - or a generic message (e.g., a drop alert).
 //
+// The rule, source and tags point to interned values that are shared
+// by all the messages and outlive them. The fields are stored as
+// (name, value) pairs, with the values that are not strings in their
+// JSON representation.
+//
 struct message {
 	uint64_t ts;
 	falco_common::priority_type priority;
 	std::string msg;
-	std::string rule;
-	std::string source;
-	nlohmann::json fields;
-	std::set<std::string> tags;
+	const std::string* rule;
+	const std::string* source;
+	std::vector<std::pair<std::string, std::string>> fields;
+	const std::set<std::string>* tags;
 };
 
 //
@@ -85,6 +92,14 @@ public:
 	// Possibly flush the output.
 	virtual void cleanup() {}
 
+	// Return true if the output reads the fields of the messages, which
+	// are otherwise not extracted.
+	virtual bool uses_fields() const { return false; }
+
+	// Return the output's own counters, as (name, value) pairs.
+	// This can be called concurrently with the other methods.
+	virtual std::vector<std::pair<std::string, uint64_t>> get_metrics() const { return {}; }
+
 protected:
 	config m_oc;
 	bool m_buffered;
@@ -16,37 +16,415 @@ limitations under the License.
 */
 
 #include "outputs_file.h"
-#include <iostream>
+#include "logger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
 #include <fstream>
+#include <tuple>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static int open_append(const std::string &path) {
+#ifdef _WIN32
+	return _open(path.c_str(),
+	             _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY,
+	             _S_IREAD | _S_IWRITE);
+#else
+	return open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0666);
+#endif
+}
+
+static uint64_t file_size(int fd) {
+#ifdef _WIN32
+	struct _stat64 st;
+	return _fstat64(fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+#else
+	struct stat st;
+	return fstat(fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+#endif
+}
+
+static void sync_file(int fd) {
+#ifdef _WIN32
+	_commit(fd);
+#else
+	fsync(fd);
+#endif
+}
+
+static void close_fd(int fd) {
+#ifdef _WIN32
+	_close(fd);
+#else
+	close(fd);
+#endif
+}
+
+// Writes all the chunks, with a single system call unless interrupted
+static bool write_all(int fd, std::initializer_list<std::string_view> chunks) {
+#ifdef _WIN32
+	for(auto chunk : chunks) {
+		while(!chunk.empty()) {
+			int n = _write(fd, chunk.data(), static_cast<unsigned int>(chunk.size()));
+			if(n < 0) {
+				return false;
+			}
+			chunk.remove_prefix(static_cast<size_t>(n));
+		}
+	}
+	return true;
+#else
+	struct iovec iov[4];
+	int cnt = 0;
+	for(auto chunk : chunks) {
+		if(!chunk.empty()) {
+			iov[cnt].iov_base = const_cast<char *>(chunk.data());
+			iov[cnt].iov_len = chunk.size();
+			cnt++;
+		}
+	}
+
+	int idx = 0;
+	while(idx < cnt) {
+		ssize_t n = writev(fd, iov + idx, cnt - idx);
+		if(n < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		// Skip what was written, in case of a partial write
+		auto written = static_cast<size_t>(n);
+		while(idx < cnt && written >= iov[idx].iov_len) {
+			written -= iov[idx].iov_len;
+			idx++;
+		}
+		if(idx < cnt) {
+			iov[idx].iov_base = static_cast<char *>(iov[idx].iov_base) + written;
+			iov[idx].iov_len -= written;
+		}
+	}
+	return true;
+#endif
+}
+
+static std::string get_option(const falco::outputs::config &oc,
+                              const std::string &key,
+                              const std::string &def) {
+	auto it = oc.options.find(key);
+	return it == oc.options.end() || it->second.empty() ? def : it->second;
+}
+
+falco::outputs::output_file::~output_file() {
+	if(m_flusher_thread.joinable()) {
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			m_stop = true;
+		}
+		m_cv.notify_all();
+		m_flusher_thread.join();
+	}
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		close_file();
+	}
+	if(m_rotation_thread.joinable()) {
+		m_rotation_thread.join();
+	}
+}
+
+bool falco::outputs::output_file::init(const config &oc,
+                                       bool buffered,
+                                       const std::string &hostname,
+                                       bool json_output,
+                                       std::string &err) {
+	if(!falco::outputs::abstract_output::init(oc, buffered, hostname, json_output, err)) {
+		return false;
+	}
+
+	m_filename = get_option(oc, "filename", "");
+	auto fsync = get_option(oc, "fsync", "never");
+	m_fsync = fsync == "flush"      ? fsync_policy::FLUSH
+	          : fsync == "rotation" ? fsync_policy::ROTATION
+	                                : fsync_policy::NEVER;
+	m_buffer_size = std::stoull(get_option(oc, "buffer_size", "262144"));
+	m_flush_interval =
+	        std::chrono::milliseconds(std::stoull(get_option(oc, "flush_interval_ms", "1000")));
+	m_max_size = std::stoull(get_option(oc, "rotation_max_size", "0"));
+	m_max_age = std::chrono::seconds(std::stoull(get_option(oc, "rotation_max_age_sec", "0")));
+	m_max_files = std::stoull(get_option(oc, "rotation_max_files", "0"));
+	m_compress = get_option(oc, "rotation_compression", "none") == "gzip";
+
+	// Falco owns the file when it rotates it, so there is no need to reopen
+	// it for each alert
+	bool rotation = m_max_size > 0 || m_max_age.count() > 0;
+	m_keep_open = get_option(oc, "keep_alive", "") == "true" || rotation;
+
+	if(m_buffered) {
+		m_buffer.reserve(m_buffer_size);
+	}
+	if(m_keep_open && (m_buffered || m_max_age.count() > 0)) {
+		m_flusher_thread = std::thread(&output_file::flusher, this);
+	}
+	return true;
+}
 
 void falco::outputs::output_file::open_file() {
-	if(!m_buffered) {
-		m_outfile.rdbuf()->pubsetbuf(0, 0);
+	m_fd = open_append(m_filename);
+	if(m_fd < 0) {
+		throw falco_exception("failed to open output file " + m_filename + ": " +
+		                      strerror(errno));
+	}
+	m_size = file_size(m_fd);
+	m_opened_at = std::chrono::steady_clock::now();
+}
+
+void falco::outputs::output_file::close_file() {
+	if(m_fd < 0) {
+		return;
 	}
-	if(!m_outfile.is_open()) {
-		m_outfile.open(m_oc.options["filename"], std::fstream::app);
-		if(m_outfile.fail()) {
-			throw falco_exception("failed to open output file " + m_oc.options["filename"]);
+	flush();
+	if(m_fsync != fsync_policy::NEVER) {
+		sync_file(m_fd);
+	}
+	close_fd(m_fd);
+	m_fd = -1;
+}
+
+void falco::outputs::output_file::flush() {
+	if(!m_buffer.empty()) {
+		write({m_buffer});
+		m_buffer.clear();
+	}
+}
+
+void falco::outputs::output_file::write(std::initializer_list<std::string_view> chunks) {
+	m_num_writes++;
+	if(!write_all(m_fd, chunks)) {
+		// Only the first failure is logged, the following ones are
+		// counted in the write_failures metric
+		if(m_num_write_failures++ == 0) {
+			falco_logger::log(falco_logger::level::ERR,
+			                  "Failed to write to output file " + m_filename + ": " +
+			                          strerror(errno) + ". Drop event and continue on ...\n");
 		}
+		return;
+	}
+	if(m_fsync == fsync_policy::FLUSH) {
+		sync_file(m_fd);
 	}
 }
 
-void falco::outputs::output_file::output(const message *msg) {
+bool falco::outputs::output_file::must_rotate(size_t size) const {
+	if(m_size == 0) {
+		return false;
+	}
+	return (m_max_size > 0 && m_size + size > m_max_size) ||
+	       (m_max_age.count() > 0 && std::chrono::steady_clock::now() - m_opened_at >= m_max_age);
+}
+
+void falco::outputs::output_file::rotate() {
+	close_file();
+
+	// The rotated files are named after the time of their rotation
+	char suffix[32];
+	time_t now = time(nullptr);
+	strftime(suffix, sizeof(suffix), ".%Y%m%dT%H%M%SZ", gmtime(&now));
+	std::string rotated = m_filename + suffix;
+	std::error_code ec;
+	for(int i = 1; fs::exists(rotated, ec) || fs::exists(rotated + ".gz", ec); i++) {
+		rotated = m_filename + suffix + "." + std::to_string(i);
+	}
+
+	fs::rename(m_filename, rotated, ec);
+	if(ec) {
+		falco_logger::log(falco_logger::level::ERR,
+		                  "Failed to rotate output file " + m_filename + ": " + ec.message() +
+		                          "\n");
+	} else {
+		m_num_rotations++;
+		if(m_compress || m_max_files > 0) {
+			// Queued for the running thread if any, so that the alerts
+			// are never held back by the compression of a previous file
+			m_rotated_files.push_back(rotated);
+			if(!m_rotation_running) {
+				// The previous thread, if any, is already exiting
+				if(m_rotation_thread.joinable()) {
+					m_rotation_thread.join();
+				}
+				m_rotation_running = true;
+				m_rotation_thread = std::thread(&output_file::rotated_files_worker, this);
+			}
+		}
+	}
+
 	open_file();
-	m_outfile << msg->msg + "\n";
+}
 
-	if(m_oc.options["keep_alive"] != "true") {
-		cleanup();
+void falco::outputs::output_file::rotated_files_worker() noexcept {
+	while(true) {
+		std::string path;
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			if(m_rotated_files.empty()) {
+				m_rotation_running = false;
+				return;
+			}
+			path = std::move(m_rotated_files.front());
+			m_rotated_files.pop_front();
+		}
+		compress_and_prune(path, m_compress, m_filename, m_max_files);
 	}
 }
 
-void falco::outputs::output_file::cleanup() {
-	if(m_outfile.is_open()) {
-		m_outfile.close();
+void falco::outputs::output_file::compress_and_prune(const std::string &path,
+                                                     bool compress,
+                                                     const std::string &filename,
+                                                     uint64_t max_files) noexcept {
+	if(compress) {
+		std::ifstream in(path, std::ios::binary);
+		gzFile out = gzopen((path + ".gz").c_str(), "wb");
+		bool ok = in.is_open() && out != nullptr;
+		char buf[65536];
+		while(ok && in) {
+			in.read(buf, sizeof(buf));
+			auto n = static_cast<unsigned>(in.gcount());
+			ok = n == 0 || gzwrite(out, buf, n) == static_cast<int>(n);
+		}
+		ok = out != nullptr && gzclose(out) == Z_OK && ok;
+
+		std::error_code ec;
+		fs::remove(ok ? path : path + ".gz", ec);
+		if(!ok) {
+			falco_logger::log(falco_logger::level::ERR,
+			                  "Failed to compress rotated output file " + path + "\n");
+		}
+	}
+
+	if(max_files == 0) {
+		return;
+	}
+
+	// The rotated files are those named after the output file followed by
+	// the time of their rotation, and a counter for the ones rotated in
+	// the same second. They are sorted by name rather than modification
+	// time, since a file being compressed is newer than the ones queued
+	// after it.
+	fs::path base(filename);
+	auto dir = base.has_parent_path() ? base.parent_path() : fs::path(".");
+	auto prefix = base.filename().string() + ".";
+	std::vector<std::tuple<std::string, uint64_t, fs::path>> rotated;
+	std::error_code ec;
+	for(fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+		auto name = it->path().filename().string();
+		if(name.size() > prefix.size() && name.compare(0, prefix.size(), prefix) == 0 &&
+		   isdigit(static_cast<unsigned char>(name[prefix.size()])) && it->is_regular_file(ec)) {
+			auto time = name.substr(prefix.size());
+			if(it->path().extension() == ".gz") {
+				time.resize(time.size() - 3);
+			}
+			uint64_t counter = 0;
+			auto pos = time.find('.');
+			if(pos != std::string::npos) {
+				counter = std::strtoull(time.c_str() + pos + 1, nullptr, 10);
+				time.resize(pos);
+			}
+			rotated.emplace_back(time, counter, it->path());
+		}
+	}
+	std::sort(rotated.begin(), rotated.end());
+	for(size_t i = 0; i + max_files < rotated.size(); i++) {
+		fs::remove(std::get<2>(rotated[i]), ec);
 	}
 }
 
+void falco::outputs::output_file::flusher() noexcept {
+	std::unique_lock<std::mutex> lock(m_mtx);
+	while(!m_stop) {
+		auto now = std::chrono::steady_clock::now();
+		m_cv.wait_until(lock, m_buffer.empty() ? now + m_flush_interval
+		                                       : m_buffer_start + m_flush_interval);
+		if(m_stop || m_fd < 0) {
+			continue;
+		}
+
+		if(!m_buffer.empty() &&
+		   std::chrono::steady_clock::now() - m_buffer_start >= m_flush_interval) {
+			flush();
+		}
+		if(m_max_age.count() > 0 && must_rotate(0)) {
+			try {
+				rotate();
+			} catch(const falco_exception &e) {
+				falco_logger::log(falco_logger::level::ERR, std::string(e.what()) + "\n");
+			}
+		}
+	}
+}
+
+void falco::outputs::output_file::output(const message *msg) {
+	std::unique_lock<std::mutex> lock(m_mtx);
+	if(m_fd < 0) {
+		open_file();
+	}
+
+	size_t size = msg->msg.size() + 1;
+	if(must_rotate(size)) {
+		rotate();
+	}
+
+	if(!m_buffered) {
+		write({msg->msg, "\n"});
+	} else if(m_buffer.size() + size > m_buffer_size) {
+		// The alert is written along with the buffer, without copying it
+		write({m_buffer, msg->msg, "\n"});
+		m_buffer.clear();
+	} else {
+		if(m_buffer.empty()) {
+			m_buffer_start = std::chrono::steady_clock::now();
+			m_cv.notify_one();
+		}
+		m_buffer.append(msg->msg);
+		m_buffer.push_back('\n');
+	}
+	m_size += size;
+
+	if(!m_keep_open) {
+		close_file();
+	}
+}
+
+void falco::outputs::output_file::cleanup() {
+	std::unique_lock<std::mutex> lock(m_mtx);
+	close_file();
+}
+
 void falco::outputs::output_file::reopen() {
-	cleanup();
+	std::unique_lock<std::mutex> lock(m_mtx);
+	close_file();
 	open_file();
 }
+
+std::vector<std::pair<std::string, uint64_t>> falco::outputs::output_file::get_metrics() const {
+	return {
+	        {"writes", m_num_writes.load()},
+	        {"write_failures", m_num_write_failures.load()},
+	        {"rotations", m_num_rotations.load()},
+	};
+}
@@ -18,23 +18,91 @@ limitations under the License.
 #pragma once
 
 #include "outputs.h"
-#include <iostream>
-#include <fstream>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <thread>
 
 namespace falco {
 namespace outputs {
 
 class output_file : public abstract_output {
+public:
+	~output_file();
+
+	bool init(const config &oc,
+	          bool buffered,
+	          const std::string &hostname,
+	          bool json_output,
+	          std::string &err) override;
+
 	void output(const message *msg) override;
 
 	void cleanup() override;
 
 	void reopen() override;
 
+	std::vector<std::pair<std::string, uint64_t>> get_metrics() const override;
+
 private:
+	enum class fsync_policy { NEVER, FLUSH, ROTATION };
+
+	// All the following must be called with m_mtx held
 	void open_file();
+	void close_file();
+	void flush();
+	void write(std::initializer_list<std::string_view> chunks);
+	bool must_rotate(size_t size) const;
+	void rotate();
+
+	void flusher() noexcept;
+	void rotated_files_worker() noexcept;
+	static void compress_and_prune(const std::string &path,
+	                               bool compress,
+	                               const std::string &filename,
+	                               uint64_t max_files) noexcept;
+
+	std::string m_filename;
+	bool m_keep_open;
+	fsync_policy m_fsync;
+
+	// When buffered, the alerts are accumulated into m_buffer, which is
+	// written once full, and by m_flusher_thread once older than
+	// m_flush_interval
+	size_t m_buffer_size;
+	std::chrono::milliseconds m_flush_interval;
+	std::string m_buffer;
+	std::chrono::steady_clock::time_point m_buffer_start;
+
+	// The file is rotated once larger than m_max_size or older than
+	// m_max_age, when those are set, and the rotated files are compressed
+	// and pruned by m_rotation_thread, one at a time in the order of
+	// m_rotated_files. The thread exits once m_rotated_files is empty,
+	// and m_rotation_running is cleared.
+	uint64_t m_max_size;
+	std::chrono::seconds m_max_age;
+	uint64_t m_max_files;
+	bool m_compress;
+	std::thread m_rotation_thread;
+	std::deque<std::string> m_rotated_files;
+	bool m_rotation_running = false;
+
+	int m_fd = -1;
+	uint64_t m_size = 0;
+	std::chrono::steady_clock::time_point m_opened_at;
+
+	std::mutex m_mtx;
+	std::condition_variable m_cv;
+	bool m_stop = false;
+	std::thread m_flusher_thread;
 
-	std::ofstream m_outfile;
+	std::atomic<uint64_t> m_num_writes = 0;
+	std::atomic<uint64_t> m_num_write_failures = 0;
+	std::atomic<uint64_t> m_num_rotations = 0;
 };
 
 }  // namespace outputs
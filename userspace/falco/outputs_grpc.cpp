@@ -36,6 +36,29 @@ limitations under the License.
 #define DISABLE_WARNING_DEPRECATED_DECLARATIONS
 #endif
 
+bool falco::outputs::output_grpc::init(const config &oc,
+                                       bool buffered,
+                                       const std::string &hostname,
+                                       bool json_output,
+                                       std::string &err) {
+	if(!falco::outputs::abstract_output::init(oc, buffered, hostname, json_output, err)) {
+		return false;
+	}
+
+	size_t capacity = 10000;
+	auto it = oc.options.find("subscriber_buffer_size");
+	if(it != oc.options.end() && !it->second.empty()) {
+		capacity = std::stoull(it->second);
+	}
+	auto policy = falco::grpc::slow_subscriber_policy::DROP_OLDEST;
+	it = oc.options.find("slow_subscriber_policy");
+	if(it != oc.options.end() && it->second == "disconnect") {
+		policy = falco::grpc::slow_subscriber_policy::DISCONNECT;
+	}
+	falco::grpc::queue::get().configure(capacity, policy);
+	return true;
+}
+
 void falco::outputs::output_grpc::output(const message *msg) {
 	falco::outputs::response grpc_res;
 
@@ -45,7 +68,7 @@ void falco::outputs::output_grpc::output(const message *msg) {
 
 	// rule
 	auto r = grpc_res.mutable_rule();
-	*r = msg->rule;
+	*r = *msg->rule;
 
 	// source_deprecated (maintained for backward compatibility)
 	// Setting this as reserved would cause old clients to receive the
@@ -55,7 +78,7 @@ void falco::outputs::output_grpc::output(const message *msg) {
 	// enum entry instead.
 	// todo(jasondellaluce): remove source_deprecated and reserve its number
 	falco::schema::source s = falco::schema::source::SYSCALL;
-	if(!falco::schema::source_Parse(msg->source, &s)) {
+	if(!falco::schema::source_Parse(*msg->source, &s)) {
 		// unknown source names are expected to come from plugins
 		s = falco::schema::source::PLUGIN;
 	}
@@ -77,12 +100,8 @@ void falco::outputs::output_grpc::output(const message *msg) {
 
 	// output fields
 	auto &fields = *grpc_res.mutable_output_fields();
-	for(const auto &kv : msg->fields.items()) {
-		if(!kv.value().is_primitive()) {
-			throw falco_exception("output_grpc: output fields must be key-value maps");
-		}
-		fields[kv.key()] =
-		        (kv.value().is_string()) ? kv.value().get<std::string>() : kv.value().dump();
+	for(const auto &kv : msg->fields) {
+		fields[kv.first] = kv.second;
 	}
 
 	// hostname
@@ -91,11 +110,20 @@ void falco::outputs::output_grpc::output(const message *msg) {
 
 	// tags
 	auto tags = grpc_res.mutable_tags();
-	*tags = {msg->tags.begin(), msg->tags.end()};
+	*tags = {msg->tags->begin(), msg->tags->end()};
 
 	// source
 	auto source = grpc_res.mutable_source();
-	*source = msg->source;
+	*source = *msg->source;
+
+	falco::grpc::queue::get().push(std::move(grpc_res));
+}
 
-	falco::grpc::queue::get().push(grpc_res);
+std::vector<std::pair<std::string, uint64_t>> falco::outputs::output_grpc::get_metrics() const {
+	auto &queue = falco::grpc::queue::get();
+	return {
+	        {"subscriber_drops", queue.get_num_drops()},
+	        {"subscriber_disconnects", queue.get_num_disconnects()},
+	        {"backlog_drops", queue.get_num_backlog_drops()},
+	};
 }
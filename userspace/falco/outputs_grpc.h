@@ -23,7 +23,16 @@ namespace falco {
 namespace outputs {
 
 class output_grpc : public abstract_output {
+	bool init(const config &oc,
+	          bool buffered,
+	          const std::string &hostname,
+	          bool json_output,
+	          std::string &err) override;
+
 	void output(const message *msg) override;
+	bool uses_fields() const override { return true; }
+
+	std::vector<std::pair<std::string, uint64_t>> get_metrics() const override;
 };
 
 }  // namespace outputs
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "outputs_http.h"
 #include "logger.h"
+#include "falco_utils.h"
 
 #define CHECK_RES(fn) res = res == CURLE_OK ? fn : res
 
@@ -39,77 +40,149 @@ bool falco::outputs::output_http::init(const config &oc,
 
 	m_curl = nullptr;
 	m_http_headers = nullptr;
+	m_multi = nullptr;
+	m_stop = false;
 	m_max_consecutive_timeouts =
 	        static_cast<uint8_t>(std::stoi(m_oc.options["max_consecutive_timeouts"]) & 0xFF);
+	m_compress_uploads = m_oc.options["compress_uploads"] == std::string("true");
+	m_batching = m_oc.options["batch_enabled"] == std::string("true");
+	m_json_array = false;
+	if(m_batching) {
+		m_json_array = m_json_output && m_oc.options["batch_format"] == std::string("json_array");
+		m_batch_max_messages = std::stoull(m_oc.options["batch_max_messages"]);
+		m_batch_max_bytes = std::stoull(m_oc.options["batch_max_bytes"]);
+		m_batch_flush_interval =
+		        std::chrono::milliseconds(std::stoull(m_oc.options["batch_flush_interval_ms"]));
+		m_max_in_flight = std::stoull(m_oc.options["max_in_flight"]);
+	}
 	CURLcode res = CURLE_FAILED_INIT;
 
-	m_curl = curl_easy_init();
-	if(!m_curl) {
-		falco_logger::log(
-		        falco_logger::level::ERR,
-		        "libcurl failed to initialize the handle: " + std::string(curl_easy_strerror(res)));
-		return false;
-	}
 	if(m_json_output) {
-		m_http_headers = curl_slist_append(m_http_headers, "Content-Type: application/json");
+		// Batches that are not JSON arrays are sent as newline-delimited JSON
+		m_http_headers = curl_slist_append(m_http_headers,
+		                                   m_batching && !m_json_array
+		                                           ? "Content-Type: application/x-ndjson"
+		                                           : "Content-Type: application/json");
 	} else {
 		m_http_headers = curl_slist_append(m_http_headers, "Content-Type: text/plain");
 	}
-	res = curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, m_http_headers);
+	if(m_compress_uploads) {
+		m_http_headers = curl_slist_append(m_http_headers, "Content-Encoding: gzip");
+	}
 
 	// if the URL is quoted the quotes should be removed to satisfy libcurl expected format
-	std::string unquotedUrl = m_oc.options["url"];
-	if(!unquotedUrl.empty() && ((unquotedUrl.front() == '\"' && unquotedUrl.back() == '\"') ||
-	                            (unquotedUrl.front() == '\'' && unquotedUrl.back() == '\''))) {
-		unquotedUrl = libsinsp::filter::unescape_str(unquotedUrl);
+	m_url = m_oc.options["url"];
+	if(!m_url.empty() && ((m_url.front() == '\"' && m_url.back() == '\"') ||
+	                      (m_url.front() == '\'' && m_url.back() == '\''))) {
+		m_url = libsinsp::filter::unescape_str(m_url);
 	}
-	CHECK_RES(curl_easy_setopt(m_curl, CURLOPT_URL, unquotedUrl.c_str()));
 
-	CHECK_RES(curl_easy_setopt(m_curl, CURLOPT_USERAGENT, m_oc.options["user_agent"].c_str()));
-	CHECK_RES(curl_easy_setopt(m_curl, CURLOPT_POSTFIELDSIZE, -1L));
+	if(!m_batching) {
+		m_curl = curl_easy_init();
+		if(!m_curl) {
+			falco_logger::log(falco_logger::level::ERR,
+			                  "libcurl failed to initialize the handle: " +
+			                          std::string(curl_easy_strerror(res)));
+			return false;
+		}
+		res = setup_handle(m_curl);
+	} else {
+		m_multi = curl_multi_init();
+		if(!m_multi) {
+			falco_logger::log(falco_logger::level::ERR,
+			                  "libcurl failed to initialize the multi handle: " +
+			                          std::string(curl_easy_strerror(res)));
+			return false;
+		}
+		// All the transfers go to the same host, so that the connections
+		// are kept in the multi handle's cache and reused across batches
+		curl_multi_setopt(m_multi,
+		                  CURLMOPT_MAX_HOST_CONNECTIONS,
+		                  static_cast<long>(m_max_in_flight));
+
+		res = CURLE_OK;
+		m_transfers.resize(m_max_in_flight);
+		for(auto &t : m_transfers) {
+			t.curl = curl_easy_init();
+			if(!t.curl) {
+				err = "libcurl failed to initialize the handle";
+				return false;
+			}
+			CHECK_RES(setup_handle(t.curl));
+			CHECK_RES(curl_easy_setopt(t.curl, CURLOPT_PRIVATE, &t));
+		}
+	}
+
+	if(res != CURLE_OK) {
+		err = "libcurl error: " + std::string(curl_easy_strerror(res));
+		return false;
+	}
+
+	if(m_batching) {
+		m_sender_thread = std::thread(&output_http::sender, this);
+	}
+	return true;
+}
+
+CURLcode falco::outputs::output_http::setup_handle(CURL *curl) {
+	CURLcode res = curl_easy_setopt(curl, CURLOPT_HTTPHEADER, m_http_headers);
+
+	CHECK_RES(curl_easy_setopt(curl, CURLOPT_URL, m_url.c_str()));
+
+	CHECK_RES(curl_easy_setopt(curl, CURLOPT_USERAGENT, m_oc.options["user_agent"].c_str()));
 
 	if(m_oc.options["insecure"] == std::string("true")) {
-		CHECK_RES(curl_easy_setopt(m_curl, CURLOPT_SSL_VERIFYPEER, 0L));
-		CHECK_RES(curl_easy_setopt(m_curl, CURLOPT_SSL_VERIFYHOST, 0L));
+		CHECK_RES(curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L));
+		CHECK_RES(curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L));
 	}
 
 	if(m_oc.options["mtls"] == std::string("true")) {
-		CHECK_RES(curl_easy_setopt(m_curl, CURLOPT_SSLCERT, m_oc.options["client_cert"].c_str()));
-		CHECK_RES(curl_easy_setopt(m_curl, CURLOPT_SSLKEY, m_oc.options["client_key"].c_str()));
+		CHECK_RES(curl_easy_setopt(curl, CURLOPT_SSLCERT, m_oc.options["client_cert"].c_str()));
+		CHECK_RES(curl_easy_setopt(curl, CURLOPT_SSLKEY, m_oc.options["client_key"].c_str()));
 	}
 
 	if(!m_oc.options["ca_cert"].empty()) {
-		CHECK_RES(curl_easy_setopt(m_curl, CURLOPT_CAINFO, m_oc.options["ca_cert"].c_str()));
+		CHECK_RES(curl_easy_setopt(curl, CURLOPT_CAINFO, m_oc.options["ca_cert"].c_str()));
 	} else if(!m_oc.options["ca_bundle"].empty()) {
-		CHECK_RES(curl_easy_setopt(m_curl, CURLOPT_CAINFO, m_oc.options["ca_bundle"].c_str()));
+		CHECK_RES(curl_easy_setopt(curl, CURLOPT_CAINFO, m_oc.options["ca_bundle"].c_str()));
 	} else {
-		CHECK_RES(curl_easy_setopt(m_curl, CURLOPT_CAPATH, m_oc.options["ca_path"].c_str()));
+		CHECK_RES(curl_easy_setopt(curl, CURLOPT_CAPATH, m_oc.options["ca_path"].c_str()));
 	}
 
 	if(m_oc.options["echo"] == std::string("false")) {
 		// If echo==true, libcurl defaults to fwrite to stdout, ie: echoing
-		CHECK_RES(curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, noop_write_callback));
-	}
-
-	if(m_oc.options["compress_uploads"] == std::string("true")) {
-		CHECK_RES(curl_easy_setopt(m_curl, CURLOPT_TRANSFER_ENCODING, 1L));
+		CHECK_RES(curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, noop_write_callback));
 	}
 
 	if(m_oc.options["keep_alive"] == std::string("true")) {
-		CHECK_RES(curl_easy_setopt(m_curl, CURLOPT_TCP_KEEPALIVE, 1L));
+		CHECK_RES(curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L));
 	}
 
-	if(res != CURLE_OK) {
-		err = "libcurl error: " + std::string(curl_easy_strerror(res));
-		return false;
-	}
-	return true;
+	return res;
 }
 
 void falco::outputs::output_http::output(const message *msg) {
-	CURLcode res = curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, msg->msg.c_str());
+	if(m_batching) {
+		append_to_batch(msg->msg);
+		return;
+	}
+
+	const std::string *body = &msg->msg;
+	std::string compressed;
+	if(m_compress_uploads) {
+		if(!falco::utils::gzip_compress(msg->msg, compressed)) {
+			falco_logger::log(falco_logger::level::ERR, "zlib failed to compress the payload");
+			m_num_request_failures++;
+			return;
+		}
+		body = &compressed;
+	}
+
+	CURLcode res = curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, body->data());
+	CHECK_RES(curl_easy_setopt(m_curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body->size())));
 	uint8_t curl_easy_platform_calls = 0;
 
+	auto start = std::chrono::steady_clock::now();
 	if(res == CURLE_OK) {
 		do {
 			res = curl_easy_perform(m_curl);
@@ -117,8 +190,190 @@ void falco::outputs::output_http::output(const message *msg) {
 		} while(res == CURLE_OPERATION_TIMEDOUT &&
 		        curl_easy_platform_calls <= m_max_consecutive_timeouts);
 	}
+	m_request_latency_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+	                                std::chrono::steady_clock::now() - start)
+	                                .count();
+	m_num_requests++;
+	if(curl_easy_platform_calls > 1) {
+		m_num_retries += curl_easy_platform_calls - 1;
+	}
 
 	if(res != CURLE_OK) {
+		m_num_request_failures++;
+		falco_logger::log(
+		        falco_logger::level::ERR,
+		        "libcurl failed to perform call: " + std::string(curl_easy_strerror(res)));
+	}
+}
+
+void falco::outputs::output_http::append_to_batch(const std::string &msg) {
+	std::unique_lock<std::mutex> lck(m_mtx);
+
+	// Apply backpressure to the outputs queue when the requests can't keep up
+	m_cv.wait(lck, [this] { return m_sealed.size() < m_max_in_flight || m_stop; });
+	if(m_stop) {
+		return;
+	}
+
+	bool first = m_batch.num_messages == 0;
+	if(first) {
+		m_batch_start = std::chrono::steady_clock::now();
+		if(m_json_array) {
+			m_batch.body += '[';
+		}
+	} else if(m_json_array) {
+		m_batch.body += ',';
+	}
+	m_batch.body += msg;
+	if(!m_json_array) {
+		m_batch.body += '\n';
+	}
+	m_batch.num_messages++;
+
+	bool full = m_batch.num_messages >= m_batch_max_messages ||
+	            m_batch.body.size() >= m_batch_max_bytes;
+	if(full) {
+		seal_batch();
+	}
+	lck.unlock();
+
+	// The sender must know about a new batch to schedule its flush
+	if(first || full) {
+		curl_multi_wakeup(m_multi);
+	}
+}
+
+// Must be called with m_mtx held
+void falco::outputs::output_http::seal_batch() {
+	if(m_batch.num_messages == 0) {
+		return;
+	}
+	if(m_json_array) {
+		m_batch.body += ']';
+	}
+	m_sealed.push_back(std::move(m_batch));
+	m_batch = batch();
+}
+
+void falco::outputs::output_http::sender() noexcept {
+	std::vector<transfer *> idle;
+	for(auto &t : m_transfers) {
+		idle.push_back(&t);
+	}
+
+	std::vector<transfer *> starting;
+	int running = 0;
+	while(true) {
+		auto timeout = m_batch_flush_interval;
+		{
+			std::unique_lock<std::mutex> lck(m_mtx);
+			if(m_batch.num_messages > 0) {
+				auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+				        std::chrono::steady_clock::now() - m_batch_start);
+				if(m_stop || elapsed >= m_batch_flush_interval) {
+					seal_batch();
+				} else {
+					timeout = m_batch_flush_interval - elapsed;
+				}
+			}
+
+			while(!idle.empty() && !m_sealed.empty()) {
+				auto t = idle.back();
+				idle.pop_back();
+				t->data = std::move(m_sealed.front());
+				m_sealed.pop_front();
+				starting.push_back(t);
+			}
+
+			if(m_stop && m_sealed.empty() && idle.size() == m_transfers.size()) {
+				break;
+			}
+		}
+		m_cv.notify_all();
+
+		// Compression happens out of the lock, not to block new alerts
+		for(auto t : starting) {
+			if(!start_transfer(*t)) {
+				idle.push_back(t);
+			}
+		}
+		starting.clear();
+
+		curl_multi_perform(m_multi, &running);
+
+		CURLMsg *cmsg;
+		int num_msgs;
+		while((cmsg = curl_multi_info_read(m_multi, &num_msgs))) {
+			if(cmsg->msg != CURLMSG_DONE) {
+				continue;
+			}
+
+			CURL *curl = cmsg->easy_handle;
+			CURLcode res = cmsg->data.result;
+			char *priv = nullptr;
+			curl_easy_getinfo(curl, CURLINFO_PRIVATE, &priv);
+			auto t = reinterpret_cast<transfer *>(priv);
+			curl_multi_remove_handle(m_multi, curl);
+
+			if(res == CURLE_OPERATION_TIMEDOUT && t->num_timeouts < m_max_consecutive_timeouts) {
+				t->num_timeouts++;
+				m_num_retries++;
+				curl_multi_add_handle(m_multi, curl);
+				continue;
+			}
+			complete_transfer(*t, res);
+			idle.push_back(t);
+		}
+
+		// Sleep until a transfer progresses, a batch is added, or the
+		// current batch must be flushed
+		curl_multi_poll(m_multi, nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+	}
+}
+
+bool falco::outputs::output_http::start_transfer(transfer &t) {
+	if(m_compress_uploads) {
+		std::string compressed;
+		if(!falco::utils::gzip_compress(t.data.body, compressed)) {
+			falco_logger::log(falco_logger::level::ERR, "zlib failed to compress the payload");
+			m_num_request_failures++;
+			t.data = batch();
+			return false;
+		}
+		t.data.body = std::move(compressed);
+	}
+
+	t.num_timeouts = 0;
+	t.start = std::chrono::steady_clock::now();
+	CURLcode res = curl_easy_setopt(t.curl, CURLOPT_POSTFIELDS, t.data.body.data());
+	CHECK_RES(
+	        curl_easy_setopt(t.curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(t.data.body.size())));
+	std::string err;
+	if(res != CURLE_OK) {
+		err = curl_easy_strerror(res);
+	} else if(auto mres = curl_multi_add_handle(m_multi, t.curl); mres != CURLM_OK) {
+		err = curl_multi_strerror(mres);
+	}
+	if(!err.empty()) {
+		falco_logger::log(falco_logger::level::ERR, "libcurl failed to start call: " + err);
+		m_num_request_failures++;
+		t.data = batch();
+		return false;
+	}
+	return true;
+}
+
+void falco::outputs::output_http::complete_transfer(transfer &t, CURLcode res) {
+	m_request_latency_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+	                                std::chrono::steady_clock::now() - t.start)
+	                                .count();
+	m_num_requests++;
+	m_num_batches++;
+	m_num_batched_messages += t.data.num_messages;
+	t.data = batch();
+
+	if(res != CURLE_OK) {
+		m_num_request_failures++;
 		falco_logger::log(
 		        falco_logger::level::ERR,
 		        "libcurl failed to perform call: " + std::string(curl_easy_strerror(res)));
@@ -126,8 +381,36 @@ void falco::outputs::output_http::output(const message *msg) {
 }
 
 void falco::outputs::output_http::cleanup() {
+	if(m_sender_thread.joinable()) {
+		// Let the sender flush the pending alerts before stopping
+		{
+			std::unique_lock<std::mutex> lck(m_mtx);
+			m_stop = true;
+		}
+		m_cv.notify_all();
+		curl_multi_wakeup(m_multi);
+		m_sender_thread.join();
+	}
+	for(auto &t : m_transfers) {
+		curl_easy_cleanup(t.curl);
+	}
+	m_transfers.clear();
+	curl_multi_cleanup(m_multi);
+	m_multi = nullptr;
+
 	curl_easy_cleanup(m_curl);
 	m_curl = nullptr;
 	curl_slist_free_all(m_http_headers);
 	m_http_headers = nullptr;
 }
+
+std::vector<std::pair<std::string, uint64_t>> falco::outputs::output_http::get_metrics() const {
+	return {
+	        {"requests", m_num_requests.load()},
+	        {"request_failures", m_num_request_failures.load()},
+	        {"request_latency_ns", m_request_latency_ns.load()},
+	        {"retries", m_num_retries.load()},
+	        {"batches", m_num_batches.load()},
+	        {"batched_messages", m_num_batched_messages.load()},
+	};
+}
@@ -21,6 +21,13 @@ limitations under the License.
 #include <curl/curl.h>
 #include <curl/easy.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 namespace falco {
 namespace outputs {
 
@@ -32,11 +39,62 @@ class output_http : public abstract_output {
 	          std::string &err) override;
 	void output(const message *msg) override;
 	void cleanup() override;
+	std::vector<std::pair<std::string, uint64_t>> get_metrics() const override;
 
 private:
+	// A body that is ready to be sent, with the number of alerts it contains
+	struct batch {
+		std::string body;
+		uint64_t num_messages = 0;
+	};
+
+	// A batch being sent with one of the easy handles of m_multi
+	struct transfer {
+		CURL *curl = nullptr;
+		batch data;
+		uint8_t num_timeouts = 0;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	CURLcode setup_handle(CURL *curl);
+	void append_to_batch(const std::string &msg);
+	void seal_batch();
+	void sender() noexcept;
+	bool start_transfer(transfer &t);
+	void complete_transfer(transfer &t, CURLcode res);
+
 	CURL *m_curl;
 	struct curl_slist *m_http_headers;
 	uint8_t m_max_consecutive_timeouts;
+	std::string m_url;
+	bool m_compress_uploads;
+
+	// When batching, the alerts are accumulated into m_batch until it
+	// reaches one of the configured bounds, and the sealed batches are
+	// sent by m_sender_thread, with up to m_max_in_flight concurrent
+	// requests multiplexed on m_multi.
+	bool m_batching;
+	bool m_json_array;
+	uint64_t m_batch_max_messages;
+	uint64_t m_batch_max_bytes;
+	std::chrono::milliseconds m_batch_flush_interval;
+	size_t m_max_in_flight;
+	CURLM *m_multi;
+	std::vector<transfer> m_transfers;
+	std::mutex m_mtx;
+	std::condition_variable m_cv;
+	batch m_batch;
+	std::chrono::steady_clock::time_point m_batch_start;
+	std::deque<batch> m_sealed;
+	bool m_stop;
+	std::thread m_sender_thread;
+
+	std::atomic<uint64_t> m_num_batches = 0;
+	std::atomic<uint64_t> m_num_batched_messages = 0;
+	std::atomic<uint64_t> m_num_requests = 0;
+	std::atomic<uint64_t> m_num_request_failures = 0;
+	std::atomic<uint64_t> m_num_retries = 0;
+	std::atomic<uint64_t> m_request_latency_ns = 0;
 };
 
 }  // namespace outputs
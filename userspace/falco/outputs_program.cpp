@@ -1,6 +1,6 @@
 // SPDX-License-Identifier: Apache-2.0
 /*
-Copyright (C) 2023 The Falco Authors
+Copyright (C) 2023 The Falco Authors.
 
 Licensed under the Apache License, Version 2.0 (the "License");
 you may not use this file except in compliance with the License.
@@ -16,8 +16,71 @@ limitations under the License.
 */
 
 #include "outputs_program.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
 #include <stdio.h>
 
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+static std::string get_option(const falco::outputs::config &oc,
+                              const std::string &key,
+                              const std::string &def) {
+	auto it = oc.options.find(key);
+	return it == oc.options.end() || it->second.empty() ? def : it->second;
+}
+
+static bool add_fd_flags(int fd, int cmd_get, int cmd_set, int flags) {
+	int cur = fcntl(fd, cmd_get);
+	return cur >= 0 && fcntl(fd, cmd_set, cur | flags) == 0;
+}
+
+falco::outputs::output_program::~output_program() {
+	cleanup();
+	for(int fd : m_wake_fds) {
+		if(fd >= 0) {
+			close(fd);
+		}
+	}
+}
+
+bool falco::outputs::output_program::init(const config &oc,
+                                          bool buffered,
+                                          const std::string &hostname,
+                                          bool json_output,
+                                          std::string &err) {
+	if(!falco::outputs::abstract_output::init(oc, buffered, hostname, json_output, err)) {
+		return false;
+	}
+
+	m_keep_alive = get_option(oc, "keep_alive", "") == "true";
+	m_length_prefixed = get_option(oc, "framing", "newline") == "length_prefixed";
+	m_num_children = std::max<size_t>(1, std::stoull(get_option(oc, "num_children", "1")));
+	m_max_pending = std::stoull(get_option(oc, "max_pending", "1048576"));
+
+	if(m_keep_alive) {
+		if(pipe(m_wake_fds) != 0 ||
+		   !add_fd_flags(m_wake_fds[0], F_GETFL, F_SETFL, O_NONBLOCK) ||
+		   !add_fd_flags(m_wake_fds[1], F_GETFL, F_SETFL, O_NONBLOCK) ||
+		   !add_fd_flags(m_wake_fds[0], F_GETFD, F_SETFD, FD_CLOEXEC) ||
+		   !add_fd_flags(m_wake_fds[1], F_GETFD, F_SETFD, FD_CLOEXEC)) {
+			err = std::string("failed to create the program output pipe: ") + strerror(errno);
+			return false;
+		}
+	}
+	return true;
+}
+
 void falco::outputs::output_program::open_pfile() {
 	if(m_pfile == nullptr) {
 		m_pfile = popen(m_oc.options["program"].c_str(), "w");
@@ -28,13 +91,286 @@ void falco::outputs::output_program::open_pfile() {
 	}
 }
 
-void falco::outputs::output_program::output(const message *msg) {
-	open_pfile();
+void falco::outputs::output_program::start() {
+	m_children.resize(m_num_children);
+	for(auto &c : m_children) {
+		if(!spawn(c)) {
+			schedule_restart(c);
+		}
+	}
+	m_writer_thread = std::thread(&output_program::writer, this);
+}
+
+void falco::outputs::output_program::stop(std::unique_lock<std::mutex> &lock) {
+	if(m_writer_thread.joinable()) {
+		// Let the writer deliver the pending alerts before stopping
+		m_stop = true;
+		wake();
+		lock.unlock();
+		m_writer_thread.join();
+		lock.lock();
+		m_stop = false;
+	}
+
+	// Closing the pipes lets the children terminate
+	for(auto &c : m_children) {
+		m_num_drops += c.frames.size();
+		if(c.fd >= 0) {
+			close(c.fd);
+		}
+		if(c.pid > 0) {
+			waitpid(c.pid, nullptr, 0);
+		}
+	}
+	m_children.clear();
+	for(auto pid : m_exited) {
+		waitpid(pid, nullptr, 0);
+	}
+	m_exited.clear();
+}
+
+bool falco::outputs::output_program::spawn(child &c) {
+	c.started_at = std::chrono::steady_clock::now();
+
+	int fds[2];
+	if(pipe(fds) != 0) {
+		falco_logger::log(falco_logger::level::ERR,
+		                  std::string("Failed to create the program output pipe: ") +
+		                          strerror(errno) + "\n");
+		return false;
+	}
+	add_fd_flags(fds[0], F_GETFD, F_SETFD, FD_CLOEXEC);
+	add_fd_flags(fds[1], F_GETFD, F_SETFD, FD_CLOEXEC);
+
+	// The program is run by the shell like with popen, with the read end of
+	// the pipe as its standard input. The signal mask is reset, as the
+	// writer thread blocks SIGPIPE.
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, fds[0], STDIN_FILENO);
+	posix_spawnattr_t attr;
+	posix_spawnattr_init(&attr);
+	sigset_t mask;
+	sigemptyset(&mask);
+	posix_spawnattr_setsigmask(&attr, &mask);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+	const std::string &program = m_oc.options["program"];
+	char *argv[] = {const_cast<char *>("sh"),
+	                const_cast<char *>("-c"),
+	                const_cast<char *>(program.c_str()),
+	                nullptr};
+	int res = posix_spawn(&c.pid, "/bin/sh", &actions, &attr, argv, environ);
+	posix_spawn_file_actions_destroy(&actions);
+	posix_spawnattr_destroy(&attr);
+	close(fds[0]);
+
+	if(res != 0) {
+		close(fds[1]);
+		c.pid = -1;
+		falco_logger::log(falco_logger::level::ERR,
+		                  "Failed to start program " + program + ": " + strerror(res) + "\n");
+		return false;
+	}
+
+	add_fd_flags(fds[1], F_GETFL, F_SETFL, O_NONBLOCK);
+	c.fd = fds[1];
+	return true;
+}
+
+void falco::outputs::output_program::schedule_restart(child &c) {
+	// The backoff grows while the children keep exiting shortly after
+	// being started
+	auto now = std::chrono::steady_clock::now();
+	c.backoff = c.backoff.count() == 0 || now - c.started_at >= s_max_backoff
+	                    ? s_min_backoff
+	                    : std::min(c.backoff * 2, s_max_backoff);
+	c.restart_at = now + c.backoff;
+}
 
-	fprintf(m_pfile, "%s\n", msg->msg.c_str());
+void falco::outputs::output_program::on_child_exit(child &c) {
+	close(c.fd);
+	c.fd = -1;
+	m_exited.push_back(c.pid);
+	c.pid = -1;
 
-	if(m_oc.options["keep_alive"] != "true") {
+	// The partially written alert can't be resumed by the next child, the
+	// other pending ones are written to it
+	if(c.head_written > 0) {
+		c.offset += c.frames.front() - c.head_written;
+		c.frames.pop_front();
+		c.head_written = 0;
+		m_num_drops++;
+	}
+
+	schedule_restart(c);
+	if(!m_stop) {
+		falco_logger::log(falco_logger::level::WARNING,
+		                  "Program output child exited, restarting it in " +
+		                          std::to_string(c.backoff.count()) + "ms\n");
+	}
+}
+
+void falco::outputs::output_program::write_pending(child &c) {
+	while(c.pending_size() > 0) {
+		ssize_t n = write(c.fd, c.pending.data() + c.offset, c.pending_size());
+		if(n < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			if(errno == EAGAIN || errno == EWOULDBLOCK) {
+				m_num_pipe_full++;
+			} else {
+				on_child_exit(c);
+			}
+			return;
+		}
+
+		c.offset += n;
+		c.head_written += n;
+		while(!c.frames.empty() && c.head_written >= c.frames.front()) {
+			c.head_written -= c.frames.front();
+			c.frames.pop_front();
+		}
+	}
+	c.pending.clear();
+	c.offset = 0;
+}
+
+void falco::outputs::output_program::wake() {
+	char b = 0;
+	ssize_t res = write(m_wake_fds[1], &b, 1);
+	(void)res;
+}
+
+void falco::outputs::output_program::writer() noexcept {
+	// A child that exits makes writing to its pipe fail with EPIPE,
+	// instead of terminating the process
+	sigset_t mask;
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+	std::vector<struct pollfd> fds;
+	std::vector<size_t> polled;
+	std::chrono::steady_clock::time_point drain_deadline;
+	std::unique_lock<std::mutex> lock(m_mtx);
+	while(true) {
+		auto now = std::chrono::steady_clock::now();
+		auto reaped = [](pid_t pid) { return waitpid(pid, nullptr, WNOHANG) != 0; };
+		m_exited.erase(std::remove_if(m_exited.begin(), m_exited.end(), reaped), m_exited.end());
+
+		int timeout = -1;
+		if(m_stop) {
+			if(drain_deadline.time_since_epoch().count() == 0) {
+				drain_deadline = now + s_drain_timeout;
+			}
+			bool drained = std::all_of(m_children.begin(), m_children.end(), [](const child &c) {
+				return c.fd < 0 || c.pending_size() == 0;
+			});
+			if(drained || now >= drain_deadline) {
+				break;
+			}
+			timeout = 100;
+		}
+
+		fds.clear();
+		polled.clear();
+		fds.push_back({m_wake_fds[0], POLLIN, 0});
+		for(size_t i = 0; i < m_children.size(); i++) {
+			auto &c = m_children[i];
+			if(c.fd < 0 && !m_stop) {
+				if(c.restart_at > now) {
+					auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+					                    c.restart_at - now)
+					                    .count() +
+					            1;
+					timeout = timeout < 0 ? (int)wait : std::min(timeout, (int)wait);
+				} else if(spawn(c)) {
+					m_num_restarts++;
+				} else {
+					schedule_restart(c);
+					timeout = 0;
+				}
+			}
+			if(c.fd >= 0) {
+				// The errors are reported even when not polling for writes,
+				// so that an idle child that exits is restarted too
+				fds.push_back({c.fd, static_cast<short>(c.pending_size() > 0 ? POLLOUT : 0), 0});
+				polled.push_back(i);
+			}
+		}
+
+		lock.unlock();
+		int n = poll(fds.data(), fds.size(), timeout);
+		lock.lock();
+		if(n <= 0) {
+			continue;
+		}
+
+		if(fds[0].revents & POLLIN) {
+			char buf[64];
+			while(read(m_wake_fds[0], buf, sizeof(buf)) > 0) {
+			}
+		}
+		for(size_t k = 1; k < fds.size(); k++) {
+			auto &c = m_children[polled[k - 1]];
+			if(c.fd != fds[k].fd) {
+				continue;
+			}
+			if(fds[k].revents & POLLOUT) {
+				write_pending(c);
+			} else if(fds[k].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+				on_child_exit(c);
+			}
+		}
+	}
+}
+
+void falco::outputs::output_program::output(const message *msg) {
+	if(!m_keep_alive) {
+		open_pfile();
+		fprintf(m_pfile, "%s\n", msg->msg.c_str());
 		cleanup();
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(m_mtx);
+	if(!m_writer_thread.joinable()) {
+		start();
+	}
+
+	// The alert goes to the child with the fewest pending alerts, among the
+	// running ones if any
+	auto c = std::min_element(m_children.begin(),
+	                          m_children.end(),
+	                          [](const child &a, const child &b) {
+		                          return std::make_pair(a.fd < 0, a.pending_size()) <
+		                                 std::make_pair(b.fd < 0, b.pending_size());
+	                          });
+	size_t size = msg->msg.size() + (m_length_prefixed ? sizeof(uint32_t) : 1);
+	if(c->pending_size() + size > m_max_pending) {
+		m_num_drops++;
+		return;
+	}
+
+	bool was_empty = c->pending_size() == 0;
+	if(c->offset > 0 && c->offset >= c->pending.size() / 2) {
+		c->pending.erase(0, c->offset);
+		c->offset = 0;
+	}
+	if(m_length_prefixed) {
+		uint32_t len = htonl(static_cast<uint32_t>(msg->msg.size()));
+		c->pending.append(reinterpret_cast<const char *>(&len), sizeof(len));
+		c->pending.append(msg->msg);
+	} else {
+		c->pending.append(msg->msg);
+		c->pending.push_back('\n');
+	}
+	c->frames.push_back(size);
+
+	if(was_empty && c->fd >= 0) {
+		wake();
 	}
 }
 
@@ -43,9 +379,28 @@ void falco::outputs::output_program::cleanup() {
 		pclose(m_pfile);
 		m_pfile = nullptr;
 	}
+
+	if(m_keep_alive) {
+		std::unique_lock<std::mutex> lock(m_mtx);
+		stop(lock);
+	}
 }
 
 void falco::outputs::output_program::reopen() {
 	cleanup();
-	open_pfile();
+	if(!m_keep_alive) {
+		open_pfile();
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(m_mtx);
+	start();
+}
+
+std::vector<std::pair<std::string, uint64_t>> falco::outputs::output_program::get_metrics() const {
+	return {
+	        {"drops", m_num_drops.load()},
+	        {"pipe_full", m_num_pipe_full.load()},
+	        {"restarts", m_num_restarts.load()},
+	};
 }
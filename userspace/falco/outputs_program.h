@@ -19,20 +19,91 @@ limitations under the License.
 
 #include "outputs.h"
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <sys/types.h>
+
 namespace falco {
 namespace outputs {
 
 class output_program : public abstract_output {
+public:
+	~output_program();
+
+	bool init(const config &oc,
+	          bool buffered,
+	          const std::string &hostname,
+	          bool json_output,
+	          std::string &err) override;
+
 	void output(const message *msg) override;
 
 	void cleanup() override;
 
 	void reopen() override;
 
+	std::vector<std::pair<std::string, uint64_t>> get_metrics() const override;
+
 private:
 	void open_pfile();
 
-	FILE *m_pfile;
+	FILE *m_pfile = nullptr;
+
+	// With keep_alive, the alerts are written to the standard input of a
+	// pool of long-lived children, through non-blocking pipes. Each child
+	// has its own pending alerts, which are written by m_writer_thread
+	// whenever its pipe is writable, so that a stalled child doesn't block
+	// the outputs worker.
+	struct child {
+		pid_t pid = -1;
+		int fd = -1;
+		std::string pending;
+		size_t offset = 0;  // bytes of pending already written
+		// Sizes of the pending frames, and the bytes of the first one
+		// already written
+		std::deque<size_t> frames;
+		size_t head_written = 0;
+		std::chrono::steady_clock::time_point started_at;
+		std::chrono::steady_clock::time_point restart_at;
+		std::chrono::milliseconds backoff{0};
+
+		size_t pending_size() const { return pending.size() - offset; }
+	};
+
+	static constexpr std::chrono::milliseconds s_min_backoff{100};
+	static constexpr std::chrono::milliseconds s_max_backoff{30000};
+	static constexpr std::chrono::milliseconds s_drain_timeout{5000};
+
+	// All the following must be called with m_mtx held
+	void start();
+	void stop(std::unique_lock<std::mutex> &lock);
+	bool spawn(child &c);
+	void on_child_exit(child &c);
+	void schedule_restart(child &c);
+	void write_pending(child &c);
+	void wake();
+
+	void writer() noexcept;
+
+	bool m_keep_alive = false;
+	bool m_length_prefixed = false;
+	size_t m_num_children = 1;
+	size_t m_max_pending = 0;
+
+	std::mutex m_mtx;
+	std::vector<child> m_children;
+	std::vector<pid_t> m_exited;
+	bool m_stop = false;
+	int m_wake_fds[2] = {-1, -1};
+	std::thread m_writer_thread;
+
+	std::atomic<uint64_t> m_num_drops = 0;
+	std::atomic<uint64_t> m_num_pipe_full = 0;
+	std::atomic<uint64_t> m_num_restarts = 0;
 };
 
 }  // namespace outputs
@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include "tbb/concurrent_queue.h"
+
+namespace falco {
+namespace outputs {
+
+/*!
+    \brief A bounded multi-producer queue split into lanes, where lane 0
+    has the highest priority.
+
+    Consumers pop from the non-empty lanes by smooth weighted round-robin,
+    with a weight decreasing linearly from num_lanes for lane 0 to 1 for the
+    last lane, so that higher priority lanes are drained faster without
+    starving the other ones.
+
+    When the queue fills up, the lowest priority lanes are shed first:
+    pushing into the last lane fails once the queue is filled beyond the
+    shedding threshold, pushing into lane 0 only fails once it is full, and
+    the limits of the lanes in between are spread linearly.
+*/
+template<typename _T>
+class prioritized_queue {
+public:
+	explicit prioritized_queue(size_t num_lanes):
+	        m_lanes(num_lanes),
+	        m_limits(num_lanes, std::numeric_limits<size_t>::max()),
+	        m_credits(num_lanes, 0) {}
+
+	/*!
+	    \brief Sets the capacity of the queue, and the fraction of it
+	    above which the lowest priority lane is shed.
+	*/
+	void set_capacity(size_t capacity, double shed_threshold = 1.0) {
+		size_t last = m_lanes.size() - 1;
+		for(size_t lane = 0; lane <= last; lane++) {
+			double fraction = last == 0 ? 1.0
+			                            : shed_threshold + (1.0 - shed_threshold) *
+			                                                       (double)(last - lane) /
+			                                                       (double)last;
+			double limit = (double)capacity * fraction;
+			m_limits[lane] = limit >= (double)capacity ? capacity : (size_t)limit;
+		}
+	}
+
+	/*!
+	    \brief Pushes an item into the given lane.
+	    \return false if the queue is too full for that lane
+	*/
+	bool try_push(const _T& item, size_t lane) {
+		if(m_size.fetch_add(1) >= m_limits[lane]) {
+			m_size--;
+			return false;
+		}
+		m_lanes[lane].push(item);
+		// Each token is pushed after its item, so that a consumer that got
+		// a token is guaranteed to find an item
+		m_tokens.push(0);
+		return true;
+	}
+
+	/*!
+	    \brief Pushes an item into the given lane even if the queue is
+	    full, for the items that must never be shed.
+	*/
+	void push(const _T& item, size_t lane) {
+		m_size++;
+		m_lanes[lane].push(item);
+		m_tokens.push(0);
+	}
+
+	/*!
+	    \brief Pops an item, blocking until one is available.
+	*/
+	void pop(_T& item) {
+		char token;
+		m_tokens.pop(token);
+		take(item);
+	}
+
+	/*!
+	    \brief Pops an item, if one is available.
+	*/
+	bool try_pop(_T& item) {
+		char token;
+		if(!m_tokens.try_pop(token)) {
+			return false;
+		}
+		take(item);
+		return true;
+	}
+
+	size_t size() const { return m_size.load(); }
+
+private:
+	void take(_T& item) {
+		{
+			std::unique_lock<std::mutex> lock(m_credits_mtx);
+			size_t best = m_lanes.size();
+			int64_t total = 0;
+			for(size_t lane = 0; lane < m_lanes.size(); lane++) {
+				if(m_lanes[lane].empty()) {
+					continue;
+				}
+				int64_t weight = (int64_t)(m_lanes.size() - lane);
+				m_credits[lane] += weight;
+				total += weight;
+				if(best == m_lanes.size() || m_credits[lane] > m_credits[best]) {
+					best = lane;
+				}
+			}
+			if(best != m_lanes.size() && m_lanes[best].try_pop(item)) {
+				m_credits[best] -= total;
+				m_size--;
+				return;
+			}
+		}
+
+		// Another consumer emptied the lane in the meantime, but the
+		// token guarantees that an item is left in another one
+		while(true) {
+			for(auto& lane : m_lanes) {
+				if(lane.try_pop(item)) {
+					m_size--;
+					return;
+				}
+			}
+		}
+	}
+
+	std::vector<tbb::concurrent_queue<_T>> m_lanes;
+	std::vector<size_t> m_limits;
+	tbb::concurrent_bounded_queue<char> m_tokens;
+	std::atomic<size_t> m_size = 0;
+	std::mutex m_credits_mtx;
+	std::vector<int64_t> m_credits;
+};
+
+}  // namespace outputs
+}  // namespace falco
@@ -0,0 +1,288 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "outputs_spool.h"
+#include "falco_common.h"
+#include "logger.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static const char *s_segment_ext = ".seg";
+static const char *s_checkpoint_file = "checkpoint";
+
+// Reads the length of the record at the given offset of the segment, or
+// returns false if there is no complete record there
+static bool record_at(const char *data, size_t size, size_t offset, uint32_t &len) {
+	if(offset + sizeof(len) > size) {
+		return false;
+	}
+	memcpy(&len, data + offset, sizeof(len));
+	return len != 0 && offset + sizeof(len) + len <= size;
+}
+
+falco::outputs::spool::spool(const std::string &directory, size_t segment_size, size_t max_size):
+        m_directory(directory),
+        m_segment_size(segment_size),
+        m_max_size(max_size) {
+	std::error_code ec;
+	fs::create_directories(m_directory, ec);
+	if(ec) {
+		throw falco_exception("failed to create spool directory " + m_directory + ": " +
+		                      ec.message());
+	}
+	recover();
+}
+
+falco::outputs::spool::~spool() {
+	sync();
+	checkpoint();
+	while(!m_mapped.empty()) {
+		unmap_segment(m_mapped.begin()->first);
+	}
+}
+
+std::string falco::outputs::spool::segment_path(uint64_t seq) const {
+	// Zero-padded, so that the segments sort in order
+	char name[32];
+	snprintf(name, sizeof(name), "%020llu", (unsigned long long)seq);
+	return m_directory + "/" + name + s_segment_ext;
+}
+
+falco::outputs::spool::segment &falco::outputs::spool::map_segment(uint64_t seq, bool create) {
+	auto it = m_mapped.find(seq);
+	if(it != m_mapped.end()) {
+		return it->second;
+	}
+
+	auto path = segment_path(seq);
+	int fd = open(path.c_str(), O_RDWR | (create ? O_CREAT : 0), 0600);
+	if(fd < 0) {
+		throw falco_exception("failed to open spool segment " + path + ": " + strerror(errno));
+	}
+
+	// Segments keep the size they were created with, even if the
+	// configured one changed since
+	struct stat st;
+	if(fstat(fd, &st) != 0) {
+		std::string err = strerror(errno);
+		close(fd);
+		throw falco_exception("failed to size spool segment " + path + ": " + err);
+	}
+
+	// The blocks are reserved upfront, since writing through the mapping
+	// to a sparse file raises SIGBUS once the disk is full
+	if(st.st_size == 0) {
+		int res = posix_fallocate(fd, 0, static_cast<off_t>(m_segment_size));
+		if(res != 0) {
+			close(fd);
+			unlink(path.c_str());
+			throw falco_exception("failed to allocate spool segment " + path + ": " +
+			                      strerror(res));
+		}
+	}
+	size_t size = st.st_size == 0 ? m_segment_size : static_cast<size_t>(st.st_size);
+
+	void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED) {
+		throw falco_exception("failed to map spool segment " + path + ": " + strerror(errno));
+	}
+
+	auto &s = m_mapped[seq];
+	s.data = static_cast<char *>(data);
+	s.size = size;
+	return s;
+}
+
+void falco::outputs::spool::unmap_segment(uint64_t seq) {
+	auto it = m_mapped.find(seq);
+	if(it != m_mapped.end()) {
+		munmap(it->second.data, it->second.size);
+		m_mapped.erase(it);
+	}
+}
+
+void falco::outputs::spool::recover() {
+	std::set<uint64_t> seqs;
+	for(const auto &entry : fs::directory_iterator(m_directory)) {
+		auto stem = entry.path().stem().string();
+		if(entry.path().extension() == s_segment_ext && !stem.empty() &&
+		   stem.find_first_not_of("0123456789") == std::string::npos) {
+			seqs.insert(std::stoull(stem));
+		}
+	}
+
+	if(seqs.empty()) {
+		m_stats.bytes += map_segment(0, true).size;
+		return;
+	}
+
+	// Resume from the checkpoint, unless its segment is gone
+	m_read_seq = *seqs.begin();
+	std::ifstream cp(m_directory + "/" + s_checkpoint_file);
+	uint64_t cp_seq;
+	size_t cp_offset;
+	if(cp >> cp_seq >> cp_offset && seqs.count(cp_seq) > 0) {
+		m_read_seq = cp_seq;
+		m_read_offset = cp_offset;
+	}
+	m_write_seq = *seqs.rbegin();
+
+	for(auto seq : seqs) {
+		if(seq < m_read_seq) {
+			fs::remove(segment_path(seq));
+			continue;
+		}
+
+		auto &s = map_segment(seq, false);
+		m_stats.bytes += s.size;
+		size_t offset = seq == m_read_seq ? m_read_offset : 0;
+		uint32_t len;
+		while(record_at(s.data, s.size, offset, len)) {
+			offset += sizeof(len) + len;
+			m_stats.depth++;
+		}
+		if(seq == m_write_seq) {
+			m_write_offset = offset;
+		} else if(seq != m_read_seq) {
+			unmap_segment(seq);
+		}
+	}
+}
+
+bool falco::outputs::spool::push(const std::string &record) {
+	if(record.empty() || record.size() > std::numeric_limits<uint32_t>::max() ||
+	   sizeof(uint32_t) + record.size() > m_segment_size) {
+		return false;
+	}
+	uint32_t len = static_cast<uint32_t>(record.size());
+
+	segment *s;
+	try {
+		s = &map_segment(m_write_seq, true);
+		if(m_write_offset + sizeof(len) + len > s->size) {
+			if(m_stats.bytes + m_segment_size > m_max_size) {
+				return false;
+			}
+			auto &next = map_segment(m_write_seq + 1, true);
+			if(m_write_seq != m_read_seq) {
+				unmap_segment(m_write_seq);
+			}
+			m_write_seq++;
+			m_write_offset = 0;
+			s = &next;
+			m_stats.bytes += s->size;
+		}
+	} catch(const falco_exception &) {
+		// Typically, the disk is full
+		return false;
+	}
+
+	// The length is written last, so that the record is only seen once
+	// complete
+	memcpy(s->data + m_write_offset + sizeof(len), record.data(), len);
+	memcpy(s->data + m_write_offset, &len, sizeof(len));
+	m_write_offset += sizeof(len) + len;
+	m_stats.depth++;
+	return true;
+}
+
+bool falco::outputs::spool::pop(std::string &record) {
+	while(m_stats.depth > 0) {
+		auto &s = map_segment(m_read_seq, false);
+		uint32_t len;
+		if(record_at(s.data, s.size, m_read_offset, len)) {
+			record.assign(s.data + m_read_offset + sizeof(len), len);
+			m_read_offset += sizeof(len) + len;
+			m_stats.depth--;
+			m_stats.drained++;
+			if(++m_pops_since_checkpoint >= s_checkpoint_interval) {
+				m_checkpoint_due = true;
+			}
+			return true;
+		}
+
+		if(m_read_seq == m_write_seq) {
+			break;
+		}
+
+		// The segment is fully read
+		m_stats.bytes -= s.size;
+		unmap_segment(m_read_seq);
+		m_read_segments.push_back(m_read_seq);
+		m_read_seq++;
+		m_read_offset = 0;
+		m_checkpoint_due = true;
+	}
+	return false;
+}
+
+void falco::outputs::spool::sync() {
+	std::error_code ec;
+	for(auto seq : m_read_segments) {
+		fs::remove(segment_path(seq), ec);
+	}
+	m_read_segments.clear();
+	if(m_checkpoint_due) {
+		checkpoint();
+	}
+}
+
+void falco::outputs::spool::checkpoint() {
+	// Replaced atomically, so that a crash never leaves a partial one
+	auto path = m_directory + "/" + s_checkpoint_file;
+	{
+		std::ofstream cp(path + ".tmp", std::ios::trunc);
+		cp << m_read_seq << " " << m_read_offset << "\n";
+		if(!cp.good()) {
+			checkpoint_failed(strerror(errno));
+			return;
+		}
+	}
+	std::error_code ec;
+	fs::rename(path + ".tmp", path, ec);
+	if(ec) {
+		// Still due, so that the next sync() retries it
+		checkpoint_failed(ec.message());
+		return;
+	}
+	m_checkpoint_failed = false;
+	m_pops_since_checkpoint = 0;
+	m_checkpoint_due = false;
+}
+
+void falco::outputs::spool::checkpoint_failed(const std::string &reason) {
+	// Only the first failure of a row is logged, since sync() retries it
+	// after every record
+	if(!m_checkpoint_failed) {
+		falco_logger::log(falco_logger::level::ERR,
+		                  "Failed to checkpoint output spool " + m_directory + ": " + reason +
+		                          "\n");
+	}
+	m_checkpoint_failed = true;
+}
@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2025 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace falco {
+namespace outputs {
+
+struct spool_config {
+	bool enabled = false;
+	std::string directory;
+	std::set<std::string> outputs;
+	size_t segment_size = 0;
+	size_t max_size = 0;
+};
+
+/*!
+    \brief An append-only FIFO of records persisted in a directory, used
+    to buffer the alerts of an output that can't keep up with them.
+
+    The records are appended to fixed-size segment files that are memory
+    mapped, so that writing them costs about as much as a memory copy, and
+    each segment is deleted once all its records have been read. The read
+    position is checkpointed to the directory from time to time and when
+    the spool is closed, and a spool opened on an existing directory
+    resumes from there. The records read after the last checkpoint are
+    read again after a crash.
+
+    Within a segment, each record is stored as its 32-bit length followed
+    by its bytes. The length is written last, and a zero length marks the
+    end of the records written so far.
+
+    This class is not thread-safe.
+*/
+class spool {
+public:
+	struct stats {
+		uint64_t depth = 0;    // number of records not yet read
+		uint64_t bytes = 0;    // disk space used by the segments
+		uint64_t drained = 0;  // number of records read so far
+	};
+
+	/*!
+	    \brief Opens the spool in the given directory, creating it if
+	    needed. Throws a falco_exception on failure.
+	    \param segment_size size of each segment file, in bytes
+	    \param max_size maximum disk space used by the segment files
+	*/
+	spool(const std::string& directory, size_t segment_size, size_t max_size);
+	~spool();
+
+	spool(const spool&) = delete;
+	spool& operator=(const spool&) = delete;
+
+	/*!
+	    \brief Appends a record.
+	    \return false if the record doesn't fit in the spool, or if the
+	    segment it belongs to can't be allocated on disk
+	*/
+	bool push(const std::string& record);
+
+	/*!
+	    \brief Reads and removes the oldest record. The segments fully read
+	    are only deleted, and the read position only persisted, by the next
+	    call to sync().
+	    \return false if the spool is empty
+	*/
+	bool pop(std::string& record);
+
+	/*!
+	    \brief Deletes the segments fully read so far, and persists the
+	    read position when due. This only accesses the state updated by
+	    pop(), so it can run outside of the lock serializing push() and
+	    pop(), as long as it is called by the thread calling pop().
+	*/
+	void sync();
+
+	bool empty() const { return m_stats.depth == 0; }
+
+	const stats& get_stats() const { return m_stats; }
+
+	/*!
+	    \brief Persists the current read position.
+	*/
+	void checkpoint();
+
+private:
+	struct segment {
+		char* data = nullptr;
+		size_t size = 0;
+	};
+
+	static constexpr uint32_t s_checkpoint_interval = 1024;
+
+	std::string segment_path(uint64_t seq) const;
+	segment& map_segment(uint64_t seq, bool create);
+	void unmap_segment(uint64_t seq);
+	void recover();
+	void checkpoint_failed(const std::string& reason);
+
+	std::string m_directory;
+	size_t m_segment_size;
+	size_t m_max_size;
+
+	// The segments between m_read_seq and m_write_seq are on disk, but only
+	// those two are mapped
+	std::map<uint64_t, segment> m_mapped;
+	uint64_t m_read_seq = 0;
+	size_t m_read_offset = 0;
+	uint64_t m_write_seq = 0;
+	size_t m_write_offset = 0;
+	uint32_t m_pops_since_checkpoint = 0;
+
+	// Left for sync() by pop()
+	std::vector<uint64_t> m_read_segments;
+	bool m_checkpoint_due = false;
+	bool m_checkpoint_failed = false;
+
+	stats m_stats;
+};
+
+}  // namespace outputs
+}  // namespace falco
@@ -369,6 +369,54 @@ void stats_writer::collector::get_metrics_output_fields_wrapper(
 	}
 	output_fields["falco.outputs_queue_num_drops"] =
 	        m_writer->m_outputs->get_outputs_queue_num_drops();
+	for(const auto& [priority, num_drops] :
+	    m_writer->m_outputs->get_outputs_queue_num_drops_by_priority()) {
+		output_fields["falco.outputs_queue_num_drops_by_priority." + priority] = num_drops;
+	}
+	for(const auto& [rule, num_drops] :
+	    m_writer->m_outputs->get_outputs_queue_num_drops_by_rule()) {
+		output_fields["falco.outputs_queue_num_drops_by_rule." +
+		              falco::utils::sanitize_rule_name(rule)] = num_drops;
+	}
+	output_fields["falco.outputs_rate_limited_alerts"] =
+	        m_writer->m_outputs->get_num_rate_limited_alerts();
+	output_fields["falco.outputs_deduplicated_alerts"] =
+	        m_writer->m_outputs->get_num_deduplicated_alerts();
+	for(const auto& [output, num_drops] : m_writer->m_outputs->get_outputs_num_drops()) {
+		output_fields["falco.outputs_num_drops." + output] = num_drops;
+	}
+	for(const auto& [name, value] : m_writer->m_outputs->get_outputs_metrics()) {
+		output_fields["falco.outputs." + name] = value;
+	}
+	for(const auto& [output, spool_stats] : m_writer->m_outputs->get_outputs_spool_stats()) {
+		output_fields["falco.outputs_spool_depth." + output] = spool_stats.depth;
+		output_fields["falco.outputs_spool_bytes." + output] = spool_stats.bytes;
+		output_fields["falco.outputs_spool_drained." + output] = spool_stats.drained;
+		auto last_drained = m_last_spool_drained.find(output);
+		if(last_drained != m_last_spool_drained.end() && stats_snapshot_time_delta_sec > 0) {
+			output_fields["falco.outputs_spool_drain_rate_sec." + output] =
+			        std::round((double)((spool_stats.drained - last_drained->second) /
+			                            (double)stats_snapshot_time_delta_sec) *
+			                   10.0) /
+			        10.0;  // round to 1 decimal
+		}
+		m_last_spool_drained[output] = spool_stats.drained;
+	}
+	output_fields["falco.formatter_cache_hits"] = m_writer->m_engine->get_formatter_cache_hits();
+	output_fields["falco.formatter_cache_misses"] =
+	        m_writer->m_engine->get_formatter_cache_misses();
+	if(m_writer->m_config->m_rule_evaluation_adaptive_ordering.enabled) {
+		auto ordering_stats = m_writer->m_engine->get_adaptive_rule_ordering_stats();
+		output_fields["falco.rules.adaptive_reorders"] = ordering_stats.num_reorders;
+		output_fields["falco.rules.adaptive_estimated_saved_ns"] =
+		        ordering_stats.estimated_saved_ns;
+	}
+
+	if(m_writer->m_config->m_rule_evaluation_field_extraction_cache_enabled) {
+		auto cache_metrics = m_writer->m_engine->get_filter_cache_metrics();
+		output_fields["falco.rules.field_extractions"] = cache_metrics.m_num_extract;
+		output_fields["falco.rules.field_extractions_cached"] = cache_metrics.m_num_extract_cache;
+	}
 
 #if defined(__linux__) and !defined(MINIMAL_BUILD) and !defined(__EMSCRIPTEN__)
 	for(const auto& item : m_writer->m_config->m_loaded_rules_filenames_sha256sum) {
@@ -435,6 +483,22 @@ void stats_writer::collector::get_metrics_output_fields_additional(
 			        "falco.rules." + falco::utils::sanitize_rule_name(rule->name);
 			output_fields[rules_metric_name] = rule_count;
 		}
+
+		// sampled evaluation cost of each rule, the histogram is only
+		// exposed through the Prometheus endpoint
+		if(m_writer->m_config->m_rule_evaluation_profiling_enabled) {
+			const auto& profiles = rule_stats_manager.get_profile_by_rule_id();
+			for(size_t i = 0; i < profiles.size(); i++) {
+				auto num_evals = profiles[i]->num_evals.load();
+				if(num_evals == 0 && !m_writer->m_config->m_metrics_include_empty_values) {
+					continue;
+				}
+				auto rule_name = falco::utils::sanitize_rule_name(rules.at(i)->name);
+				output_fields["falco.rules.evaluations." + rule_name] = num_evals;
+				output_fields["falco.rules.evaluation_ns." + rule_name] =
+				        profiles[i]->total_ns.load();
+			}
+		}
 	}
 
 #ifdef HAS_JEMALLOC
@@ -90,6 +90,7 @@ public:
 		uint64_t m_last_n_evts = 0;
 		uint64_t m_last_n_drops = 0;
 		uint64_t m_last_num_evts = 0;
+		std::unordered_map<std::string, uint64_t> m_last_spool_drained;
 	};
 
 	stats_writer(const stats_writer&) = delete;
@@ -89,6 +89,7 @@ void falco_webserver::start(const falco::app::state &state,
 }
 
 void falco_webserver::stop() {
+	stop_prometheus_metrics();
 	if(m_running) {
 		if(m_server != nullptr) {
 			m_server->stop();
@@ -104,9 +105,67 @@ void falco_webserver::stop() {
 void falco_webserver::enable_prometheus_metrics(const falco::app::state &state) {
 	if(state.config->m_metrics_enabled &&
 	   state.config->m_webserver_config.m_prometheus_metrics_enabled) {
-		m_server->Get("/metrics", [&state](const httplib::Request &, httplib::Response &res) {
-			res.set_content(falco_metrics::to_text_prometheus(state),
-			                falco_metrics::content_type_prometheus);
+		if(m_metrics_thread.joinable()) {
+			return;
+		}
+
+		bool gzip = state.config->m_webserver_config.m_prometheus_metrics_gzip_enabled;
+		auto interval = std::chrono::milliseconds(state.config->m_metrics_interval);
+		m_metrics_snapshot = falco_metrics::to_prometheus_snapshot(state, gzip);
+		m_metrics_stop = false;
+		m_metrics_thread = std::thread([this, &state, gzip, interval] {
+			std::unique_lock<std::mutex> lock(m_metrics_mtx);
+			while(!m_metrics_cv.wait_for(lock, interval, [this] { return m_metrics_stop; })) {
+				lock.unlock();
+				std::shared_ptr<const falco_metrics::prometheus_snapshot> snapshot;
+				try {
+					snapshot = falco_metrics::to_prometheus_snapshot(state, gzip);
+				} catch(std::exception &e) {
+					falco_logger::log(falco_logger::level::ERR,
+					                  "falco_webserver: " + std::string(e.what()) + "\n");
+				}
+				lock.lock();
+				if(snapshot) {
+					m_metrics_snapshot.swap(snapshot);
+				}
+			}
+		});
+
+		m_server->Get("/metrics", [this](const httplib::Request &req, httplib::Response &res) {
+			std::shared_ptr<const falco_metrics::prometheus_snapshot> snapshot;
+			{
+				std::unique_lock<std::mutex> lock(m_metrics_mtx);
+				snapshot = m_metrics_snapshot;
+			}
+
+			// The ETag is the one of the representation that is served
+			bool gzip = !snapshot->text_gzip.empty() &&
+			            req.get_header_value("Accept-Encoding").find("gzip") != std::string::npos;
+			const auto &etag = gzip ? snapshot->etag_gzip : snapshot->etag;
+			res.set_header("ETag", etag);
+			res.set_header("Vary", "Accept-Encoding");
+			if(req.get_header_value("If-None-Match").find(etag) != std::string::npos) {
+				res.status = httplib::StatusCode::NotModified_304;
+				return;
+			}
+			if(gzip) {
+				res.set_header("Content-Encoding", "gzip");
+				res.set_content(snapshot->text_gzip, falco_metrics::content_type_prometheus);
+				return;
+			}
+			res.set_content(snapshot->text, falco_metrics::content_type_prometheus);
 		});
 	}
 }
+
+void falco_webserver::stop_prometheus_metrics() {
+	if(!m_metrics_thread.joinable()) {
+		return;
+	}
+	{
+		std::unique_lock<std::mutex> lock(m_metrics_mtx);
+		m_metrics_stop = true;
+	}
+	m_metrics_cv.notify_all();
+	m_metrics_thread.join();
+}
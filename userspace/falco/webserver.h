@@ -22,9 +22,13 @@ limitations under the License.
 
 #include <httplib.h>
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <thread>
 
+#include "falco_metrics.h"
+
 namespace falco::app {
 struct state;
 }
@@ -43,8 +47,18 @@ public:
 	virtual void enable_prometheus_metrics(const falco::app::state& state);
 
 private:
+	void stop_prometheus_metrics();
+
 	bool m_running = false;
 	std::unique_ptr<httplib::Server> m_server = nullptr;
 	std::thread m_server_thread;
 	std::atomic<bool> m_failed;
+
+	// The Prometheus metrics are rendered once per metrics interval by
+	// m_metrics_thread, and every request is served from the latest snapshot
+	std::thread m_metrics_thread;
+	std::mutex m_metrics_mtx;
+	std::condition_variable m_metrics_cv;
+	bool m_metrics_stop = false;
+	std::shared_ptr<const falco_metrics::prometheus_snapshot> m_metrics_snapshot;
 };